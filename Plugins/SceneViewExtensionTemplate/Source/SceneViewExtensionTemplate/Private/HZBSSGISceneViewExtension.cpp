@@ -2,109 +2,1642 @@
 #include "PixelShaderUtils.h"
 #include "SystemTextures.h"
 #include "PostProcess/PostProcessMaterialInputs.h"
+#include "PostProcess/PostProcessInputs.h"
+#include "FXRenderingUtils.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+#include <atomic>
+
+DEFINE_LOG_CATEGORY(LogHZBSSGI);
+
+DECLARE_STATS_GROUP(TEXT("HZBSSGI"), STATGROUP_HZBSSGI, STATCAT_Advanced);
+DECLARE_MEMORY_STAT(TEXT("HZB Memory (Per View)"), STAT_HZBSSGI_HZBMemory, STATGROUP_HZBSSGI);
+DECLARE_MEMORY_STAT(TEXT("HZB Memory Saved (Per View)"), STAT_HZBSSGI_HZBMemorySaved, STATGROUP_HZBSSGI);
+DECLARE_MEMORY_STAT(TEXT("Persistent Memory (Per View)"), STAT_HZBSSGI_PersistentMemory, STATGROUP_HZBSSGI);
+DECLARE_MEMORY_STAT(TEXT("Color Chain Memory (Per View)"), STAT_HZBSSGI_ColorChainMemory, STATGROUP_HZBSSGI);
+DECLARE_MEMORY_STAT(TEXT("Persistent Memory (All Views)"), STAT_HZBSSGI_PersistentMemoryTotal, STATGROUP_HZBSSGI);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Persistent Views"), STAT_HZBSSGI_PersistentViews, STATGROUP_HZBSSGI);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Rays Traced"), STAT_HZBSSGI_RaysTraced, STATGROUP_HZBSSGI);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Hit Rate"), STAT_HZBSSGI_HitRate, STATGROUP_HZBSSGI);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Average Iterations"), STAT_HZBSSGI_AverageIterations, STATGROUP_HZBSSGI);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Budget GPU Time (ms)"), STAT_HZBSSGI_BudgetGPUTime, STATGROUP_HZBSSGI);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Budget Level"), STAT_HZBSSGI_BudgetLevel, STATGROUP_HZBSSGI);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Budget Resolution Divisor"), STAT_HZBSSGI_BudgetResolutionDivisor, STATGROUP_HZBSSGI);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Budget Max Iterations"), STAT_HZBSSGI_BudgetMaxIterations, STATGROUP_HZBSSGI);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Budget Rays Per Pixel"), STAT_HZBSSGI_BudgetSampleCount, STATGROUP_HZBSSGI);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Budget Denoiser Iterations"), STAT_HZBSSGI_BudgetDenoiserIterations, STATGROUP_HZBSSGI);
+
+// 渲染线程上构建RDG的CPU耗时
+DECLARE_CYCLE_STAT(TEXT("Process Pass (Render Thread)"), STAT_HZBSSGI_ProcessPass, STATGROUP_HZBSSGI);
+DECLARE_CYCLE_STAT(TEXT("Trace Setup (Render Thread)"), STAT_HZBSSGI_TraceSetup, STATGROUP_HZBSSGI);
+DECLARE_CYCLE_STAT(TEXT("HZB Setup (Render Thread)"), STAT_HZBSSGI_HZBSetup, STATGROUP_HZBSSGI);
+
+// stat gpu 和 CSV 中每个Pass的GPU耗时
+DECLARE_GPU_STAT(HZBSSGI_HZBBuild);
+DECLARE_GPU_STAT(HZBSSGI_GBufferDecode);
+DECLARE_GPU_STAT(HZBSSGI_TileClassify);
+DECLARE_GPU_STAT(HZBSSGI_RadianceCache);
+DECLARE_GPU_STAT(HZBSSGI_IrradianceCache);
+DECLARE_GPU_STAT(HZBSSGI_Trace);
+DECLARE_GPU_STAT(HZBSSGI_Upsample);
+DECLARE_GPU_STAT(HZBSSGI_Denoise);
+DECLARE_GPU_STAT(HZBSSGI_Temporal);
+DECLARE_GPU_STAT(HZBSSGI_Composite);
+
+CSV_DEFINE_CATEGORY(HZBSSGI, true);
 
 IMPLEMENT_GLOBAL_SHADER(FHZBBuildCS, "/Plugins/SceneViewExtensionTemplate/HZB.usf", "HZBBuildCS", SF_Compute);
+IMPLEMENT_GLOBAL_SHADER(FSSGIGBufferDecodeCS, "/Plugins/SceneViewExtensionTemplate/SSGIGBufferDecode.usf", "GBufferDecodeCS", SF_Compute);
+IMPLEMENT_GLOBAL_SHADER(FSSGIRadianceCacheInitCS, "/Plugins/SceneViewExtensionTemplate/SSGIRadianceCache.usf", "RadianceCacheInitCS", SF_Compute);
+IMPLEMENT_GLOBAL_SHADER(FSSGIRadianceCacheDownsampleCS, "/Plugins/SceneViewExtensionTemplate/SSGIRadianceCache.usf", "RadianceCacheDownsampleCS", SF_Compute);
+IMPLEMENT_GLOBAL_SHADER(FSSGIIrradianceProbeUpdateCS, "/Plugins/SceneViewExtensionTemplate/SSGIIrradianceCache.usf", "IrradianceProbeUpdateCS", SF_Compute);
 IMPLEMENT_GLOBAL_SHADER(FSSGICS, "/Plugins/SceneViewExtensionTemplate/SSGI.usf", "SSGICS", SF_Compute);
+IMPLEMENT_GLOBAL_SHADER(FSSGIRayGenCS, "/Plugins/SceneViewExtensionTemplate/SSGISortedTrace.usf", "SSGIRayGenCS", SF_Compute);
+IMPLEMENT_GLOBAL_SHADER(FSSGIBinPrefixSumCS, "/Plugins/SceneViewExtensionTemplate/SSGISortedTrace.usf", "SSGIBinPrefixSumCS", SF_Compute);
+IMPLEMENT_GLOBAL_SHADER(FSSGIRayScatterCS, "/Plugins/SceneViewExtensionTemplate/SSGISortedTrace.usf", "SSGIRayScatterCS", SF_Compute);
+IMPLEMENT_GLOBAL_SHADER(FSSGISortedTraceCS, "/Plugins/SceneViewExtensionTemplate/SSGISortedTrace.usf", "SSGISortedTraceCS", SF_Compute);
+IMPLEMENT_GLOBAL_SHADER(FSSGIPersistentTraceCS, "/Plugins/SceneViewExtensionTemplate/SSGISortedTrace.usf", "SSGIPersistentTraceCS", SF_Compute);
+IMPLEMENT_GLOBAL_SHADER(FSSGIRayResolveCS, "/Plugins/SceneViewExtensionTemplate/SSGISortedTrace.usf", "SSGIRayResolveCS", SF_Compute);
+IMPLEMENT_GLOBAL_SHADER(FSSGIUpsampleCS, "/Plugins/SceneViewExtensionTemplate/SSGIUpsample.usf", "UpsampleCS", SF_Compute);
 IMPLEMENT_GLOBAL_SHADER(FSSGICompositeCS, "/Plugins/SceneViewExtensionTemplate/SSGIComposite.usf", "CompositeCS", SF_Compute);
 IMPLEMENT_GLOBAL_SHADER(FSSGIDenoiserCS, "/Plugins/SceneViewExtensionTemplate/SSGIDenoiser.usf", "DenoiserCS", SF_Compute);
 IMPLEMENT_GLOBAL_SHADER(FSSGITemporalCS, "/Plugins/SceneViewExtensionTemplate/SSGITemporal.usf", "TemporalCS", SF_Compute);
+IMPLEMENT_GLOBAL_SHADER(FSSGITileClassifyCS, "/Plugins/SceneViewExtensionTemplate/SSGITileClassify.usf", "TileClassifyCS", SF_Compute);
+IMPLEMENT_GLOBAL_SHADER(FSSGITileDispatchArgsCS, "/Plugins/SceneViewExtensionTemplate/SSGITileClassify.usf", "TileDispatchArgsCS", SF_Compute);
+IMPLEMENT_GLOBAL_SHADER(FSSGITileClearCS, "/Plugins/SceneViewExtensionTemplate/SSGITileClassify.usf", "TileClearCS", SF_Compute);
 
 namespace
 {
 	TAutoConsoleVariable<int32> CVarHZBSSGIOn(
 		TEXT("r.HZBSSGI"), 0, TEXT("Enable HZB SSGI SceneViewExtension"), ECVF_RenderThreadSafe);
 	TAutoConsoleVariable<int32> CVarSSGIDebug(
-		TEXT("r.HZBSSGI.Debug"), 0, TEXT("Debug mode for SSGI"), ECVF_RenderThreadSafe);
+		TEXT("r.HZBSSGI.Debug"), 0,
+		TEXT("Debug mode for SSGI\n")
+		TEXT("1: raw trace output\n")
+		TEXT("2: denoised output\n")
+		TEXT("3: rays per pixel heatmap (compiles the debug trace permutation)\n")
+		TEXT("4: HiZ trace iterations per ray heatmap\n")
+		TEXT("5: hit rate (red = miss, green = hit)"),
+		ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<int32> CVarSSGIStats(
+		TEXT("r.HZBSSGI.Stats"), 0,
+		TEXT("Read back rays traced, hit rate and average HiZ iterations from the GPU (a few frames late)\n")
+		TEXT("and report them in stat HZBSSGI and the HZBSSGI CSV category. Uses the debug trace permutation."),
+		ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<int32> CVarSSGIAsyncCompute(
+		TEXT("r.HZBSSGI.AsyncCompute"), 0,
+		TEXT("Run the HZB build, trace, upsample and denoise passes on the async compute queue.\n")
+		TEXT("They are added before post processing and joined before the temporal pass.\n")
+		TEXT("Falls back to the graphics queue when the RHI has no efficient async compute."),
+		ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<int32> CVarSSGISortedTrace(
+		TEXT("r.HZBSSGI.SortedTrace"), 0,
+		TEXT("Generate the SSGI rays into a buffer, bin them by start tile and screen-space direction octant,\n")
+		TEXT("and trace them in binned order so each wave walks the HZB coherently. Pays off at high sample counts.\n")
+		TEXT("Ignored when the debug trace permutation is needed (r.HZBSSGI.Debug >= 3 or r.HZBSSGI.Stats)."),
+		ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<int32> CVarSSGIPersistentTrace(
+		TEXT("r.HZBSSGI.PersistentTrace"), 1,
+		TEXT("Trace the sorted rays with persistent threads: a fixed number of groups pull rays from a global queue\n")
+		TEXT("and lanes that finish early take new rays, so a wave is not held up by its longest ray.\n")
+		TEXT("Only used with r.HZBSSGI.SortedTrace on RHIs that support wave operations; otherwise the one-ray-per-thread kernel is used."),
+		ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<int32> CVarSSGIPersistentTraceGroups(
+		TEXT("r.HZBSSGI.PersistentTrace.Groups"), 512,
+		TEXT("Number of 64-thread groups launched by the persistent trace. Should be enough to fill the GPU once, more only adds queue traffic."),
+		ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<int32> CVarSSGISamplingMode(
+		TEXT("r.HZBSSGI.SamplingMode"), 1,
+		TEXT("Random numbers for the hemisphere samples.\n")
+		TEXT(" 0: per-pixel hashed LCG (white noise)\n")
+		TEXT(" 1: R2 low-discrepancy sequence over frames and rays, rotated per pixel by blue noise (default)"),
+		ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<int32> CVarSSGICompactFormats(
+		TEXT("r.HZBSSGI.CompactFormats"), 1,
+		TEXT("Store the raw, upsampled and denoised SSGI and the temporal history as R11G11B10F (32 bpp) instead of RGBA16F (64 bpp).\n")
+		TEXT("The luminance first and second moments stay in RG16F and the accumulation count in R8 either way.\n")
+		TEXT("Falls back to RGBA16F when the platform cannot write R11G11B10F through a typed UAV."),
+		ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<int32> CVarSSGIFusedComposite(
+		TEXT("r.HZBSSGI.FusedComposite"), 1,
+		TEXT("Composite SSGI in the temporal pass and write the lit result straight into the post process output.\n")
+		TEXT("Skips the scene color copy and the separate composite pass. Debug views always use the separate composite."),
+		ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<int32> CVarSSGITileClassification(
+		TEXT("r.HZBSSGI.TileClassification"), 1,
+		TEXT("Classify tiles from the decoded depth and shading model and run the trace, upsample, denoise and\n")
+		TEXT("temporal passes through DispatchIndirect only on tiles with lit pixels. Sky/unlit tiles are cleared."),
+		ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<int32> CVarHZBCompact(
+		TEXT("r.HZBSSGI.HZB.Compact"), 0,
+		TEXT("0: HZB matches the SceneDepth buffer extent\n")
+		TEXT("1: HZB only covers the ViewRect, sized to a power of two"),
+		ECVF_Scalability | ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<int32> CVarSSGIMultiViewBatch(
+		TEXT("r.HZBSSGI.MultiView.Batch"), 1,
+		TEXT("For view families with several views (stereo, split-screen) build a single HZB over the union of all view\n")
+		TEXT("rects of the shared scene depth and reuse it for every view, instead of one HZB build per view.\n")
+		TEXT("All views are traced together before post processing, and the upsample and denoise passes of up to four views\n")
+		TEXT("run as one dispatch each (view index in the group Z, per-view tile lists). The trace and temporal passes stay per view."),
+		ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<int32> CVarHZBHalfPrecision(
+		TEXT("r.HZBSSGI.HZB.HalfPrecision"), 0,
+		TEXT("Store the compact HZB as R16F (depth is rounded up conservatively)"),
+		ECVF_Scalability | ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<int32> CVarSSGIResolutionDivisor(
+		TEXT("r.HZBSSGI.ResolutionDivisor"), 1,
+		TEXT("Trace resolution divisor: 1 = full, 2 = half, 4 = quarter resolution.\n")
+		TEXT("Reduced traces are upsampled with a depth/normal aware filter before the denoiser."),
+		ECVF_Scalability | ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<int32> CVarSSGIDenoiserIterations(
+		TEXT("r.HZBSSGI.Denoiser.Iterations"), 3,
+		TEXT("Number of A-Trous denoiser iterations (0-4). Iteration i uses a 3x3 kernel with step 2^i,\n")
+		TEXT("so 3 iterations cover a radius of 7 pixels."),
+		ECVF_Scalability | ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<int32> CVarSSGISamplesPerPixel(
+		TEXT("r.HZBSSGI.SamplesPerPixel"), 1,
+		TEXT("Rays per pixel when the adaptive ray budget is disabled (rounded up to 1, 2, 4 or 8)."),
+		ECVF_Scalability | ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<int32> CVarSSGIThreadGroupSize(
+		TEXT("r.HZBSSGI.ThreadGroupSize"), -1,
+		TEXT("Thread group size of the trace, denoise and temporal passes.\n")
+		TEXT("-1: per pass default (16x16 for the denoiser, 8x8 otherwise)\n")
+		TEXT("0: 8x8\n")
+		TEXT("1: 16x16\n")
+		TEXT("2: 8x4 (the denoiser falls back to 8x8)"),
+		ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<int32> CVarSSGIRadianceCache(
+		TEXT("r.HZBSSGI.RadianceCache"), 1,
+		TEXT("Shade hits from a prefiltered half resolution mip chain of scene color plus the reprojected SSGI of the\n")
+		TEXT("previous frame. The mip is picked from the ray footprint at the hit. 0 point samples scene color at mip 0."),
+		ECVF_Scalability | ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<float> CVarSSGIRadianceCacheMultiBounce(
+		TEXT("r.HZBSSGI.RadianceCache.MultiBounce"), 1.0f,
+		TEXT("Weight of the previous frame's SSGI in the radiance cache (0 = single bounce, 1 = full multi-bounce)."),
+		ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<float> CVarSSGIRadianceCacheFootprintScale(
+		TEXT("r.HZBSSGI.RadianceCache.FootprintScale"), 0.25f,
+		TEXT("Ray footprint in pixels per pixel of screen space hit distance at 1 ray per pixel.\n")
+		TEXT("Divided by the square root of the rays per pixel. Higher values blur distant hits more."),
+		ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<int32> CVarSSGIIrradianceCache(
+		TEXT("r.HZBSSGI.IrradianceCache"), 1,
+		TEXT("Fall back to a low resolution world space irradiance probe grid around the camera for rays that miss\n")
+		TEXT("or leave the screen. Probes are traced from the radiance cache a few at a time. 0 = misses contribute black."),
+		ECVF_Scalability | ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<float> CVarSSGIIrradianceCacheCellSize(
+		TEXT("r.HZBSSGI.IrradianceCache.CellSize"), 200.0f,
+		TEXT("Probe spacing in world units. The grid covers 32x32x16 cells around the camera."),
+		ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<int32> CVarSSGIIrradianceCacheUpdateBudget(
+		TEXT("r.HZBSSGI.IrradianceCache.UpdateBudget"), 256,
+		TEXT("Probes updated per frame (64 rays each), cycled round-robin over the grid."),
+		ECVF_Scalability | ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<float> CVarSSGIIrradianceCacheMaxSamples(
+		TEXT("r.HZBSSGI.IrradianceCache.MaxSamples"), 16.0f,
+		TEXT("Max number of updates a probe accumulates. Lower values react faster to lighting changes."),
+		ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<int32> CVarSSGITemporalKernelRadius(
+		TEXT("r.HZBSSGI.Temporal.KernelRadius"), 2,
+		TEXT("Neighborhood radius of the temporal history clamp: 1 = 3x3, 2 = 5x5."),
+		ECVF_Scalability | ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<float> CVarSSGITemporalMaxAccumulation(
+		TEXT("r.HZBSSGI.Temporal.MaxAccumulation"), 32.0f,
+		TEXT("Max number of frames accumulated in the temporal history. Lower values react faster but are noisier.\n")
+		TEXT("Clamped to 255, the count is stored in an R8 target."),
+		ECVF_Scalability | ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<int32> CVarSSGIMaxIterations(
+		TEXT("r.HZBSSGI.MaxIterations"), 64,
+		TEXT("Max HiZ traversal steps per ray."),
+		ECVF_Scalability | ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<float> CVarSSGIThickness(
+		TEXT("r.HZBSSGI.Thickness"), 10.0f,
+		TEXT("Assumed thickness of depth buffer surfaces (world units) for hit testing."),
+		ECVF_Scalability | ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<float> CVarSSGIRayLength(
+		TEXT("r.HZBSSGI.RayLength"), 100.0f,
+		TEXT("Max ray length in world units."),
+		ECVF_Scalability | ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<int32> CVarSSGIAdaptive(
+		TEXT("r.HZBSSGI.Adaptive"), 1,
+		TEXT("Adapt the per-pixel ray budget to the temporal accumulation count and variance."),
+		ECVF_Scalability | ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<int32> CVarSSGIAdaptiveMaxSamples(
+		TEXT("r.HZBSSGI.Adaptive.MaxSamples"), 4,
+		TEXT("Max rays per pixel for disoccluded or high-variance pixels (rounded up to 1, 2, 4 or 8)."),
+		ECVF_Scalability | ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<float> CVarSSGIAdaptiveConvergedCount(
+		TEXT("r.HZBSSGI.Adaptive.ConvergedCount"), 24.0f,
+		TEXT("Accumulated frame count at which a low-variance pixel counts as converged."),
+		ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<int32> CVarSSGIAdaptiveSkipInterval(
+		TEXT("r.HZBSSGI.Adaptive.SkipInterval"), 4,
+		TEXT("Converged pixels are only traced every Nth frame and reuse history otherwise."),
+		ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<float> CVarSSGIAdaptiveVarianceThreshold(
+		TEXT("r.HZBSSGI.Adaptive.VarianceThreshold"), 0.5f,
+		TEXT("Relative luminance standard deviation above which a pixel gets extra rays."),
+		ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<float> CVarSSGIBudgetTargetMs(
+		TEXT("r.HZBSSGI.Budget.TargetMs"), 0.0f,
+		TEXT("GPU time target for SSGI in milliseconds, summed over all views of a frame. 0 disables the governor.\n")
+		TEXT("The measured time is read back a few frames late. When it stays above the target, the governor steps down\n")
+		TEXT("a quality ladder (iterations, rays per pixel, trace resolution, denoiser iterations) from the configured\n")
+		TEXT("settings, and steps back up when there is headroom. It never exceeds the configured settings.\n")
+		TEXT("With async compute the measured span on the graphics queue also covers overlapped work."),
+		ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<float> CVarSSGIBudgetHysteresis(
+		TEXT("r.HZBSSGI.Budget.Hysteresis"), 0.15f,
+		TEXT("Relative dead band around the budget target. The governor steps down above target * (1 + h) and up below\n")
+		TEXT("target * (1 - h), and only if the cost last measured at the higher quality level fit the target."),
+		ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<int32> CVarSSGIHistoryMaxViews(
+		TEXT("r.HZBSSGI.History.MaxViews"), 8,
+		TEXT("Max number of views that keep persistent SSGI history; the least recently used view is evicted first."),
+		ECVF_RenderThreadSafe);
+	TAutoConsoleVariable<int32> CVarSSGIHistoryMaxIdleFrames(
+		TEXT("r.HZBSSGI.History.MaxIdleFrames"), 120,
+		TEXT("Persistent SSGI history of a view that has not rendered for this many frames is released."),
+		ECVF_RenderThreadSafe);
+
+	// 追踪和降噪共用的GI强度，降噪按它放宽颜色权重
+	constexpr float kSSGIIntensity = 1.0f;
+
+	// 光线数的Permutation只有1,2,4,8
+	int32 GetSampleCountPermutation(int32 SampleCount)
+	{
+		return FMath::Min<int32>(FMath::RoundUpToPowerOfTwo(FMath::Max(SampleCount, 1)), 8);
+	}
+
+	// 预算控制器当前的档位，渲染线程写入，GetSSGIQualitySettings在任意线程读取
+	std::atomic<int32> GSSGIBudgetLevel{ 0 };
+	// 每个档位至少测量这么多帧才会再次调整，读回的延迟和平滑都需要时间
+	constexpr int32 kSSGIBudgetMinFramesPerLevel = 4;
+	// 超过这么多帧的档位耗时视为过期，场景变化后可以重新尝试更高的质量
+	constexpr uint32 kSSGIBudgetCostMaxAge = 120;
+
+	// 受sg.GlobalIlluminationQuality控制的开销参数，在这里统一截断和取整，渲染和DumpSettings看到的是同一组值
+	struct FSSGIQualitySettings
+	{
+		bool bCompactHZB;
+		bool bHalfPrecisionHZB;
+		int32 ResolutionDivisor;
+		int32 MaxIterations;
+		float Thickness;
+		float RayLength;
+		bool bAdaptiveRayBudget;
+		int32 SampleCount;
+		bool bRadianceCache;
+		bool bIrradianceCache;
+		int32 IrradianceUpdateBudget;
+		int32 DenoiserIterations;
+		int32 TemporalKernelRadius;
+		float TemporalMaxAccumulation;
+	};
+
+	FSSGIQualitySettings GetSSGIQualitySettings()
+	{
+		FSSGIQualitySettings Settings;
+		Settings.bCompactHZB = CVarHZBCompact.GetValueOnAnyThread() != 0;
+		Settings.bHalfPrecisionHZB = Settings.bCompactHZB && CVarHZBHalfPrecision.GetValueOnAnyThread() != 0;
+		const int32 ResolutionDivisor = CVarSSGIResolutionDivisor.GetValueOnAnyThread();
+		Settings.ResolutionDivisor = ResolutionDivisor >= 4 ? 4 : (ResolutionDivisor >= 2 ? 2 : 1);
+		Settings.MaxIterations = FMath::Clamp(CVarSSGIMaxIterations.GetValueOnAnyThread(), 1, 256);
+		Settings.Thickness = FMath::Max(CVarSSGIThickness.GetValueOnAnyThread(), 0.0f);
+		Settings.RayLength = FMath::Max(CVarSSGIRayLength.GetValueOnAnyThread(), 1.0f);
+		Settings.bAdaptiveRayBudget = CVarSSGIAdaptive.GetValueOnAnyThread() != 0;
+		Settings.SampleCount = GetSampleCountPermutation(Settings.bAdaptiveRayBudget ? CVarSSGIAdaptiveMaxSamples.GetValueOnAnyThread() : CVarSSGISamplesPerPixel.GetValueOnAnyThread());
+		Settings.bRadianceCache = CVarSSGIRadianceCache.GetValueOnAnyThread() != 0;
+		Settings.bIrradianceCache = CVarSSGIIrradianceCache.GetValueOnAnyThread() != 0;
+		Settings.IrradianceUpdateBudget = FMath::Clamp(CVarSSGIIrradianceCacheUpdateBudget.GetValueOnAnyThread(), 1,
+			kSSGIIrradianceGridSizeXY * kSSGIIrradianceGridSizeXY * kSSGIIrradianceGridSizeZ);
+		Settings.DenoiserIterations = FMath::Clamp(CVarSSGIDenoiserIterations.GetValueOnAnyThread(), 0, kDenoiserMaxIterations);
+		Settings.TemporalKernelRadius = FMath::Clamp(CVarSSGITemporalKernelRadius.GetValueOnAnyThread(), 1, 2);
+		// 累积计数以整数帧存在R8 unorm里，最多255帧
+		Settings.TemporalMaxAccumulation = FMath::Clamp(FMath::RoundToFloat(CVarSSGITemporalMaxAccumulation.GetValueOnAnyThread()), 1.0f, 255.0f);
+
+		// 预算控制器的档位，在配置的质量上逐级降低，每档大致减少10%~25%的追踪开销
+		const int32 BudgetLevel = GSSGIBudgetLevel.load(std::memory_order_relaxed);
+		if (BudgetLevel >= 1)
+		{
+			Settings.MaxIterations = FMath::Max(Settings.MaxIterations * 3 / 4, 8);
+		}
+		if (BudgetLevel >= 2)
+		{
+			Settings.SampleCount = FMath::Max(Settings.SampleCount / 2, 1);
+		}
+		if (BudgetLevel >= 3)
+		{
+			Settings.ResolutionDivisor = FMath::Min(Settings.ResolutionDivisor * 2, 4);
+		}
+		if (BudgetLevel >= 4)
+		{
+			Settings.MaxIterations = FMath::Max(Settings.MaxIterations * 2 / 3, 8);
+			Settings.DenoiserIterations = FMath::Min(Settings.DenoiserIterations, FMath::Max(Settings.DenoiserIterations - 1, 1));
+		}
+		if (BudgetLevel >= 5)
+		{
+			Settings.ResolutionDivisor = FMath::Min(Settings.ResolutionDivisor * 2, 4);
+		}
+		if (BudgetLevel >= 6)
+		{
+			Settings.SampleCount = 1;
+			Settings.MaxIterations = FMath::Max(Settings.MaxIterations / 2, 8);
+		}
+		return Settings;
+	}
+
+	// 在图形队列上写入时间戳
+	void AddTimestampPass(FRDGBuilder& GraphBuilder, FRHIRenderQuery* Query)
+	{
+		GraphBuilder.AddPass(RDG_EVENT_NAME("SSGI Timestamp"), ERDGPassFlags::NeverCull, [Query](FRHICommandListImmediate& RHICmdList)
+		{
+			RHICmdList.EndRenderQuery(Query);
+		});
+	}
+
+	// SSGI颜色链（追踪、上采样、降噪、Temporal历史）的格式
+	EPixelFormat GetSSGIColorFormat()
+	{
+		const bool bCompact = CVarSSGICompactFormats.GetValueOnAnyThread() != 0
+			&& UE::PixelFormat::HasCapabilities(PF_FloatR11G11B10, EPixelFormatCapabilities::TypedUAVStore);
+		return bCompact ? PF_FloatR11G11B10 : PF_FloatRGBA;
+	}
+
+	uint64 GetSSGITextureBytes(const FRDGTextureDesc& Desc)
+	{
+		return uint64(Desc.Extent.X) * Desc.Extent.Y * GPixelFormats[Desc.Format].BlockBytes;
+	}
+
+	// 持久线程追踪需要Wave指令，运行时不支持时退回每线程一条光线的Kernel
+	bool UseSSGIPersistentTrace()
+	{
+		return CVarSSGIPersistentTrace.GetValueOnAnyThread() != 0 && GRHISupportsWaveOperations && RHISupportsWaveOperations(GMaxRHIShaderPlatform);
+	}
+
+	FAutoConsoleCommandWithOutputDevice CmdSSGIDumpSettings(
+		TEXT("r.HZBSSGI.DumpSettings"),
+		TEXT("Print the effective HZB SSGI settings after clamping, together with the active sg.GlobalIlluminationQuality."),
+		FConsoleCommandWithOutputDeviceDelegate::CreateStatic([](FOutputDevice& Ar)
+		{
+			const IConsoleVariable* GIQualityCVar = IConsoleManager::Get().FindConsoleVariable(TEXT("sg.GlobalIlluminationQuality"));
+			const FSSGIQualitySettings Settings = GetSSGIQualitySettings();
+			Ar.Logf(TEXT("HZB SSGI: %s, sg.GlobalIlluminationQuality = %d"),
+				CVarHZBSSGIOn.GetValueOnAnyThread() != 0 ? TEXT("enabled") : TEXT("disabled"),
+				GIQualityCVar ? GIQualityCVar->GetInt() : -1);
+			Ar.Logf(TEXT("  HZB: %s, %s, %s"),
+				Settings.bCompactHZB ? TEXT("compact") : TEXT("full extent"),
+				Settings.bHalfPrecisionHZB ? TEXT("R16F") : TEXT("R32F"),
+				CVarSSGIMultiViewBatch.GetValueOnAnyThread() != 0 ? TEXT("shared by all views of a family, upsample and denoise batched per 4 views") : TEXT("per view"));
+			Ar.Logf(TEXT("  Trace: 1/%d resolution, %d rays per pixel (%s), %d iterations, thickness %.2f, ray length %.2f"),
+				Settings.ResolutionDivisor, Settings.SampleCount,
+				Settings.bAdaptiveRayBudget ? TEXT("adaptive max") : TEXT("fixed"),
+				Settings.MaxIterations, Settings.Thickness, Settings.RayLength);
+			if (CVarSSGISortedTrace.GetValueOnAnyThread() != 0)
+			{
+				Ar.Logf(TEXT("  Trace order: sorted by tile and direction, %s"),
+					UseSSGIPersistentTrace() ? TEXT("persistent threads") : TEXT("one ray per thread"));
+			}
+			else
+			{
+				Ar.Logf(TEXT("  Trace order: per pixel"));
+			}
+			Ar.Logf(TEXT("  Hit shading: %s"),
+				Settings.bRadianceCache ? TEXT("prefiltered radiance cache") : TEXT("scene color mip 0"));
+			if (Settings.bIrradianceCache)
+			{
+				Ar.Logf(TEXT("  Miss fallback: irradiance probes, %d updated per frame"), Settings.IrradianceUpdateBudget);
+			}
+			else
+			{
+				Ar.Logf(TEXT("  Miss fallback: none"));
+			}
+			Ar.Logf(TEXT("  Color chain: %s"), GetSSGIColorFormat() == PF_FloatR11G11B10 ? TEXT("R11G11B10F") : TEXT("RGBA16F"));
+			Ar.Logf(TEXT("  Denoiser: %d iterations (radius %d)"),
+				Settings.DenoiserIterations, (1 << Settings.DenoiserIterations) - 1);
+			Ar.Logf(TEXT("  Temporal: %dx%d neighborhood, max %.0f frames"),
+				Settings.TemporalKernelRadius * 2 + 1, Settings.TemporalKernelRadius * 2 + 1, Settings.TemporalMaxAccumulation);
+			const float BudgetTargetMs = CVarSSGIBudgetTargetMs.GetValueOnAnyThread();
+			if (BudgetTargetMs > 0.0f)
+			{
+				Ar.Logf(TEXT("  Budget: target %.2f ms, level %d of %d (settings above include it)"),
+					BudgetTargetMs, GSSGIBudgetLevel.load(std::memory_order_relaxed), kSSGIBudgetLevelCount - 1);
+			}
+			else
+			{
+				Ar.Logf(TEXT("  Budget: disabled"));
+			}
+		}));
+
+	// 历史纹理的尺寸按64对齐，动态分辨率或窗口微调时沿用已有的纹理，避免重新分配
+	// 已有纹理比需要的大太多（面积超过2倍）时才缩小
+	FIntPoint GetHistoryExtent(FIntPoint CurrentExtent, FIntPoint ViewSize)
+	{
+		const FIntPoint QuantizedExtent(FMath::DivideAndRoundUp(ViewSize.X, 64) * 64, FMath::DivideAndRoundUp(ViewSize.Y, 64) * 64);
+		const bool bFits = CurrentExtent.X >= ViewSize.X && CurrentExtent.Y >= ViewSize.Y;
+		const bool bTooLarge = int64(CurrentExtent.X) * CurrentExtent.Y > 2 * int64(QuantizedExtent.X) * QuantizedExtent.Y;
+		return (bFits && !bTooLarge) ? CurrentExtent : QuantizedExtent;
+	}
+
+	// 线程组尺寸的Permutation，-1时使用各Pass的默认值
+	ESSGIThreadGroupSize GetThreadGroupSizePermutation(ESSGIThreadGroupSize PassDefault)
+	{
+		const int32 GroupSize = CVarSSGIThreadGroupSize.GetValueOnRenderThread();
+		if (GroupSize < 0 || GroupSize >= int32(ESSGIThreadGroupSize::MAX))
+		{
+			return PassDefault;
+		}
+		return static_cast<ESSGIThreadGroupSize>(GroupSize);
+	}
+
+	// 渲染线程上每个View都要用到、只随CVar和预算档位变化的设置和Permutation选择
+	// TShaderMapRef不缓存：Shader重新编译后ShaderMap会被替换
+	struct FSSGIViewSettings
+	{
+		FSSGIQualitySettings Quality;
+		EPixelFormat ColorFormat;
+		// 逐像素Pass（追踪、Temporal）和降噪的线程组尺寸
+		ESSGIThreadGroupSize ThreadGroupSize;
+		ESSGIThreadGroupSize DenoiseGroupSize;
+		int32 DebugMode;
+		bool bTraceStats;
+		// 调试输出和统计计数只在r.HZBSSGI.Debug >= 3或r.HZBSSGI.Stats时编译进来
+		bool bDebugPermutation;
+		// 排序追踪没有调试Permutation，需要调试输出时退回逐像素追踪
+		bool bSortedTrace;
+		bool bTileClassification;
+		bool bMultiViewBatch;
+		// 调试视图要选择Temporal之前的中间结果，只能走单独的Composite
+		bool bFusedComposite;
+		// 逐像素追踪的Permutation
+		FSSGICS::FPermutationDomain TracePermutation;
+	};
+
+	// 只在渲染线程访问。CVar变化后由Sink通过渲染命令递增，排在CVar渲染线程值的更新之后
+	uint32 GSSGISettingsGeneration = 1;
+	FAutoConsoleVariableSink CVarSinkSSGIViewSettings(FConsoleCommandDelegate::CreateStatic([]()
+	{
+		ENQUEUE_RENDER_COMMAND(InvalidateSSGIViewSettings)([](FRHICommandListImmediate&)
+		{
+			GSSGISettingsGeneration++;
+		});
+	}));
+
+	const FSSGIViewSettings& GetSSGIViewSettings()
+	{
+		check(IsInRenderingThread());
+		static FSSGIViewSettings Settings;
+		static uint32 CachedGeneration = 0;
+		static int32 CachedBudgetLevel = -1;
+		const int32 BudgetLevel = GSSGIBudgetLevel.load(std::memory_order_relaxed);
+		if (CachedGeneration == GSSGISettingsGeneration && CachedBudgetLevel == BudgetLevel)
+		{
+			return Settings;
+		}
+		CachedGeneration = GSSGISettingsGeneration;
+		CachedBudgetLevel = BudgetLevel;
+
+		Settings.Quality = GetSSGIQualitySettings();
+		Settings.ColorFormat = GetSSGIColorFormat();
+		Settings.ThreadGroupSize = GetThreadGroupSizePermutation(ESSGIThreadGroupSize::Size8x8);
+		// 默认16x16，groupshared中Apron的额外读取占比更小
+		FSSGIDenoiserCS::FPermutationDomain DenoiserPermutation;
+		DenoiserPermutation.Set<FSSGIThreadGroupSizeDim>(GetThreadGroupSizePermutation(ESSGIThreadGroupSize::Size16x16));
+		Settings.DenoiseGroupSize = FSSGIDenoiserCS::RemapPermutation(DenoiserPermutation).Get<FSSGIThreadGroupSizeDim>();
+		Settings.DebugMode = CVarSSGIDebug.GetValueOnRenderThread();
+		Settings.bTraceStats = CVarSSGIStats.GetValueOnRenderThread() != 0;
+		Settings.bDebugPermutation = Settings.DebugMode >= 3 || Settings.bTraceStats;
+		Settings.bSortedTrace = CVarSSGISortedTrace.GetValueOnRenderThread() != 0 && !Settings.bDebugPermutation;
+		Settings.bTileClassification = CVarSSGITileClassification.GetValueOnRenderThread() != 0;
+		Settings.bMultiViewBatch = CVarSSGIMultiViewBatch.GetValueOnRenderThread() != 0;
+		Settings.bFusedComposite = CVarSSGIFusedComposite.GetValueOnRenderThread() != 0 && Settings.DebugMode == 0;
+
+		Settings.TracePermutation = FSSGICS::FPermutationDomain();
+		Settings.TracePermutation.Set<FSSGICS::FSampleCountDim>(Settings.Quality.SampleCount);
+		Settings.TracePermutation.Set<FSSGICS::FAdaptiveRayBudgetDim>(Settings.Quality.bAdaptiveRayBudget);
+		Settings.TracePermutation.Set<FSSGIThreadGroupSizeDim>(Settings.ThreadGroupSize);
+		Settings.TracePermutation.Set<FSSGICS::FDebugDim>(Settings.bDebugPermutation);
+		Settings.TracePermutation.Set<FSSGITiledDispatchDim>(Settings.bTileClassification);
+		Settings.TracePermutation = FSSGICS::RemapPermutation(Settings.TracePermutation);
+		return Settings;
+	}
+
+	// 降分辨率追踪时块内追踪像素的位置，按Bayer顺序轮换，让Temporal累积覆盖整个块
+	FIntPoint GetTraceOffset(int32 ResolutionDivisor, uint32 FrameIndex)
+	{
+		static const FIntPoint Pattern2x2[4] = { FIntPoint(0, 0), FIntPoint(1, 1), FIntPoint(1, 0), FIntPoint(0, 1) };
+		if (ResolutionDivisor == 2)
+		{
+			return Pattern2x2[FrameIndex % 4];
+		}
+		if (ResolutionDivisor == 4)
+		{
+			return Pattern2x2[FrameIndex % 4] * 2 + Pattern2x2[(FrameIndex / 4) % 4];
+		}
+		return FIntPoint::ZeroValue;
+	}
+
+	// HZB整条Mip链占用的显存
+	uint64 GetHZBMemorySize(FIntPoint Mip0Size, int32 NumMips, uint32 BytesPerTexel)
+	{
+		uint64 TotalBytes = 0;
+		for (int32 MipLevel = 0; MipLevel < NumMips; MipLevel++)
+		{
+			const uint64 MipX = FMath::Max(Mip0Size.X >> MipLevel, 1);
+			const uint64 MipY = FMath::Max(Mip0Size.Y >> MipLevel, 1);
+			TotalBytes += MipX * MipY * BytesPerTexel;
+		}
+		return TotalBytes;
+	}
+
+	// 按相干性排序的追踪：生成光线并分桶 -> 前缀和 -> 排序 -> 追踪 -> 逐像素累加，各步骤见SSGISortedTrace.usf
+	void AddSortedTracePasses(FRDGBuilder& GraphBuilder, const FSSGITraceCommonParameters& TraceCommon, FRDGTextureRef SSGIOutputTexture, FRDGTextureRef SkipMaskTexture, int32 SampleCount, bool bAdaptiveRayBudget, ERDGPassFlags PassFlags)
+	{
+		const bool bPersistentTrace = UseSSGIPersistentTrace();
+		const FIntPoint TraceSize = TraceCommon.TraceSize;
+		const FIntPoint NumTiles(FMath::DivideAndRoundUp(TraceSize.X, kSSGISortedTraceTileSize), FMath::DivideAndRoundUp(TraceSize.Y, kSSGISortedTraceTileSize));
+		const uint32 NumBins = NumTiles.X * NumTiles.Y * kSSGISortedTraceOctantCount;
+		const uint32 NumPixels = TraceSize.X * TraceSize.Y;
+		const uint32 NumRays = NumPixels * SampleCount;
+
+		// 光线只记录桶和桶内偏移，追踪时重新生成，每条光线8字节
+		FRDGBufferRef RayBins = GraphBuilder.CreateBuffer(FRDGBufferDesc::CreateBufferDesc(sizeof(uint32) * 2, NumRays), TEXT("SSGI SortedTrace RayBins"));
+		FRDGBufferRef BinCounts = GraphBuilder.CreateBuffer(FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), NumBins), TEXT("SSGI SortedTrace BinCounts"));
+		// 最后一个元素是有效光线总数
+		FRDGBufferRef BinOffsets = GraphBuilder.CreateBuffer(FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), NumBins + 1), TEXT("SSGI SortedTrace BinOffsets"));
+		FRDGBufferRef PixelRayCount = GraphBuilder.CreateBuffer(FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), NumPixels), TEXT("SSGI SortedTrace PixelRayCount"));
+		FRDGBufferRef SortedRayIndices = GraphBuilder.CreateBuffer(FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), NumRays), TEXT("SSGI SortedTrace RayIndices"));
+		// 命中颜色已经做过FireFly截断，用half存储
+		FRDGBufferRef RayResults = GraphBuilder.CreateBuffer(FRDGBufferDesc::CreateBufferDesc(sizeof(FFloat16Color), NumRays), TEXT("SSGI SortedTrace RayResults"));
+		FRDGBufferRef SortedTraceArgs = GraphBuilder.CreateBuffer(FRDGBufferDesc::CreateIndirectDesc<FRHIDispatchIndirectParameters>(1), TEXT("SSGI SortedTrace IndirectArgs"));
+		FRDGTextureUAVRef OutputUAV = GraphBuilder.CreateUAV(SSGIOutputTexture);
+		const FIntVector PixelGroupCount(FMath::DivideAndRoundUp(TraceSize.X, 8), FMath::DivideAndRoundUp(TraceSize.Y, 8), 1);
+
+		FRDGBufferUAVRef BinCountsUAV = GraphBuilder.CreateUAV(BinCounts, PF_R32_UINT);
+		AddClearUAVPass(GraphBuilder, BinCountsUAV, 0u, PassFlags);
+
+		{
+			FSSGIRayGenCS::FPermutationDomain PermutationVector;
+			PermutationVector.Set<FSSGICS::FSampleCountDim>(SampleCount);
+			PermutationVector.Set<FSSGICS::FAdaptiveRayBudgetDim>(bAdaptiveRayBudget);
+			TShaderMapRef<FSSGIRayGenCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel), PermutationVector);
+			FSSGIRayGenCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FSSGIRayGenCS::FParameters>();
+			PassParameters->Common = TraceCommon;
+			PassParameters->NumTilesX = NumTiles.X;
+			PassParameters->RWRayBins = GraphBuilder.CreateUAV(RayBins, PF_R32G32_UINT);
+			PassParameters->RWBinCounts = BinCountsUAV;
+			PassParameters->RWPixelRayCount = GraphBuilder.CreateUAV(PixelRayCount, PF_R32_UINT);
+			PassParameters->RWRayResults = GraphBuilder.CreateUAV(RayResults, PF_FloatRGBA);
+			PassParameters->SSGI_Raw_Output = OutputUAV;
+			PassParameters->RWSSGISkipMask = SkipMaskTexture ? GraphBuilder.CreateUAV(SkipMaskTexture) : nullptr;
+			FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("SSGI RayGen %dx%d", TraceSize.X, TraceSize.Y), PassFlags, ComputeShader, PassParameters, PixelGroupCount);
+		}
+
+		{
+			TShaderMapRef<FSSGIBinPrefixSumCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel));
+			FSSGIBinPrefixSumCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FSSGIBinPrefixSumCS::FParameters>();
+			PassParameters->BinCounts = GraphBuilder.CreateSRV(BinCounts, PF_R32_UINT);
+			PassParameters->RWBinOffsets = GraphBuilder.CreateUAV(BinOffsets, PF_R32_UINT);
+			PassParameters->RWSortedTraceArgs = GraphBuilder.CreateUAV(SortedTraceArgs, PF_R32_UINT);
+			PassParameters->NumBins = NumBins;
+			FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("SSGI Bin PrefixSum (%d Bins)", NumBins), PassFlags, ComputeShader, PassParameters, FIntVector(1, 1, 1));
+		}
+
+		{
+			TShaderMapRef<FSSGIRayScatterCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel));
+			FSSGIRayScatterCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FSSGIRayScatterCS::FParameters>();
+			PassParameters->RayBins = GraphBuilder.CreateSRV(RayBins, PF_R32G32_UINT);
+			PassParameters->BinOffsets = GraphBuilder.CreateSRV(BinOffsets, PF_R32_UINT);
+			PassParameters->PixelRayCount = GraphBuilder.CreateSRV(PixelRayCount, PF_R32_UINT);
+			PassParameters->RWSortedRayIndices = GraphBuilder.CreateUAV(SortedRayIndices, PF_R32_UINT);
+			PassParameters->NumRays = NumRays;
+			PassParameters->RaySlotsPerPixel = SampleCount;
+			const int32 NumGroups = FMath::DivideAndRoundUp<int32>(NumRays, kSSGISortedTraceThreads);
+			FIntVector GroupCount(FMath::Min(NumGroups, kSSGISortedTraceGroupWrap), FMath::DivideAndRoundUp(NumGroups, kSSGISortedTraceGroupWrap), 1);
+			FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("SSGI Ray Scatter"), PassFlags, ComputeShader, PassParameters, GroupCount);
+		}
+
+		if (bPersistentTrace)
+		{
+			FRDGBufferRef RayQueueCounter = GraphBuilder.CreateBuffer(FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), 1), TEXT("SSGI PersistentTrace QueueCounter"));
+			FRDGBufferUAVRef RayQueueCounterUAV = GraphBuilder.CreateUAV(RayQueueCounter, PF_R32_UINT);
+			AddClearUAVPass(GraphBuilder, RayQueueCounterUAV, 0u, PassFlags);
+
+			TShaderMapRef<FSSGIPersistentTraceCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel));
+			FSSGIPersistentTraceCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FSSGIPersistentTraceCS::FParameters>();
+			PassParameters->Common = TraceCommon;
+			PassParameters->BinOffsets = GraphBuilder.CreateSRV(BinOffsets, PF_R32_UINT);
+			PassParameters->SortedRayIndices = GraphBuilder.CreateSRV(SortedRayIndices, PF_R32_UINT);
+			PassParameters->RWRayResults = GraphBuilder.CreateUAV(RayResults, PF_FloatRGBA);
+			PassParameters->RWRayQueueCounter = RayQueueCounterUAV;
+			PassParameters->NumBins = NumBins;
+			PassParameters->RaySlotsPerPixel = SampleCount;
+			// 有效光线数只在GPU上知道，按光线槽数限制线程组数，多余的线程组取不到光线直接退出
+			const int32 NumGroups = FMath::Clamp(CVarSSGIPersistentTraceGroups.GetValueOnRenderThread(), 1, FMath::DivideAndRoundUp<int32>(NumRays, kSSGISortedTraceThreads));
+			FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("SSGI Persistent Trace (%d Groups)", NumGroups), PassFlags, ComputeShader, PassParameters, FIntVector(NumGroups, 1, 1));
+		}
+		else
+		{
+			TShaderMapRef<FSSGISortedTraceCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel));
+			FSSGISortedTraceCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FSSGISortedTraceCS::FParameters>();
+			PassParameters->Common = TraceCommon;
+			PassParameters->BinOffsets = GraphBuilder.CreateSRV(BinOffsets, PF_R32_UINT);
+			PassParameters->SortedRayIndices = GraphBuilder.CreateSRV(SortedRayIndices, PF_R32_UINT);
+			PassParameters->RWRayResults = GraphBuilder.CreateUAV(RayResults, PF_FloatRGBA);
+			PassParameters->NumBins = NumBins;
+			PassParameters->RaySlotsPerPixel = SampleCount;
+			PassParameters->IndirectArgs = SortedTraceArgs;
+			// 线程组数等于有效光线数，由前缀和Pass写出
+			FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("SSGI Sorted Trace"), PassFlags, ComputeShader, PassParameters, SortedTraceArgs, 0);
+		}
+
+		{
+			TShaderMapRef<FSSGIRayResolveCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel));
+			FSSGIRayResolveCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FSSGIRayResolveCS::FParameters>();
+			PassParameters->Common = TraceCommon;
+			PassParameters->PixelRayCount = GraphBuilder.CreateSRV(PixelRayCount, PF_R32_UINT);
+			PassParameters->RayResults = GraphBuilder.CreateSRV(RayResults, PF_FloatRGBA);
+			PassParameters->RaySlotsPerPixel = SampleCount;
+			PassParameters->SSGI_Raw_Output = OutputUAV;
+			FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("SSGI Ray Resolve"), PassFlags, ComputeShader, PassParameters, PixelGroupCount);
+		}
+	}
+
+	// Tile分类：网格坐标 -> View像素为 Pos * Divisor + Offset，与使用它的Pass的像素映射一致
+	FSSGITileClassification AddTileClassificationPasses(FRDGBuilder& GraphBuilder, FRDGTextureRef SSGIGBufferTexture, const FVector4f& ViewSizeAndInvSize, FIntPoint GridSize, int32 Divisor, FIntPoint Offset, ESSGIThreadGroupSize GroupSize, ERDGPassFlags PassFlags)
+	{
+		RDG_GPU_STAT_SCOPE(GraphBuilder, HZBSSGI_TileClassify);
+		const FIntPoint TileSize = GetSSGIThreadGroupSize(GroupSize);
+		const FIntPoint TileCount(FMath::DivideAndRoundUp(GridSize.X, TileSize.X), FMath::DivideAndRoundUp(GridSize.Y, TileSize.Y));
+
+		FSSGITileClassification Tiles;
+		Tiles.GroupSize = GroupSize;
+		Tiles.GridSize = GridSize;
+		Tiles.NumTiles = TileCount.X * TileCount.Y;
+		Tiles.TileList = GraphBuilder.CreateBuffer(FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), Tiles.NumTiles), TEXT("SSGI TileList"));
+		Tiles.TileCounts = GraphBuilder.CreateBuffer(FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), 2), TEXT("SSGI TileCounts"));
+		Tiles.DispatchArgs = GraphBuilder.CreateBuffer(FRDGBufferDesc::CreateIndirectDesc<FRHIDispatchIndirectParameters>(2), TEXT("SSGI TileDispatchArgs"));
+
+		FRDGBufferUAVRef TileCountsUAV = GraphBuilder.CreateUAV(Tiles.TileCounts, PF_R32_UINT);
+		AddClearUAVPass(GraphBuilder, TileCountsUAV, 0u, PassFlags);
+
+		{
+			TShaderMapRef<FSSGITileClassifyCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel));
+			FSSGITileClassifyCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FSSGITileClassifyCS::FParameters>();
+			PassParameters->SSGIGBufferTexture = SSGIGBufferTexture;
+			PassParameters->ViewSizeAndInvSize = ViewSizeAndInvSize;
+			PassParameters->GridSize = GridSize;
+			PassParameters->GridToPixelOffset = Offset;
+			PassParameters->GridToPixelDivisor = Divisor;
+			PassParameters->TileSize = TileSize;
+			PassParameters->NumTiles = Tiles.NumTiles;
+			PassParameters->RWTileList = GraphBuilder.CreateUAV(Tiles.TileList, PF_R32_UINT);
+			PassParameters->RWTileCounts = TileCountsUAV;
+			FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("SSGI Tile Classify %dx%d (%dx%d Tiles)", GridSize.X, GridSize.Y, TileSize.X, TileSize.Y), PassFlags, ComputeShader, PassParameters, FIntVector(TileCount.X, TileCount.Y, 1));
+		}
+
+		{
+			TShaderMapRef<FSSGITileDispatchArgsCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel));
+			FSSGITileDispatchArgsCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FSSGITileDispatchArgsCS::FParameters>();
+			PassParameters->TileCounts = GraphBuilder.CreateSRV(Tiles.TileCounts, PF_R32_UINT);
+			PassParameters->RWTileDispatchArgs = GraphBuilder.CreateUAV(Tiles.DispatchArgs, PF_R32_UINT);
+			FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("SSGI Tile DispatchArgs"), PassFlags, ComputeShader, PassParameters, FIntVector(1, 1, 1));
+		}
+		return Tiles;
+	}
+
+	// 同一帧内几何阶段和追踪阶段的网格映射由同一组质量设置决定，按线程组尺寸和网格即可区分
+	FSSGITileClassification FindOrAddTileClassification(FSSGITileClassificationArray& Classifications, FRDGBuilder& GraphBuilder, FRDGTextureRef SSGIGBufferTexture, const FVector4f& ViewSizeAndInvSize, FIntPoint GridSize, int32 Divisor, FIntPoint Offset, ESSGIThreadGroupSize GroupSize, ERDGPassFlags PassFlags)
+	{
+		for (const FSSGITileClassification& Tiles : Classifications)
+		{
+			if (Tiles.GroupSize == GroupSize && Tiles.GridSize == GridSize)
+			{
+				return Tiles;
+			}
+		}
+		return Classifications.Add_GetRef(AddTileClassificationPasses(GraphBuilder, SSGIGBufferTexture, ViewSizeAndInvSize, GridSize, Divisor, Offset, GroupSize, PassFlags));
+	}
+
+	FSSGITileDispatchParameters GetTileDispatchParameters(FRDGBuilder& GraphBuilder, const FSSGITileClassification& Tiles)
+	{
+		FSSGITileDispatchParameters Parameters;
+		Parameters.SSGITileList = GraphBuilder.CreateSRV(Tiles.TileList, PF_R32_UINT);
+		Parameters.SSGITileCounts = GraphBuilder.CreateSRV(Tiles.TileCounts, PF_R32_UINT);
+		Parameters.IndirectArgs = Tiles.DispatchArgs;
+		return Parameters;
+	}
+
+	// SkipMaskTexture为空时（未开启自适应光线预算或没有历史）绑定占位纹理，没有像素被跳过
+	FSSGISkipMaskParameters GetSkipMaskParameters(FRDGBuilder& GraphBuilder, FRDGTextureRef SkipMaskTexture, FIntPoint TraceSize, FIntPoint TraceOffset, int32 ResolutionDivisor)
+	{
+		FSSGISkipMaskParameters Parameters;
+		Parameters.SSGISkipMask = SkipMaskTexture ? SkipMaskTexture : GSystemTextures.GetZeroUIntDummy(GraphBuilder);
+		Parameters.SkipMaskTraceSize = TraceSize;
+		Parameters.SkipMaskTraceOffset = TraceOffset;
+		Parameters.SkipMaskDivisor = ResolutionDivisor;
+		Parameters.bSkipMaskValid = SkipMaskTexture ? 1 : 0;
+		return Parameters;
+	}
+
+	// 跳过的Tile直接写0，MomentsOutput和CountOutput非空时同时清空亮度矩和累积计数
+	void AddTileClearPass(FRDGBuilder& GraphBuilder, const FSSGITileClassification& Tiles, FRDGTextureRef Output, FRDGTextureRef MomentsOutput, FRDGTextureRef CountOutput, ERDGPassFlags PassFlags)
+	{
+		FSSGITileClearCS::FPermutationDomain PermutationVector;
+		PermutationVector.Set<FSSGIThreadGroupSizeDim>(Tiles.GroupSize);
+		PermutationVector.Set<FSSGITileClearCS::FClearMomentsDim>(MomentsOutput != nullptr);
+		TShaderMapRef<FSSGITileClearCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel), PermutationVector);
+		FSSGITileClearCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FSSGITileClearCS::FParameters>();
+		PassParameters->TileList = GraphBuilder.CreateSRV(Tiles.TileList, PF_R32_UINT);
+		PassParameters->TileCounts = GraphBuilder.CreateSRV(Tiles.TileCounts, PF_R32_UINT);
+		PassParameters->GridSize = Tiles.GridSize;
+		PassParameters->NumTiles = Tiles.NumTiles;
+		PassParameters->ClearOutput = GraphBuilder.CreateUAV(Output);
+		PassParameters->ClearMomentsOutput = MomentsOutput ? GraphBuilder.CreateUAV(MomentsOutput) : nullptr;
+		PassParameters->ClearCountOutput = CountOutput ? GraphBuilder.CreateUAV(CountOutput) : nullptr;
+		PassParameters->IndirectArgs = Tiles.DispatchArgs;
+		// 第二组间接参数是跳过的Tile
+		FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("SSGI Tile Clear %s", Output->Name), PassFlags, ComputeShader, PassParameters, Tiles.DispatchArgs, sizeof(FRHIDispatchIndirectParameters));
+	}
+
+	// 有Tile分类时只间接Dispatch需要计算的Tile，否则按GroupCount覆盖整个网格
+	template<typename TShaderClass>
+	void AddTiledPass(FRDGBuilder& GraphBuilder, FRDGEventName&& PassName, ERDGPassFlags PassFlags, const TShaderRef<TShaderClass>& ComputeShader, typename TShaderClass::FParameters* PassParameters, const FSSGITileClassification& Tiles, FIntVector GroupCount)
+	{
+		if (Tiles.IsValid())
+		{
+			FComputeShaderUtils::AddPass(GraphBuilder, MoveTemp(PassName), PassFlags, ComputeShader, PassParameters, Tiles.DispatchArgs, 0);
+		}
+		else
+		{
+			FComputeShaderUtils::AddPass(GraphBuilder, MoveTemp(PassName), PassFlags, ComputeShader, PassParameters, GroupCount);
+		}
+	}
+
+	// 批处理的上采样和降噪的线程组数：所有View都有Tile分类时按Tile列表Dispatch，X覆盖最多的Tile数（需要计算 + 跳过），Z为View序号
+	// 跳过的Tile在同一个Dispatch中写0，不再需要单独的Clear Pass；没有Tile分类时按最大的View尺寸覆盖整个View
+	bool GetViewBatchTileParameters(FRDGBuilder& GraphBuilder, TConstArrayView<FSSGITileClassification> Tiles, FIntPoint MaxViewSize, FIntPoint GroupSize, FSSGIViewBatchTileParameters& OutParameters, FIntVector& OutGroupCount)
+	{
+		const int32 NumViews = Tiles.Num();
+		bool bTiled = true;
+		int32 MaxNumTiles = 0;
+		for (const FSSGITileClassification& ViewTiles : Tiles)
+		{
+			bTiled = bTiled && ViewTiles.IsValid() && ViewTiles.GroupSize == Tiles[0].GroupSize;
+			MaxNumTiles = FMath::Max(MaxNumTiles, ViewTiles.NumTiles);
+		}
+		if (!bTiled)
+		{
+			OutGroupCount = FIntVector(FMath::DivideAndRoundUp(MaxViewSize.X, GroupSize.X), FMath::DivideAndRoundUp(MaxViewSize.Y, GroupSize.Y), NumViews);
+			return false;
+		}
+		// 空余的槽位绑定最后一个View，Shader不会访问
+		for (int32 Slot = 0; Slot < kSSGIMaxBatchedViews; Slot++)
+		{
+			const FSSGITileClassification& ViewTiles = Tiles[FMath::Min(Slot, NumViews - 1)];
+			OutParameters.SSGIBatchTileLists[Slot] = GraphBuilder.CreateSRV(ViewTiles.TileList, PF_R32_UINT);
+			OutParameters.SSGIBatchTileCounts[Slot] = GraphBuilder.CreateSRV(ViewTiles.TileCounts, PF_R32_UINT);
+		}
+		OutGroupCount = FIntVector(FMath::Min(MaxNumTiles, kSSGITileDispatchWrap), FMath::DivideAndRoundUp(MaxNumTiles, kSSGITileDispatchWrap), NumViews);
+		return true;
+	}
+}
+
+uint64 FSSGIViewState::GetMemorySize() const
+{
+	uint64 TotalBytes = 0;
+	if (HistoryRenderTarget.IsValid()) TotalBytes += HistoryRenderTarget->ComputeMemorySize();
+	if (HistoryMomentsRenderTarget.IsValid()) TotalBytes += HistoryMomentsRenderTarget->ComputeMemorySize();
+	if (HistoryCountRenderTarget.IsValid()) TotalBytes += HistoryCountRenderTarget->ComputeMemorySize();
+	if (IrradianceProbes.IsValid()) TotalBytes += IrradianceProbes->GetSize();
+	if (IrradianceProbeCells.IsValid()) TotalBytes += IrradianceProbeCells->GetSize();
+	return TotalBytes;
+}
+
+FHZBSSGISceneViewExtension::FHZBSSGISceneViewExtension(const FAutoRegister& AutoRegister) : FSceneViewExtensionBase(AutoRegister)
+{
+}
+
+FSSGIViewState* FHZBSSGISceneViewExtension::FindOrAddViewState(const FSceneView& View)
+{
+	// 没有ViewState的View（比如一次性的SceneCapture）没有跨帧的连续性，不保存历史
+	if (!View.State)
+	{
+		return nullptr;
+	}
+
+	TUniquePtr<FSSGIViewState>& ViewState = ViewStates.FindOrAdd(View.State->GetViewKey());
+	if (!ViewState.IsValid())
+	{
+		ViewState = MakeUnique<FSSGIViewState>();
+	}
+	ViewState->LastUsedFrame = View.Family->FrameNumber;
+	return ViewState.Get();
+}
+
+void FHZBSSGISceneViewExtension::EvictStaleViewStates(uint32 FrameNumber)
+{
+	const uint32 MaxIdleFrames = FMath::Max(CVarSSGIHistoryMaxIdleFrames.GetValueOnRenderThread(), 1);
+	const int32 MaxViews = FMath::Max(CVarSSGIHistoryMaxViews.GetValueOnRenderThread(), 1);
+
+	// 释放引用后纹理回到RenderTargetPool，由Pool统一回收
+	for (auto It = ViewStates.CreateIterator(); It; ++It)
+	{
+		if (FrameNumber - It.Value()->LastUsedFrame > MaxIdleFrames)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	// 本帧用过的View可能还有未完成的纹理提取，不能淘汰
+	while (ViewStates.Num() > MaxViews)
+	{
+		uint32 OldestKey = 0;
+		uint32 OldestFrame = FrameNumber;
+		for (const auto& Pair : ViewStates)
+		{
+			if (Pair.Value->LastUsedFrame < OldestFrame)
+			{
+				OldestKey = Pair.Key;
+				OldestFrame = Pair.Value->LastUsedFrame;
+			}
+		}
+		if (OldestFrame == FrameNumber)
+		{
+			break;
+		}
+		ViewStates.Remove(OldestKey);
+	}
+
+	uint64 TotalBytes = 0;
+	for (const auto& Pair : ViewStates)
+	{
+		TotalBytes += Pair.Value->GetMemorySize();
+	}
+	SET_MEMORY_STAT(STAT_HZBSSGI_PersistentMemoryTotal, TotalBytes);
+	SET_DWORD_STAT(STAT_HZBSSGI_PersistentViews, ViewStates.Num());
+}
+
+void FHZBSSGISceneViewExtension::ProcessTraceStatsReadbacks(uint32 CurrentFrameNumber)
+{
+	// 从最早的帧开始，每次处理一帧；当前帧的View可能还没全部加入回读，这一帧还有回读没完成时也等下次调用
+	for (;;)
+	{
+		int32 OldestIndex = INDEX_NONE;
+		for (int32 Index = 0; Index < kTraceStatsReadbackCount; Index++)
+		{
+			if (bTraceStatsPending[Index] && (OldestIndex == INDEX_NONE || int32(TraceStatsFrameNumbers[Index] - TraceStatsFrameNumbers[OldestIndex]) < 0))
+			{
+				OldestIndex = Index;
+			}
+		}
+		if (OldestIndex == INDEX_NONE)
+		{
+			return;
+		}
+		const uint32 FrameNumber = TraceStatsFrameNumbers[OldestIndex];
+		if (FrameNumber == CurrentFrameNumber)
+		{
+			return;
+		}
+		for (int32 Index = 0; Index < kTraceStatsReadbackCount; Index++)
+		{
+			if (bTraceStatsPending[Index] && TraceStatsFrameNumbers[Index] == FrameNumber && !TraceStatsReadbacks[Index]->IsReady())
+			{
+				return;
+			}
+		}
+
+		uint64 RaysTraced = 0;
+		uint64 HitRays = 0;
+		uint64 TotalIterations = 0;
+		for (int32 Index = 0; Index < kTraceStatsReadbackCount; Index++)
+		{
+			if (!bTraceStatsPending[Index] || TraceStatsFrameNumbers[Index] != FrameNumber)
+			{
+				continue;
+			}
+			FRHIGPUBufferReadback* Readback = TraceStatsReadbacks[Index].Get();
+			const uint32* Counters = static_cast<const uint32*>(Readback->Lock(3 * sizeof(uint32)));
+			RaysTraced += Counters[0];
+			HitRays += Counters[1];
+			TotalIterations += Counters[2];
+			Readback->Unlock();
+			bTraceStatsPending[Index] = false;
+		}
+		if (bTraceStatsHasIncompleteFrame && TraceStatsIncompleteFrame == FrameNumber)
+		{
+			continue;
+		}
+
+		const float HitRate = RaysTraced > 0 ? float(double(HitRays) / RaysTraced) : 0.0f;
+		const float AverageIterations = RaysTraced > 0 ? float(double(TotalIterations) / RaysTraced) : 0.0f;
+		SET_DWORD_STAT(STAT_HZBSSGI_RaysTraced, uint32(FMath::Min<uint64>(RaysTraced, MAX_uint32)));
+		SET_FLOAT_STAT(STAT_HZBSSGI_HitRate, HitRate);
+		SET_FLOAT_STAT(STAT_HZBSSGI_AverageIterations, AverageIterations);
+		CSV_CUSTOM_STAT(HZBSSGI, RaysTraced, int32(FMath::Min<uint64>(RaysTraced, MAX_int32)), ECsvCustomStatOp::Set);
+		CSV_CUSTOM_STAT(HZBSSGI, HitRate, HitRate, ECsvCustomStatOp::Set);
+		CSV_CUSTOM_STAT(HZBSSGI, AverageIterations, AverageIterations, ECsvCustomStatOp::Set);
+	}
+}
+
+FRHIGPUBufferReadback* FHZBSSGISceneViewExtension::AcquireTraceStatsReadback(uint32 FrameNumber)
+{
+	for (int32 Index = 0; Index < kTraceStatsReadbackCount; Index++)
+	{
+		if (bTraceStatsPending[Index])
+		{
+			continue;
+		}
+		if (!TraceStatsReadbacks[Index].IsValid())
+		{
+			TraceStatsReadbacks[Index] = MakeUnique<FRHIGPUBufferReadback>(TEXT("HZBSSGI.TraceStats"));
+		}
+		bTraceStatsPending[Index] = true;
+		TraceStatsFrameNumbers[Index] = FrameNumber;
+		return TraceStatsReadbacks[Index].Get();
+	}
+	TraceStatsIncompleteFrame = FrameNumber;
+	bTraceStatsHasIncompleteFrame = true;
+	return nullptr;
+}
+
+FSSGIBudgetTimer* FHZBSSGISceneViewExtension::BeginBudgetTimer(FRDGBuilder& GraphBuilder, uint32 FrameNumber)
+{
+	if (CVarSSGIBudgetTargetMs.GetValueOnRenderThread() <= 0.0f)
+	{
+		return nullptr;
+	}
+	// 读回长时间没有完成（比如设备丢失）时不再继续累积
+	constexpr int32 MaxPendingTimers = 32;
+	if (BudgetTimers.Num() >= MaxPendingTimers)
+	{
+		return nullptr;
+	}
+	if (!BudgetQueryPool.IsValid())
+	{
+		BudgetQueryPool = RHICreateRenderQueryPool(RQT_AbsoluteTime);
+	}
+
+	TUniquePtr<FSSGIBudgetTimer>& Timer = BudgetTimers.Add_GetRef(MakeUnique<FSSGIBudgetTimer>());
+	Timer->BeginQuery = BudgetQueryPool->AllocateQuery();
+	Timer->EndQuery = BudgetQueryPool->AllocateQuery();
+	Timer->FrameNumber = FrameNumber;
+	Timer->Level = GSSGIBudgetLevel.load(std::memory_order_relaxed);
+	AddTimestampPass(GraphBuilder, Timer->BeginQuery.GetQuery());
+	return Timer.Get();
+}
+
+void FHZBSSGISceneViewExtension::EndBudgetTimer(FRDGBuilder& GraphBuilder, FSSGIBudgetTimer* Timer)
+{
+	if (Timer && !Timer->bEndIssued)
+	{
+		AddTimestampPass(GraphBuilder, Timer->EndQuery.GetQuery());
+		Timer->bEndIssued = true;
+	}
+}
+
+void FHZBSSGISceneViewExtension::ProcessBudgetTimers(uint32 FrameNumber)
+{
+	const float TargetMs = CVarSSGIBudgetTargetMs.GetValueOnRenderThread();
+	if (TargetMs <= 0.0f)
+	{
+		// 关闭后恢复配置的质量，已经提交的计时器仍要等GPU执行完才能释放
+		GSSGIBudgetLevel.store(0, std::memory_order_relaxed);
+		BudgetFramesAtLevel = 0;
+		FMemory::Memzero(BudgetLevelCostMs);
+	}
+
+	// 之前的帧已经执行完RDG，没有结束时间戳的计时器（View跳过了后处理）可以丢弃
+	BudgetTimers.RemoveAll([FrameNumber](const TUniquePtr<FSSGIBudgetTimer>& Timer)
+	{
+		return !Timer->bEndIssued && Timer->FrameNumber != FrameNumber;
+	});
+
+	// 按帧汇总：一帧的所有View都读回后才算一个样本
+	while (BudgetTimers.Num() > 0 && BudgetTimers[0]->FrameNumber != FrameNumber)
+	{
+		const uint32 SampleFrame = BudgetTimers[0]->FrameNumber;
+		const int32 SampleLevel = BudgetTimers[0]->Level;
+		int32 NumFrameTimers = 0;
+		uint64 TotalMicroseconds = 0;
+		bool bReady = true;
+		for (; NumFrameTimers < BudgetTimers.Num() && BudgetTimers[NumFrameTimers]->FrameNumber == SampleFrame; NumFrameTimers++)
+		{
+			const FSSGIBudgetTimer& Timer = *BudgetTimers[NumFrameTimers];
+			uint64 BeginTime = 0;
+			uint64 EndTime = 0;
+			if (!RHIGetRenderQueryResult(Timer.BeginQuery.GetQuery(), BeginTime, false) || !RHIGetRenderQueryResult(Timer.EndQuery.GetQuery(), EndTime, false))
+			{
+				bReady = false;
+				break;
+			}
+			TotalMicroseconds += EndTime > BeginTime ? EndTime - BeginTime : 0;
+		}
+		if (!bReady)
+		{
+			break;
+		}
+		BudgetTimers.RemoveAt(0, NumFrameTimers);
+
+		const float MeasuredMs = float(TotalMicroseconds) / 1000.0f;
+		SET_FLOAT_STAT(STAT_HZBSSGI_BudgetGPUTime, MeasuredMs);
+		CSV_CUSTOM_STAT(HZBSSGI, BudgetGPUTime, MeasuredMs, ECsvCustomStatOp::Set);
+
+		const int32 Level = GSSGIBudgetLevel.load(std::memory_order_relaxed);
+		if (TargetMs <= 0.0f || SampleLevel != Level)
+		{
+			continue;
+		}
+
+		// 每个档位的耗时做指数平滑，单帧的波动不会触发切换
+		float& LevelCostMs = BudgetLevelCostMs[Level];
+		LevelCostMs = (LevelCostMs > 0.0f && BudgetFramesAtLevel > 0) ? FMath::Lerp(LevelCostMs, MeasuredMs, 0.25f) : MeasuredMs;
+		BudgetLevelCostFrame[Level] = SampleFrame;
+		if (++BudgetFramesAtLevel < kSSGIBudgetMinFramesPerLevel)
+		{
+			continue;
+		}
+
+		const float Hysteresis = FMath::Clamp(CVarSSGIBudgetHysteresis.GetValueOnRenderThread(), 0.0f, 0.9f);
+		int32 NewLevel = Level;
+		if (LevelCostMs > TargetMs * (1.0f + Hysteresis) && Level < kSSGIBudgetLevelCount - 1)
+		{
+			NewLevel = Level + 1;
+		}
+		else if (LevelCostMs < TargetMs * (1.0f - Hysteresis) && Level > 0)
+		{
+			// 更高一档上次超出预算时不回去，除非那次测量已经过期
+			const bool bHigherCostKnown = BudgetLevelCostMs[Level - 1] > 0.0f && SampleFrame - BudgetLevelCostFrame[Level - 1] < kSSGIBudgetCostMaxAge;
+			if (!bHigherCostKnown || BudgetLevelCostMs[Level - 1] <= TargetMs)
+			{
+				NewLevel = Level - 1;
+			}
+		}
+		if (NewLevel != Level)
+		{
+			GSSGIBudgetLevel.store(NewLevel, std::memory_order_relaxed);
+			BudgetFramesAtLevel = 0;
+		}
+	}
+
+	// 控制器当前的决定
+	const FSSGIQualitySettings Settings = GetSSGIQualitySettings();
+	SET_DWORD_STAT(STAT_HZBSSGI_BudgetLevel, GSSGIBudgetLevel.load(std::memory_order_relaxed));
+	SET_DWORD_STAT(STAT_HZBSSGI_BudgetResolutionDivisor, Settings.ResolutionDivisor);
+	SET_DWORD_STAT(STAT_HZBSSGI_BudgetMaxIterations, Settings.MaxIterations);
+	SET_DWORD_STAT(STAT_HZBSSGI_BudgetSampleCount, Settings.SampleCount);
+	SET_DWORD_STAT(STAT_HZBSSGI_BudgetDenoiserIterations, Settings.DenoiserIterations);
+	CSV_CUSTOM_STAT(HZBSSGI, BudgetLevel, GSSGIBudgetLevel.load(std::memory_order_relaxed), ECsvCustomStatOp::Set);
+}
+
+void FHZBSSGISceneViewExtension::PostRenderBasePassDeferred_RenderThread(FRDGBuilder& GraphBuilder, FSceneView& InView, const FRenderTargetBindingSlots& RenderTargets, TRDGUniformBufferRef<FSceneTextureUniformParameters> SceneTextures)
+{
+	if (CVarHZBSSGIOn.GetValueOnRenderThread() == 0 || CVarSSGIAsyncCompute.GetValueOnRenderThread() == 0 || !GSupportsEfficientAsyncCompute)
+	{
+		return;
+	}
+	if (!SceneTextures)
+	{
+		return;
+	}
+
+	// 几何阶段只依赖深度和GBuffer，BasePass之后就可以开始，与阴影、光照在图形队列上重叠
+	FRDGTextureRef SceneDepth = SceneTextures->GetParameters()->SceneDepthTexture;
+	if (!SceneDepth)
+	{
+		return;
+	}
+
+	const FIntRect ViewRect = UE::FXRenderingUtils::GetRawViewRectUnsafe(InView);
+
+	RDG_EVENT_SCOPE(GraphBuilder, "HZBSSGI Geometry (AsyncCompute)");
+	FSSGIGeometryOutputs Geometry;
+	AddGeometryPasses(GraphBuilder, InView, SceneTextures, SceneDepth, ViewRect, ERDGPassFlags::AsyncCompute, Geometry);
+	PendingGeometry.Add(&InView, Geometry);
+}
+
+void FHZBSSGISceneViewExtension::PrePostProcessPass_RenderThread(FRDGBuilder& GraphBuilder, const FSceneView& View, const FPostProcessingInputs& Inputs)
+{
+	if (CVarHZBSSGIOn.GetValueOnRenderThread() == 0)
+	{
+		return;
+	}
+	if (!Inputs.SceneTextures)
+	{
+		return;
+	}
+
+	const FSceneTextureUniformParameters* SceneTextureParameters = Inputs.SceneTextures->GetParameters();
+	FRDGTextureRef SceneDepth = SceneTextureParameters->SceneDepthTexture;
+	FRDGTextureRef SceneColor = SceneTextureParameters->SceneColorTexture;
+	if (!SceneDepth || !SceneColor)
+	{
+		return;
+	}
+
+	// 同一个ViewFamily中更早的View已经把这个View一起加入了队列
+	if (PendingTraces.Contains(&View))
+	{
+		return;
+	}
+
+	// 开启异步计算时加入AsyncCompute队列，在Temporal之前汇合；否则在图形队列上，两种情况下BeforeDOF回调都只做Temporal和Composite
+	const bool bAsyncCompute = CVarSSGIAsyncCompute.GetValueOnRenderThread() != 0 && GSupportsEfficientAsyncCompute;
+	const ERDGPassFlags PassFlags = bAsyncCompute ? ERDGPassFlags::AsyncCompute : ERDGPassFlags::Compute;
+
+	// 多View批处理：所有View共用SceneColor和SceneDepth，第一个View时一起追踪，上采样和降噪每kSSGIMaxBatchedViews个View只Dispatch一次
+	// 追踪和Temporal仍然按View进行：追踪的矩阵、历史、辐射缓存和探针是每个View独立的，Temporal（融合Composite）写的是各View后处理链中自己的输出
+	TArray<const FSceneView*, TInlineAllocator<kSSGIMaxBatchedViews>> BatchViews;
+	if (GetSSGIViewSettings().bMultiViewBatch)
+	{
+		BatchViews.Append(View.Family->Views);
+	}
+	else
+	{
+		BatchViews.Add(&View);
+	}
+
+	RDG_EVENT_SCOPE(GraphBuilder, "HZBSSGI%s", bAsyncCompute ? TEXT(" (AsyncCompute)") : TEXT(""));
+	FRDGTextureSRVRef SceneColorSRV = GraphBuilder.CreateSRV(FRDGTextureSRVDesc(SceneColor));
+	TArray<FSSGITraceOutputs, TInlineAllocator<kSSGIMaxBatchedViews>> Traces;
+	Traces.SetNum(BatchViews.Num());
+	for (int32 ViewIndex = 0; ViewIndex < BatchViews.Num(); ViewIndex++)
+	{
+		const FSceneView& BatchView = *BatchViews[ViewIndex];
+		// 与BeforeDOF回调中SceneColor的ViewRect一致（TSR等放大之前的分辨率）
+		const FIntRect ViewRect = UE::FXRenderingUtils::GetRawViewRectUnsafe(BatchView);
+		FSSGIGeometryOutputs Geometry;
+		const bool bHasGeometry = PendingGeometry.RemoveAndCopyValue(&BatchView, Geometry);
+		AddTracePasses(GraphBuilder, BatchView, Inputs.SceneTextures, SceneDepth, SceneColorSRV, ViewRect, bHasGeometry ? &Geometry : nullptr, FSSGIViewFrameState(), PassFlags, Traces[ViewIndex]);
+	}
+	// 超过kSSGIMaxBatchedViews个View（多人分屏）时分批
+	for (int32 BatchStart = 0; BatchStart < Traces.Num(); BatchStart += kSSGIMaxBatchedViews)
+	{
+		TArray<FSSGITraceOutputs*, TInlineAllocator<kSSGIMaxBatchedViews>> TracePtrs;
+		for (int32 ViewIndex = BatchStart; ViewIndex < FMath::Min(BatchStart + kSSGIMaxBatchedViews, Traces.Num()); ViewIndex++)
+		{
+			TracePtrs.Add(&Traces[ViewIndex]);
+		}
+		AddUpsampleDenoisePasses(GraphBuilder, TracePtrs, PassFlags);
+	}
+	for (int32 ViewIndex = 0; ViewIndex < BatchViews.Num(); ViewIndex++)
+	{
+		PendingTraces.Add(BatchViews[ViewIndex], Traces[ViewIndex]);
+	}
+}
+
+void FHZBSSGISceneViewExtension::PostRenderViewFamily_RenderThread(FRDGBuilder& GraphBuilder, FSceneViewFamily& InViewFamily)
+{
+	// 没有被BeforeDOF消费的结果（比如该View关闭了后处理）引用的是本帧的RDG资源，不能留到下一帧
+	PendingGeometry.Reset();
+	PendingTraces.Reset();
+	SharedHZBs.Reset();
+	ProcessBudgetTimers(InViewFamily.FrameNumber);
+}
+
+void FHZBSSGISceneViewExtension::SubscribeToPostProcessingPass(EPostProcessingPass PassId, const FSceneView& View, FAfterPassCallbackDelegateArray& InOutPassCallbacks, bool bIsPassEnabled)
+{
+    //UE_LOG(LogTemp, Warning, TEXT("Checking PassId: %d"), (int32)PassId);
+	if (PassId == EPostProcessingPass::BeforeDOF)
+	{
+		//UE_LOG(LogTemp, Warning, TEXT(">> HZB SSGI Subscribed at SSRInput (Pre-TSR)!"));
+		InOutPassCallbacks.Add(FAfterPassCallbackDelegate::CreateRaw(this, &FHZBSSGISceneViewExtension::HZBSSGIProcessPass));
+	}
+}
+
+FScreenPassTexture FHZBSSGISceneViewExtension::HZBSSGIProcessPass(FRDGBuilder& GraphBuilder, const FSceneView& View, const FPostProcessMaterialInputs& Inputs)
+{
+	if (CVarHZBSSGIOn.GetValueOnRenderThread() == 0)
+	{
+		return Inputs.ReturnUntouchedSceneColorForPostProcessing(GraphBuilder);
+	}
+	SCOPE_CYCLE_COUNTER(STAT_HZBSSGI_ProcessPass);
+	CSV_SCOPED_TIMING_STAT(HZBSSGI, ProcessPass);
+	const FSceneTextureShaderParameters& SceneTextures = Inputs.SceneTextures;
+	FRDGTextureRef SceneDepth = nullptr;
+	// 后处理已经有SceneTextures的UniformBuffer，追踪阶段直接使用，不再重新创建
+	TRDGUniformBufferRef<FSceneTextureUniformParameters> SceneTexturesUniformBuffer = nullptr;
+
+	if (SceneTextures.SceneTextures)
+	{
+		SceneTexturesUniformBuffer = SceneTextures.SceneTextures.GetUniformBuffer();
+		if (SceneTexturesUniformBuffer) SceneDepth = SceneTexturesUniformBuffer->GetParameters()->SceneDepthTexture;
+	}
+	else if (SceneTextures.MobileSceneTextures)
+	{
+		auto* UniformBuffer = SceneTextures.MobileSceneTextures.GetUniformBuffer();
+		if (UniformBuffer) SceneDepth = UniformBuffer->GetParameters()->SceneDepthTexture;
+	}
+	if (!SceneDepth)
+	{
+		return Inputs.ReturnUntouchedSceneColorForPostProcessing(GraphBuilder);
+	}
+	
+	FScreenPassTextureSlice SceneColorSlice = Inputs.GetInput(EPostProcessMaterialInput::SceneColor);
+	if (!SceneColorSlice.IsValid()) return Inputs.ReturnUntouchedSceneColorForPostProcessing(GraphBuilder);
+	
+	RDG_EVENT_SCOPE(GraphBuilder, "HZBSSGI");
+	FIntRect ViewRect = SceneColorSlice.ViewRect;
+	FIntPoint ViewSize = ViewRect.Size();
+
+	// 追踪、上采样和降噪已经在PrePostProcessPass中加入（异步计算时在AsyncCompute队列上），这里只做Temporal和Composite
+	// 没有对应的结果（移动端没有SceneTextures、ViewRect已变化）时在这里补上
+	FSSGITraceOutputs Trace;
+	if (!PendingTraces.RemoveAndCopyValue(&View, Trace) || Trace.ViewRect != ViewRect)
+	{
+		// 丢弃不匹配的异步结果（没有消费者的Pass由RDG裁剪），但它已经做过的状态变更不能再做一次
+		const FSSGIViewFrameState FrameState = Trace.FrameState;
+		Trace = FSSGITraceOutputs();
+		FSSGIGeometryOutputs Geometry;
+		const bool bHasGeometry = PendingGeometry.RemoveAndCopyValue(&View, Geometry);
+		AddTracePasses(GraphBuilder, View, SceneTexturesUniformBuffer, SceneDepth, SceneColorSlice.TextureSRV, ViewRect, bHasGeometry ? &Geometry : nullptr, FrameState, ERDGPassFlags::Compute, Trace);
+		FSSGITraceOutputs* TracePtr = &Trace;
+		AddUpsampleDenoisePasses(GraphBuilder, MakeArrayView(&TracePtr, 1), ERDGPassFlags::Compute);
+	}
+	FSSGIViewState* ViewState = Trace.FrameState.ViewState;
+
+	const FSSGIViewSettings& Settings = GetSSGIViewSettings();
+	FRDGTextureDesc SSGIFullResDesc = FRDGTextureDesc::Create2D(
+		ViewSize,
+		Settings.ColorFormat, FClearValueBinding::Black,
+		TexCreate_ShaderResource | TexCreate_UAV
+	);
+	const ESSGIThreadGroupSize ThreadGroupSize = Settings.ThreadGroupSize;
+	const int32 DebugMode = Settings.DebugMode;
+	const FSSGIQualitySettings& QualitySettings = Settings.Quality;
+	const bool bFusedComposite = Settings.bFusedComposite;
+
+	// 后处理链的最后一个Pass会给出OverrideOutput，可以UAV写入时直接写入，否则新建输出
+	FScreenPassRenderTarget Output = Inputs.OverrideOutput;
+	if (!Output.IsValid() || !EnumHasAnyFlags(Output.Texture->Desc.Flags, TexCreate_UAV) || Output.ViewRect.Size() != ViewSize)
+	{
+		// 替代SceneColor的输出，保留RGBA16F
+		FRDGTextureDesc OutputDesc = SSGIFullResDesc;
+		OutputDesc.Format = PF_FloatRGBA;
+		OutputDesc.Flags |= TexCreate_UAV;
+		OutputDesc.Flags &= ~(TexCreate_RenderTargetable | TexCreate_FastVRAM);
+		Output = FScreenPassRenderTarget(GraphBuilder.CreateTexture(OutputDesc, TEXT("SSGI_Composite_Output")), FIntRect(0, 0, ViewSize.X, ViewSize.Y), ERenderTargetLoadAction::ENoAction);
+	}
+
+	/**
+	 * Temporal Pass
+	 */
+    FRDGTextureRef TemporalOutputTexture = nullptr;
+    // 调试模式>= 3时追踪结果是热力图，不进入Temporal，也不能写入历史
+    const bool bDebugHeatmap = DebugMode >= 3;
+    if (bDebugHeatmap)
+    {
+        // 历史停止更新后与画面脱节，直接丢弃，退出调试后从头累积
+        if (ViewState)
+        {
+            ViewState->HistoryRenderTarget.SafeRelease();
+            ViewState->HistoryMomentsRenderTarget.SafeRelease();
+            ViewState->HistoryCountRenderTarget.SafeRelease();
+        }
+    }
+    else
+    {
+        RDG_GPU_STAT_SCOPE(GraphBuilder, HZBSSGI_Temporal);
+        // 输出即下一帧的历史，使用量化后的尺寸，只写入ViewSize的区域
+        FRDGTextureDesc Desc = SSGIFullResDesc;
+        Desc.Extent = Trace.HistoryExtent;
+        TemporalOutputTexture = GraphBuilder.CreateTexture(Desc, TEXT("SSGI_Temporal_Output"));
+        // r/g为亮度一阶矩和二阶矩；累积计数单独放在R8里，持久历史每像素4+4+1字节
+        FRDGTextureDesc MomentsDesc = FRDGTextureDesc::Create2D(Trace.HistoryExtent, PF_G16R16F, FClearValueBinding::Black, TexCreate_ShaderResource | TexCreate_UAV);
+        FRDGTextureRef TemporalMomentsTexture = GraphBuilder.CreateTexture(MomentsDesc, TEXT("SSGI_Temporal_Moments"));
+        FRDGTextureDesc CountDesc = FRDGTextureDesc::Create2D(Trace.HistoryExtent, PF_R8, FClearValueBinding::Black, TexCreate_ShaderResource | TexCreate_UAV);
+        FRDGTextureRef TemporalCountTexture = GraphBuilder.CreateTexture(CountDesc, TEXT("SSGI_Temporal_Count"));
+
+        FSSGITemporalCS::FPermutationDomain PermutationVector;
+        PermutationVector.Set<FSSGITemporalCS::FKernelRadiusDim>(QualitySettings.TemporalKernelRadius);
+        PermutationVector.Set<FSSGITemporalCS::FCompositeDim>(bFusedComposite);
+        // Tile分类在追踪阶段完成，线程组尺寸必须与Tile一致；融合Composite时天空像素也要写出SceneColor，不使用Tile
+        const FSSGITileClassification TemporalTiles = bFusedComposite ? FSSGITileClassification() : Trace.TemporalTiles;
+        const ESSGIThreadGroupSize TemporalGroupSizePermutation = TemporalTiles.IsValid() ? TemporalTiles.GroupSize : ThreadGroupSize;
+        PermutationVector.Set<FSSGIThreadGroupSizeDim>(TemporalGroupSizePermutation);
+        PermutationVector.Set<FSSGITiledDispatchDim>(TemporalTiles.IsValid());
+        TShaderMapRef<FSSGITemporalCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel), PermutationVector);
+        FSSGITemporalCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FSSGITemporalCS::FParameters>();
+
+        PassParameters->CurrentFrameTexture = Trace.DenoisedTexture; 
+        PassParameters->HistoryTexture = Trace.HistoryTexture;
+        PassParameters->HistoryMomentsTexture = Trace.HistoryMomentsTexture;
+        PassParameters->HistoryCountTexture = Trace.HistoryCountTexture;
+        PassParameters->VelocityTexture = Trace.VelocityTexture;
+        PassParameters->SSGIGBufferTexture = Trace.SSGIGBufferTexture;
+        
+        PassParameters->OutputTexture = GraphBuilder.CreateUAV(TemporalOutputTexture);
+        PassParameters->OutputMomentsTexture = GraphBuilder.CreateUAV(TemporalMomentsTexture);
+        PassParameters->OutputCountTexture = GraphBuilder.CreateUAV(TemporalCountTexture);
+        if (bFusedComposite)
+        {
+            PassParameters->SceneColorTexture = SceneColorSlice.TextureSRV;
+            PassParameters->CompositeOutputTexture = GraphBuilder.CreateUAV(Output.Texture);
+            PassParameters->CompositeOutputOffset = Output.ViewRect.Min;
+        }
+        
+		PassParameters->ViewSizeAndInvSize = Trace.ViewSizeAndInvSize;
+		PassParameters->BufferSizeAndInvSize = Trace.BufferSizeAndInvSize;
+		PassParameters->ViewRectMin = Trace.ViewRectMin;
+        PassParameters->HistoryWeight = Trace.bHistoryValid ? 0.9f : 0.0f;
+        PassParameters->MaxAccumulation = QualitySettings.TemporalMaxAccumulation;
+        PassParameters->HistoryUVScale = Trace.HistoryUVScale;
+        PassParameters->HistoryUVMax = Trace.HistoryUVMax;
+		// 使用双边插值采样，保证平滑
+        PassParameters->BilinearSampler = TStaticSamplerState<SF_Bilinear, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
+        PassParameters->SkipMask = GetSkipMaskParameters(GraphBuilder, Trace.SkipMaskTexture, Trace.TraceSize, Trace.TraceOffset, Trace.ResolutionDivisor);
+        if (TemporalTiles.IsValid())
+        {
+            PassParameters->Tiles = GetTileDispatchParameters(GraphBuilder, TemporalTiles);
+            AddTileClearPass(GraphBuilder, TemporalTiles, TemporalOutputTexture, TemporalMomentsTexture, TemporalCountTexture, ERDGPassFlags::Compute);
+        }
+
+		const FIntPoint TemporalGroupSize = GetSSGIThreadGroupSize(TemporalGroupSizePermutation);
+		FIntVector GroupCount(FMath::DivideAndRoundUp(ViewSize.X, TemporalGroupSize.X), FMath::DivideAndRoundUp(ViewSize.Y, TemporalGroupSize.Y), 1);
+        AddTiledPass(GraphBuilder, RDG_EVENT_NAME("SSGI Temporal"), ERDGPassFlags::Compute, ComputeShader, PassParameters, TemporalTiles, GroupCount);
+        
+        if (ViewState)
+        {
+            GraphBuilder.QueueTextureExtraction(TemporalOutputTexture, &ViewState->HistoryRenderTarget);
+            GraphBuilder.QueueTextureExtraction(TemporalMomentsTexture, &ViewState->HistoryMomentsRenderTarget);
+            GraphBuilder.QueueTextureExtraction(TemporalCountTexture, &ViewState->HistoryCountRenderTarget);
+            ViewState->HistoryViewSize = ViewSize;
+        }
+    }
+	
+	if (bFusedComposite)
+	{
+		EndBudgetTimer(GraphBuilder, Trace.FrameState.BudgetTimer);
+		return FScreenPassTexture(Output);
+	}
+
+	/**
+	 * Composite Pass
+	 */
+	FScreenPassTexture SceneColor = FScreenPassTexture::CopyFromSlice(GraphBuilder, SceneColorSlice);
+	{
+		RDG_GPU_STAT_SCOPE(GraphBuilder, HZBSSGI_Composite);
+		TShaderMapRef<FSSGICompositeCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel));
+		FSSGICompositeCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FSSGICompositeCS::FParameters>();
+
+		PassParameters->SceneColorTexture = SceneColor.Texture;
+		FRDGTextureRef SelectedTexture = TemporalOutputTexture;
+		if (DebugMode == 1 || DebugMode >= 3)
+		{
+			// 查看SSGI Pass的结果，>= 3时是调试Permutation的输出
+			SelectedTexture = Trace.SSGIOutputTexture;
+		}
+		else if (DebugMode == 2)
+		{
+			// 查看Denoise Pass的结果
+			SelectedTexture = Trace.DenoisedTexture;
+		}
+		
+		PassParameters->SSGIResultTexture = SelectedTexture;
+		// Temporal的输出可能比ViewSize大（历史纹理的量化尺寸），按有效区域缩放UV
+		const FIntPoint SelectedValidSize = (SelectedTexture == Trace.SSGIOutputTexture) ? Trace.TraceSize : ViewSize;
+		PassParameters->SSGIResultUVScale = FVector2f(
+			float(SelectedValidSize.X) / SelectedTexture->Desc.Extent.X,
+			float(SelectedValidSize.Y) / SelectedTexture->Desc.Extent.Y);
+		PassParameters->OutputTexture = GraphBuilder.CreateUAV(Output.Texture);
+		PassParameters->OutputOffset = Output.ViewRect.Min;
+		PassParameters->ViewSizeAndInvSize = Trace.ViewSizeAndInvSize;
+		PassParameters->BufferSizeAndInvSize = Trace.BufferSizeAndInvSize;
+		PassParameters->ViewRectMin = Trace.ViewRectMin;
+		
+		FIntVector GroupCount(FMath::DivideAndRoundUp(ViewSize.X, 8), FMath::DivideAndRoundUp(ViewSize.Y, 8), 1);
+        FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("SSGI Composite"), ComputeShader, PassParameters, GroupCount);
+	}
+	EndBudgetTimer(GraphBuilder, Trace.FrameState.BudgetTimer);
+	return FScreenPassTexture(Output);
 }
 
-FHZBSSGISceneViewExtension::FHZBSSGISceneViewExtension(const FAutoRegister& AutoRegister) : FSceneViewExtensionBase(AutoRegister)
+
+void FHZBSSGISceneViewExtension::AddSetupBenchmarkPasses(FRDGBuilder& GraphBuilder, const FSceneView& View, TRDGUniformBufferRef<FSceneTextureUniformParameters> SceneTexturesUniformBuffer, FRDGTextureRef SceneDepth, FRDGTextureSRVRef SceneColorSRV, const FIntRect& ViewRect, uint64& OutGeometryCycles, uint64& OutTraceCycles)
 {
+	// 不带ViewState、不开始预算计时，不修改任何跨帧状态
+	FSSGIViewFrameState FrameState;
+	FrameState.bValid = true;
+	// 每次调用都是新的GraphBuilder，上一次的HZB不能复用
+	SharedHZBs.Reset();
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	FSSGIGeometryOutputs Geometry;
+	AddGeometryPasses(GraphBuilder, View, SceneTexturesUniformBuffer, SceneDepth, ViewRect, ERDGPassFlags::Compute, Geometry);
+	const uint64 GeometryEndCycles = FPlatformTime::Cycles64();
+	FSSGITraceOutputs Trace;
+	AddTracePasses(GraphBuilder, View, SceneTexturesUniformBuffer, SceneDepth, SceneColorSRV, ViewRect, &Geometry, FrameState, ERDGPassFlags::Compute, Trace);
+	FSSGITraceOutputs* TracePtr = &Trace;
+	AddUpsampleDenoisePasses(GraphBuilder, MakeArrayView(&TracePtr, 1), ERDGPassFlags::Compute);
+	OutGeometryCycles = GeometryEndCycles - StartCycles;
+	OutTraceCycles = FPlatformTime::Cycles64() - GeometryEndCycles;
+	SharedHZBs.Reset();
 }
 
-void FHZBSSGISceneViewExtension::SubscribeToPostProcessingPass(EPostProcessingPass PassId, const FSceneView& View, FAfterPassCallbackDelegateArray& InOutPassCallbacks, bool bIsPassEnabled)
+FSSGISharedHZB FHZBSSGISceneViewExtension::FindOrAddHZB(FRDGBuilder& GraphBuilder, FRDGTextureRef SceneDepth, const FIntRect& SourceRect, bool bCompact, bool bHalfPrecision, uint32 FrameNumber, ERDGPassFlags PassFlags)
 {
-    //UE_LOG(LogTemp, Warning, TEXT("Checking PassId: %d"), (int32)PassId);
-	if (PassId == EPostProcessingPass::BeforeDOF)
+	for (const FSSGISharedHZB& SharedHZB : SharedHZBs)
 	{
-		//UE_LOG(LogTemp, Warning, TEXT(">> HZB SSGI Subscribed at SSRInput (Pre-TSR)!"));
-		InOutPassCallbacks.Add(FAfterPassCallbackDelegate::CreateRaw(this, &FHZBSSGISceneViewExtension::HZBSSGIProcessPass));
+		if (SharedHZB.SceneDepth == SceneDepth && SharedHZB.SourceRect == SourceRect && SharedHZB.bCompact == bCompact
+			&& SharedHZB.bHalfPrecision == bHalfPrecision && SharedHZB.FrameNumber == FrameNumber)
+		{
+			return SharedHZB;
+		}
 	}
-}
+	SCOPE_CYCLE_COUNTER(STAT_HZBSSGI_HZBSetup);
 
-FScreenPassTexture FHZBSSGISceneViewExtension::HZBSSGIProcessPass(FRDGBuilder& GraphBuilder, const FSceneView& View, const FPostProcessMaterialInputs& Inputs)
-{
-	if (CVarHZBSSGIOn.GetValueOnRenderThread() == 0)
+	// 默认模式：Buffer尺寸的Depth
+	// Compact模式：只覆盖SourceRect，取其尺寸向上取整的2的幂的一半（每个Texel覆盖1~2个像素），保证每级Mip的尺寸都能被整除
+	const FIntPoint BufferSize = SceneDepth->Desc.Extent;
+	const FIntPoint SourceSize = SourceRect.Size();
+	FSSGISharedHZB HZB;
+	HZB.SceneDepth = SceneDepth;
+	HZB.SourceRect = SourceRect;
+	HZB.bCompact = bCompact;
+	HZB.bHalfPrecision = bHalfPrecision;
+	HZB.FrameNumber = FrameNumber;
+	FIntPoint HZBSize = BufferSize;
+	HZB.NumMips = FMath::Min(FMath::FloorLog2(FMath::Max(HZBSize.X, HZBSize.Y)) + 1, kHZBMaxMipCount);
+	if (bCompact)
 	{
-		return Inputs.ReturnUntouchedSceneColorForPostProcessing(GraphBuilder);
+		HZBSize.X = FMath::Max<int32>(FMath::RoundUpToPowerOfTwo(SourceSize.X) / 2, 1);
+		HZBSize.Y = FMath::Max<int32>(FMath::RoundUpToPowerOfTwo(SourceSize.Y) / 2, 1);
+		// 只到较短边为1的那一级，GetCellCount不会出现0
+		HZB.NumMips = FMath::Min(FMath::FloorLog2(FMath::Min(HZBSize.X, HZBSize.Y)) + 1, kHZBMaxMipCount);
+		// HZB UV即SourceRect内的UV
+		HZB.BufferUVToHZBUV = FVector4f(
+			float(BufferSize.X) / SourceSize.X, float(BufferSize.Y) / SourceSize.Y,
+			-float(SourceRect.Min.X) / SourceSize.X, -float(SourceRect.Min.Y) / SourceSize.Y);
+	}
+	const int32 NumMips = HZB.NumMips;
+
+	const uint64 FullHZBBytes = GetHZBMemorySize(BufferSize, FMath::Min(FMath::FloorLog2(FMath::Max(BufferSize.X, BufferSize.Y)) + 1, kHZBMaxMipCount), sizeof(float));
+	const uint64 HZBBytes = GetHZBMemorySize(HZBSize, NumMips, bHalfPrecision ? sizeof(FFloat16) : sizeof(float));
+	SET_MEMORY_STAT(STAT_HZBSSGI_HZBMemory, HZBBytes);
+	SET_MEMORY_STAT(STAT_HZBSSGI_HZBMemorySaved, FullHZBBytes - HZBBytes);
+
+	FRDGTextureDesc HZBDesc = FRDGTextureDesc::Create2D(
+		HZBSize, bHalfPrecision ? PF_R16F : PF_R32_FLOAT, FClearValueBinding::None,
+		TexCreate_ShaderResource | TexCreate_UAV
+	);
+	HZBDesc.NumMips = NumMips;
+	HZB.Texture = GraphBuilder.CreateTexture(HZBDesc, TEXT("HZB Texture"));
+	{
+		RDG_GPU_STAT_SCOPE(GraphBuilder, HZBSSGI_HZBBuild);
+		// 单Pass生成整条Mip链，Mip0直接从SceneDepth读取
+		FIntPoint GroupCountXY = FIntPoint::DivideAndRoundUp(HZBSize, 64);
+
+		// 最后一个完成的线程组负责小Mip，通过原子计数判断
+		FRDGBufferRef AtomicCounter = GraphBuilder.CreateBuffer(FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), 1), TEXT("HZB AtomicCounter"));
+		FRDGBufferUAVRef AtomicCounterUAV = GraphBuilder.CreateUAV(AtomicCounter, PF_R32_UINT);
+		AddClearUAVPass(GraphBuilder, AtomicCounterUAV, 0u, PassFlags);
+
+		FHZBBuildCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FHZBBuildCS::FParameters>();
+		PassParameters->SceneDepthTexture = SceneDepth;
+		for (int32 MipLevel = 0; MipLevel < kHZBMaxMipCount; MipLevel++)
+		{
+			// 超出Mip数的槽位复用最后一级的UAV，Shader里不会写入
+			PassParameters->OutputDepthMip[MipLevel] = MipLevel < NumMips
+				? GraphBuilder.CreateUAV(FRDGTextureUAVDesc(HZB.Texture, MipLevel))
+				: PassParameters->OutputDepthMip[NumMips - 1];
+		}
+		PassParameters->AtomicCounter = AtomicCounterUAV;
+		PassParameters->HZBMip0Size = FUintVector2(HZBSize.X, HZBSize.Y);
+		if (bCompact)
+		{
+			PassParameters->SourceViewMin = FUintVector2(SourceRect.Min.X, SourceRect.Min.Y);
+			PassParameters->SourceViewMax = FUintVector2(SourceRect.Max.X - 1, SourceRect.Max.Y - 1);
+			PassParameters->SourceScale = FVector2f(float(SourceSize.X) / HZBSize.X, float(SourceSize.Y) / HZBSize.Y);
+		}
+		else
+		{
+			PassParameters->SourceViewMin = FUintVector2(0, 0);
+			PassParameters->SourceViewMax = FUintVector2(BufferSize.X - 1, BufferSize.Y - 1);
+			PassParameters->SourceScale = FVector2f(1.0f, 1.0f);
+		}
+		PassParameters->NumMips = NumMips;
+		PassParameters->NumGroups = GroupCountXY.X * GroupCountXY.Y;
+
+		FHZBBuildCS::FPermutationDomain PermutationVector;
+		PermutationVector.Set<FHZBBuildCS::FCompactDim>(bCompact);
+		PermutationVector.Set<FHZBBuildCS::FHalfPrecisionDim>(bHalfPrecision);
+		TShaderMapRef<FHZBBuildCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel), PermutationVector);
+		// 按HZB的尺寸分配线程组
+		FIntVector GroupCount(GroupCountXY.X, GroupCountXY.Y, 1);
+		FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("HZB Build %dx%d (%d Mips)", HZBSize.X, HZBSize.Y, NumMips), PassFlags, ComputeShader, PassParameters, GroupCount);
 	}
+
+	SharedHZBs.Add(HZB);
+	return HZB;
+}
+
+void FHZBSSGISceneViewExtension::AddGeometryPasses(FRDGBuilder& GraphBuilder, const FSceneView& View, TRDGUniformBufferRef<FSceneTextureUniformParameters> SceneTexturesUniformBuffer, FRDGTextureRef SceneDepth, const FIntRect& ViewRect, ERDGPassFlags PassFlags, FSSGIGeometryOutputs& OutGeometry)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HZBSSGI_TraceSetup);
+	CSV_SCOPED_TIMING_STAT(HZBSSGI, TraceSetup);
 	/**
 	 * HZB Pass
 	 */
-	const FSceneTextureShaderParameters& SceneTextures = Inputs.SceneTextures;
-	FRDGTextureRef SceneDepth = nullptr;
+	FIntPoint ViewSize = ViewRect.Size();
+	FIntPoint BufferSize = SceneDepth->Desc.Extent;
+	ensure(ViewSize.X <= BufferSize.X && ViewSize.Y <= BufferSize.Y);
+	FVector4f CommonViewRectMin = FVector4f(ViewRect.Min.X, ViewRect.Min.Y, 0.0f, 0.0f);
+	FVector4f CommonViewSizeAndInvSize = FVector4f(
+		ViewSize.X, ViewSize.Y, 
+		1.0f / ViewSize.X, 1.0f / ViewSize.Y
+	);
 
-	if (SceneTextures.SceneTextures)
-	{
-		auto* UniformBuffer = SceneTextures.SceneTextures.GetUniformBuffer();
-		if (UniformBuffer) SceneDepth = UniformBuffer->GetParameters()->SceneDepthTexture;
-	}
-	else if (SceneTextures.MobileSceneTextures)
-	{
-		auto* UniformBuffer = SceneTextures.MobileSceneTextures.GetUniformBuffer();
-		if (UniformBuffer) SceneDepth = UniformBuffer->GetParameters()->SceneDepthTexture;
-	}
-	if (!SceneDepth)
+	const FSSGIViewSettings& Settings = GetSSGIViewSettings();
+	const FSSGIQualitySettings& QualitySettings = Settings.Quality;
+	// 多View批处理：同一个ViewFamily的View（双眼、分屏）在SceneDepth中并排，HZB覆盖所有View的并集，只构建一次
+	// 每个View的追踪仍然按自己的ViewRect裁剪光线，不会走进相邻的View
+	FIntRect HZBSourceRect = ViewRect;
+	if (Settings.bMultiViewBatch && View.Family->Views.Num() > 1)
 	{
-		return Inputs.ReturnUntouchedSceneColorForPostProcessing(GraphBuilder);
+		if (QualitySettings.bCompactHZB)
+		{
+			for (const FSceneView* FamilyView : View.Family->Views)
+			{
+				HZBSourceRect.Union(UE::FXRenderingUtils::GetRawViewRectUnsafe(*FamilyView));
+			}
+			HZBSourceRect.Clip(FIntRect(FIntPoint::ZeroValue, BufferSize));
+		}
+		else
+		{
+			// Full Extent的HZB与View无关
+			HZBSourceRect = FIntRect(FIntPoint::ZeroValue, BufferSize);
+		}
 	}
-	
-	RDG_EVENT_SCOPE(GraphBuilder, "HZBSSGI");
-	// Buffer尺寸的Depth
-	auto SceneSize = SceneDepth->Desc.Extent;
-	int32 NumMips = FMath::FloorLog2(FMath::Max(SceneSize.X, SceneSize.Y)) + 1;
+	OutGeometry.ViewRect = ViewRect;
+	OutGeometry.HZB = FindOrAddHZB(GraphBuilder, SceneDepth, HZBSourceRect, QualitySettings.bCompactHZB, QualitySettings.bHalfPrecisionHZB, View.Family->FrameNumber, PassFlags);
 
-	FRDGTextureDesc HZBDesc = FRDGTextureDesc::Create2D(
-		SceneSize, PF_R32_FLOAT, FClearValueBinding::None,
-		TexCreate_ShaderResource | TexCreate_UAV | TexCreate_RenderTargetable
-	);
-	HZBDesc.NumMips = NumMips;
-	FRDGTextureRef HZBTexture = GraphBuilder.CreateTexture(HZBDesc, TEXT("HZB Texture"));
-	// 生成 Mip 0 (直接拷贝 SceneDepth)
-	FScreenPassTexture SceneDepthInput(SceneDepth);
-	FScreenPassRenderTarget HZBMip0(HZBTexture, ERenderTargetLoadAction::ENoAction);
-	AddDrawTexturePass(GraphBuilder, View, SceneDepthInput, HZBMip0);
+	auto SceneTexturesParams = SceneTexturesUniformBuffer ? SceneTexturesUniformBuffer : CreateSceneTextureUniformBuffer(GraphBuilder, View);
+	const FSceneTextureUniformParameters* SceneTextureParameters = SceneTexturesParams->GetParameters();
+	FRDGTextureRef BlackDummy = GSystemTextures.GetBlackDummy(GraphBuilder);
 
-	UE::Math::TIntPoint<int32> CurrentInputSize = SceneSize;
-	for (int32 MipLevel = 1; MipLevel < NumMips; MipLevel++)
+	/**
+	 * GBuffer Decode Pass
+	 */
+	// 法线解码和ConvertFromDeviceZ只做一次，后续Pass都读这张 uint2 纹理
+	FRDGTextureDesc SSGIGBufferDesc = FRDGTextureDesc::Create2D(
+		ViewSize,
+		PF_R32G32_UINT, FClearValueBinding::None,
+		TexCreate_ShaderResource | TexCreate_UAV
+	);
+	FRDGTextureRef SSGIGBufferTexture = GraphBuilder.CreateTexture(SSGIGBufferDesc, TEXT("SSGI_GBuffer"));
 	{
-		UE::Math::TIntPoint<int32> NextOutputSize;
-		NextOutputSize.X = FMath::Max(1, CurrentInputSize.X / 2);
-		NextOutputSize.Y = FMath::Max(1, CurrentInputSize.Y / 2);
-
-		FHZBBuildCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FHZBBuildCS::FParameters>();
-		// 上一级的SRV
-		PassParameters->InputDepthTexture = GraphBuilder.CreateSRV(FRDGTextureSRVDesc::CreateForMipLevel(HZBTexture, MipLevel - 1));
-		PassParameters->InputViewportMaxBound = FVector2f(CurrentInputSize.X - 1, CurrentInputSize.Y - 1);
-		// 当前级的UAV
-		PassParameters->OutputDepthTexture = GraphBuilder.CreateUAV(FRDGTextureUAVDesc(HZBTexture, MipLevel));
-		PassParameters->OutputViewportSize = FVector2f(NextOutputSize.X, NextOutputSize.Y);
+		RDG_GPU_STAT_SCOPE(GraphBuilder, HZBSSGI_GBufferDecode);
+		TShaderMapRef<FSSGIGBufferDecodeCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel));
+		FSSGIGBufferDecodeCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FSSGIGBufferDecodeCS::FParameters>();
 
-		TShaderMapRef<FHZBBuildCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel));
-		// 由于使用的是Buffer尺寸，所以GroupCount也需要传入的是Buffer尺寸的
-		FIntVector GroupCount(FMath::DivideAndRoundUp(NextOutputSize.X, 8), FMath::DivideAndRoundUp(NextOutputSize.Y, 8), 1);
+		PassParameters->SceneDepthTexture = SceneDepth;
+		PassParameters->GBufferATexture = SceneTextureParameters->GBufferATexture ? SceneTextureParameters->GBufferATexture : BlackDummy;
+		PassParameters->GBufferBTexture = SceneTextureParameters->GBufferBTexture ? SceneTextureParameters->GBufferBTexture : BlackDummy;
+		PassParameters->SSGIGBufferOutput = GraphBuilder.CreateUAV(SSGIGBufferTexture);
+		PassParameters->ViewSizeAndInvSize = CommonViewSizeAndInvSize;
+		PassParameters->ViewRectMin = CommonViewRectMin;
+		PassParameters->View = View.ViewUniformBuffer;
 
-		FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("HZB Mip%d", MipLevel), ComputeShader, PassParameters, GroupCount);
-		CurrentInputSize = NextOutputSize;
+		FIntVector GroupCount(FMath::DivideAndRoundUp(ViewSize.X, 8), FMath::DivideAndRoundUp(ViewSize.Y, 8), 1);
+		FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("SSGI GBuffer Decode"), PassFlags, ComputeShader, PassParameters, GroupCount);
 	}
+	OutGeometry.SSGIGBufferTexture = SSGIGBufferTexture;
 
 	/**
-	 * SSGI Trace Pass
+	 * Tile Classification
 	 */
-	float SSGIIntensity = 1.0f;
-	FScreenPassTextureSlice SceneColorSlice = Inputs.GetInput(EPostProcessMaterialInput::SceneColor);
-	if (!SceneColorSlice.IsValid()) return Inputs.ReturnUntouchedSceneColorForPostProcessing(GraphBuilder);
+	// 预先分类追踪阶段会用到的网格，调试Permutation等改变线程组尺寸的情况由追踪阶段补充
+	if (Settings.bTileClassification)
+	{
+		const ESSGIThreadGroupSize ThreadGroupSize = Settings.ThreadGroupSize;
+		// 全分辨率追踪和Temporal
+		FindOrAddTileClassification(OutGeometry.Tiles, GraphBuilder, SSGIGBufferTexture, CommonViewSizeAndInvSize, ViewSize, 1, FIntPoint::ZeroValue, ThreadGroupSize, PassFlags);
+		if (QualitySettings.DenoiserIterations > 0)
+		{
+			FindOrAddTileClassification(OutGeometry.Tiles, GraphBuilder, SSGIGBufferTexture, CommonViewSizeAndInvSize, ViewSize, 1, FIntPoint::ZeroValue, Settings.DenoiseGroupSize, PassFlags);
+		}
+		const int32 ResolutionDivisor = QualitySettings.ResolutionDivisor;
+		if (ResolutionDivisor > 1)
+		{
+			// 上采样
+			FindOrAddTileClassification(OutGeometry.Tiles, GraphBuilder, SSGIGBufferTexture, CommonViewSizeAndInvSize, ViewSize, 1, FIntPoint::ZeroValue, ESSGIThreadGroupSize::Size8x8, PassFlags);
+			// 降分辨率追踪，排序追踪不使用Tile
+			if (!Settings.bSortedTrace)
+			{
+				const FIntPoint TraceSize = FIntPoint::DivideAndRoundUp(ViewSize, ResolutionDivisor);
+				const FIntPoint TraceOffset = GetTraceOffset(ResolutionDivisor, View.Family->FrameNumber % 1024);
+				FindOrAddTileClassification(OutGeometry.Tiles, GraphBuilder, SSGIGBufferTexture, CommonViewSizeAndInvSize, TraceSize, ResolutionDivisor, TraceOffset, ThreadGroupSize, PassFlags);
+			}
+		}
+	}
+}
+
+void FHZBSSGISceneViewExtension::AddTracePasses(FRDGBuilder& GraphBuilder, const FSceneView& View, TRDGUniformBufferRef<FSceneTextureUniformParameters> SceneTexturesUniformBuffer, FRDGTextureRef SceneDepth, FRDGTextureSRVRef SceneColorSRV, const FIntRect& ViewRect, const FSSGIGeometryOutputs* Geometry, const FSSGIViewFrameState& FrameState, ERDGPassFlags PassFlags, FSSGITraceOutputs& OutTrace)
+{
+	SCOPE_CYCLE_COUNTER(STAT_HZBSSGI_TraceSetup);
+	CSV_SCOPED_TIMING_STAT(HZBSSGI, TraceSetup);
 	// Buffer的大小和View的坐标映射
-	FIntRect ViewRect = SceneColorSlice.ViewRect;
 	FIntPoint ViewSize = ViewRect.Size();
 	FIntPoint BufferSize = SceneDepth->Desc.Extent;
 	ensure(ViewSize.X <= BufferSize.X && ViewSize.Y <= BufferSize.Y);
@@ -117,171 +1650,556 @@ FScreenPassTexture FHZBSSGISceneViewExtension::HZBSSGIProcessPass(FRDGBuilder& G
 		BufferSize.X, BufferSize.Y, 
 		1.0f / BufferSize.X, 1.0f / BufferSize.Y
 	);
+
+	const FSSGIViewSettings& Settings = GetSSGIViewSettings();
+	const FSSGIQualitySettings& QualitySettings = Settings.Quality;
+	OutTrace.FrameState = FrameState;
+	if (!OutTrace.FrameState.bValid)
+	{
+		OutTrace.FrameState.bValid = true;
+		// 预算只统计追踪阶段开始之后的耗时，提前开始的几何阶段与光照重叠，不计入
+		OutTrace.FrameState.BudgetTimer = BeginBudgetTimer(GraphBuilder, View.Family->FrameNumber);
+		OutTrace.FrameState.ViewState = FindOrAddViewState(View);
+		EvictStaleViewStates(View.Family->FrameNumber);
+	}
+
+	// 没有提前加入的几何阶段（未开启异步计算，或该View的ViewRect已变化）时在同一个队列上补上
+	FSSGIGeometryOutputs InlineGeometry;
+	if (!Geometry || Geometry->ViewRect != ViewRect)
+	{
+		AddGeometryPasses(GraphBuilder, View, SceneTexturesUniformBuffer, SceneDepth, ViewRect, PassFlags, InlineGeometry);
+		Geometry = &InlineGeometry;
+	}
+	FRDGTextureRef HZBTexture = Geometry->HZB.Texture;
+	const int32 NumMips = Geometry->HZB.NumMips;
+	const FVector4f BufferUVToHZBUV = Geometry->HZB.BufferUVToHZBUV;
+	FRDGTextureRef SSGIGBufferTexture = Geometry->SSGIGBufferTexture;
+
 	FMatrix44f MatSVPosToWorld = FMatrix44f(View.ViewMatrices.GetInvTranslatedViewProjectionMatrix());
 	FMatrix44f MatWorldToClip = FMatrix44f(View.ViewMatrices.GetTranslatedViewProjectionMatrix());
+	// 针对后续的Temporal Pass添加的FrameIndex 用于产生随机噪点种子
+	uint32 FrameIndex = View.Family->FrameNumber % 1024; 
+
+	// 降分辨率追踪：每个Divisor x Divisor的块追踪一个像素
+	const int32 ResolutionDivisor = QualitySettings.ResolutionDivisor;
+	FIntPoint TraceSize = FIntPoint::DivideAndRoundUp(ViewSize, ResolutionDivisor);
+	FIntPoint TraceOffset = GetTraceOffset(ResolutionDivisor, FrameIndex);
 	
-	FRDGTextureDesc SSGIOutputDesc = FRDGTextureDesc::Create2D(
+	FRDGTextureDesc SSGIFullResDesc = FRDGTextureDesc::Create2D(
 		ViewSize,
-		PF_FloatRGBA, FClearValueBinding::Black,
+		Settings.ColorFormat, FClearValueBinding::Black,
 		TexCreate_ShaderResource | TexCreate_UAV
 	);
+	FRDGTextureDesc SSGIOutputDesc = SSGIFullResDesc;
+	SSGIOutputDesc.Extent = TraceSize;
 	FRDGTextureRef SSGIOutputTexture = GraphBuilder.CreateTexture(SSGIOutputDesc, TEXT("SSGI_Raw_Output"));
-	auto SceneTexturesParams = CreateSceneTextureUniformBuffer(GraphBuilder, View);
-	{
-		TShaderMapRef<FSSGICS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel));
-		FSSGICS::FParameters* PassParameters = GraphBuilder.AllocParameters<FSSGICS::FParameters>();
-
-		PassParameters->HZBTexture = HZBTexture;
-		PassParameters->SceneColorTexture = SceneColorSlice.TextureSRV;
-		PassParameters->InputSceneDepthTexture = GraphBuilder.CreateSRV(FRDGTextureSRVDesc::Create(SceneDepth));
-
-		FRDGTextureRef Dummy = GSystemTextures.GetBlackDummy(GraphBuilder);
-		auto& StParams = SceneTexturesParams->GetParameters();
-		PassParameters->SSGI_GBufferA = StParams->GBufferATexture ? StParams->GBufferATexture : Dummy;
-		PassParameters->SSGI_GBufferB = StParams->GBufferBTexture ? StParams->GBufferBTexture : Dummy;
-		PassParameters->SSGI_GBufferC = StParams->GBufferCTexture ? StParams->GBufferCTexture : Dummy;
-
-		PassParameters->HZBSize = FVector4f(HZBTexture->Desc.Extent.X, HZBTexture->Desc.Extent.Y, 1.0f / HZBTexture->Desc.Extent.X, 1.0f / HZBTexture->Desc.Extent.Y);
-		PassParameters->MaxMipLevel = NumMips - 1;
-		PassParameters->MaxIterations = 64;
-		PassParameters->Thickness = 10.0f;
-		PassParameters->RayLength = 100.0f;
-		PassParameters->Intensity = SSGIIntensity;
-		// 针对后续的Temporal Pass添加的FrameIndex 用于产生随机噪点种子
-		uint32 FrameIndex = View.Family->FrameNumber % 1024; 
-		PassParameters->FrameIndex = (int)FrameIndex;
-		
-		PassParameters->SSGI_Raw_Output = GraphBuilder.CreateUAV(SSGIOutputTexture);
-		PassParameters->View = View.ViewUniformBuffer;
+	uint64 ColorChainBytes = GetSSGITextureBytes(SSGIOutputDesc);
+	auto SceneTexturesParams = SceneTexturesUniformBuffer ? SceneTexturesUniformBuffer : CreateSceneTextureUniformBuffer(GraphBuilder, View);
+	const FSceneTextureUniformParameters* SceneTextureParameters = SceneTexturesParams->GetParameters();
+	// 缺失的GBuffer、速度和历史都绑定到同一张黑色纹理
+	FRDGTextureRef BlackDummy = GSystemTextures.GetBlackDummy(GraphBuilder);
 
-		PassParameters->ViewRectMin = CommonViewRectMin;
-		PassParameters->ViewSizeAndInvSize = CommonViewSizeAndInvSize;
-		PassParameters->BufferSizeAndInvSize = CommonBufferSizeAndInvSize;
-        
-		PassParameters->SVPositionToTranslatedWorld = MatSVPosToWorld;
-		PassParameters->TranslatedWorldToClip = MatWorldToClip;
-		// 由于使用的是View尺寸，所以GroupCount也需要传入的是View尺寸的
-		FIntVector GroupCount(FMath::DivideAndRoundUp(ViewSize.X, 8), FMath::DivideAndRoundUp(ViewSize.Y, 8), 1);
-		FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("SSGI Trace"), ComputeShader, PassParameters, GroupCount);
-	}
+	// View的Tile分类，每种线程组尺寸只分类一次，各Pass共用，几何阶段已分类的直接使用
+	const bool bTileClassification = Settings.bTileClassification;
+	FSSGITileClassificationArray TileClassifications = Geometry->Tiles;
+	auto GetTiles = [&](FIntPoint GridSize, int32 Divisor, FIntPoint Offset, ESSGIThreadGroupSize GroupSize) -> FSSGITileClassification
+	{
+		if (!bTileClassification)
+		{
+			return FSSGITileClassification();
+		}
+		return FindOrAddTileClassification(TileClassifications, GraphBuilder, SSGIGBufferTexture, CommonViewSizeAndInvSize, GridSize, Divisor, Offset, GroupSize, PassFlags);
+	};
+	auto GetViewTiles = [&](ESSGIThreadGroupSize GroupSize) -> FSSGITileClassification
+	{
+		return GetTiles(ViewSize, 1, FIntPoint::ZeroValue, GroupSize);
+	};
 
 	/**
-	 * Denoise Pass
+	 * History
 	 */
-    FRDGTextureDesc DenoiseDesc = SSGIOutputTexture->Desc;
-    FRDGTextureRef DenoisedTexture = GraphBuilder.CreateTexture(DenoiseDesc, TEXT("SSGI_Denoised"));
-    {
-        TShaderMapRef<FSSGIDenoiserCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel));
-        FSSGIDenoiserCS::FParameters* DenoiserParams = GraphBuilder.AllocParameters<FSSGIDenoiserCS::FParameters>();
+	// 上一帧Temporal的结果，追踪Pass用累积计数和方差决定光线预算，Temporal Pass用来累积
+	FSSGIViewState* ViewState = OutTrace.FrameState.ViewState;
 
-        DenoiserParams->SSGIInputTexture = SSGIOutputTexture;
-        
-        auto& StParams = SceneTexturesParams->GetParameters();
-        FRDGTextureRef Dummy = GSystemTextures.GetBlackDummy(GraphBuilder);
-        DenoiserParams->SceneDepthTexture = StParams->SceneDepthTexture ? StParams->SceneDepthTexture : Dummy;
-        DenoiserParams->GBufferATexture = StParams->GBufferATexture ? StParams->GBufferATexture : Dummy;
-        DenoiserParams->SSGIDenoiseOutput = GraphBuilder.CreateUAV(DenoisedTexture);
-        
-		DenoiserParams->ViewSizeAndInvSize = CommonViewSizeAndInvSize; // 注意名字变了
-		DenoiserParams->BufferSizeAndInvSize = CommonBufferSizeAndInvSize;
-		DenoiserParams->ViewRectMin = CommonViewRectMin;
-		DenoiserParams->Intensity = SSGIIntensity;
+	FRDGTextureRef HistoryTextureRef = nullptr;
+	FRDGTextureRef HistoryMomentsTextureRef = nullptr;
+	FRDGTextureRef HistoryCountTextureRef = nullptr;
+	bool bHistoryValid = ViewState && ViewState->HistoryRenderTarget.IsValid() && ViewState->HistoryMomentsRenderTarget.IsValid()
+		&& ViewState->HistoryCountRenderTarget.IsValid();
+	// 本帧历史纹理的尺寸，能容纳ViewSize时沿用上一帧的尺寸，RenderTargetPool直接复用同样描述的纹理
+	FIntPoint HistoryExtent = GetHistoryExtent(bHistoryValid ? ViewState->HistoryRenderTarget->GetDesc().Extent : FIntPoint::ZeroValue, ViewSize);
+	FVector2f HistoryUVScale(1.0f, 1.0f);
+	FVector2f HistoryUVMax(1.0f, 1.0f);
+	{
+		// 镜头切换，或记录的有效区域放不进历史纹理时历史内容无效，但纹理保留在ViewState里，本帧的输出会替换它
+		// 尺寸变化（动态分辨率、窗口缩放）不重置：历史按View UV采样，只需要换算到上一帧的有效区域
+		if (bHistoryValid)
+		{
+			const FIntPoint PrevExtent = ViewState->HistoryRenderTarget->GetDesc().Extent;
+			const FIntPoint PrevViewSize = ViewState->HistoryViewSize;
+			const bool bHistoryFits = PrevViewSize.X > 0 && PrevViewSize.Y > 0
+				&& PrevViewSize.X <= PrevExtent.X && PrevViewSize.Y <= PrevExtent.Y
+				&& ViewState->HistoryMomentsRenderTarget->GetDesc().Extent == PrevExtent
+				&& ViewState->HistoryCountRenderTarget->GetDesc().Extent == PrevExtent;
+			if (!bHistoryFits || View.bCameraCut)
+			{
+				bHistoryValid = false;
+			}
+		}
+
+		if (bHistoryValid)
+		{
+			HistoryTextureRef = GraphBuilder.RegisterExternalTexture(ViewState->HistoryRenderTarget);
+			HistoryMomentsTextureRef = GraphBuilder.RegisterExternalTexture(ViewState->HistoryMomentsRenderTarget);
+			HistoryCountTextureRef = GraphBuilder.RegisterExternalTexture(ViewState->HistoryCountRenderTarget);
+			// View UV到历史纹理UV的缩放（上一帧的有效区域），以及双线性采样不越过有效区域的上限
+			const FIntPoint PrevExtent = HistoryTextureRef->Desc.Extent;
+			const FIntPoint PrevViewSize = ViewState->HistoryViewSize;
+			HistoryUVScale = FVector2f(float(PrevViewSize.X) / PrevExtent.X, float(PrevViewSize.Y) / PrevExtent.Y);
+			HistoryUVMax = FVector2f((PrevViewSize.X - 0.5f) / PrevExtent.X, (PrevViewSize.Y - 0.5f) / PrevExtent.Y);
+		}
+		else
+		{
+			HistoryTextureRef = BlackDummy;
+			HistoryMomentsTextureRef = BlackDummy;
+			HistoryCountTextureRef = BlackDummy;
+		}
+	}
+	SET_MEMORY_STAT(STAT_HZBSSGI_PersistentMemory, ViewState ? ViewState->GetMemorySize() : 0);
+	// 逐像素Pass的线程组尺寸
+	const ESSGIThreadGroupSize ThreadGroupSize = Settings.ThreadGroupSize;
+	const int32 DebugMode = Settings.DebugMode;
+
+	// 获取GBuffer里面存储的速度向量图
+	FRDGTextureRef VelocityTexture = SceneTextureParameters->GBufferVelocityTexture;
+	if (!VelocityTexture)
+	{
+		VelocityTexture = BlackDummy;
+	}
 
-		FIntVector GroupCount(FMath::DivideAndRoundUp(ViewSize.X, 8), FMath::DivideAndRoundUp(ViewSize.Y, 8), 1);
-        FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("SSGI Spatial Denoise"), ComputeShader, DenoiserParams, GroupCount);
-    }
-	
 	/**
-	 * Temporal Pass
+	 * Radiance Cache
 	 */
-    FRDGTextureRef TemporalOutputTexture = nullptr;
-    {
-        FRDGTextureRef HistoryTextureRef = nullptr;
-        bool bIsFirstFrame = !HistoryRenderTarget.IsValid();
-        
-		FIntPoint CurrentViewSize = ViewSize;
-        bool bSizeChanged = false;
-		// 处理是否是第一帧
-        if (!bIsFirstFrame)
-        {
-            FIntPoint HistorySize = HistoryRenderTarget->GetDesc().Extent;
-            if (HistorySize != CurrentViewSize)
-            {
-                bSizeChanged = true;
-                HistoryRenderTarget.SafeRelease();
-            }
-        }
+	// 半分辨率的Mip链：SceneColor + 重投影的上一帧GI，命中着色按光线足迹选择Mip
+	FRDGTextureRef RadianceCacheTexture = nullptr;
+	if (QualitySettings.bRadianceCache)
+	{
+		RDG_GPU_STAT_SCOPE(GraphBuilder, HZBSSGI_RadianceCache);
+		const FIntPoint CacheSize = FIntPoint::DivideAndRoundUp(ViewSize, 2);
+		FRDGTextureDesc CacheDesc = FRDGTextureDesc::Create2D(CacheSize, PF_FloatRGBA, FClearValueBinding::Black, TexCreate_ShaderResource | TexCreate_UAV);
+		CacheDesc.NumMips = FMath::Min(FMath::FloorLog2(FMath::Min(CacheSize.X, CacheSize.Y)) + 1, kSSGIRadianceCacheMaxMips);
+		RadianceCacheTexture = GraphBuilder.CreateTexture(CacheDesc, TEXT("SSGI_RadianceCache"));
 
-        if (bIsFirstFrame || bSizeChanged)
-        {
-            HistoryTextureRef = GSystemTextures.GetBlackDummy(GraphBuilder);
-        }
-        else
-        {
-            HistoryTextureRef = GraphBuilder.RegisterExternalTexture(HistoryRenderTarget);
-        }
+		{
+			TShaderMapRef<FSSGIRadianceCacheInitCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel));
+			FSSGIRadianceCacheInitCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FSSGIRadianceCacheInitCS::FParameters>();
+			PassParameters->SceneColorTexture = SceneColorSRV;
+			PassParameters->HistoryTexture = HistoryTextureRef;
+			PassParameters->VelocityTexture = VelocityTexture;
+			PassParameters->OutputMip = GraphBuilder.CreateUAV(FRDGTextureUAVDesc(RadianceCacheTexture, 0));
+			PassParameters->OutputMipSize = CacheSize;
+			PassParameters->HistoryUVScale = HistoryUVScale;
+			PassParameters->HistoryUVMax = HistoryUVMax;
+			PassParameters->bHistoryValid = bHistoryValid ? 1 : 0;
+			PassParameters->MultiBounceWeight = FMath::Clamp(CVarSSGIRadianceCacheMultiBounce.GetValueOnRenderThread(), 0.0f, 1.0f);
+			PassParameters->ViewSizeAndInvSize = CommonViewSizeAndInvSize;
+			PassParameters->BufferSizeAndInvSize = CommonBufferSizeAndInvSize;
+			PassParameters->ViewRectMin = CommonViewRectMin;
+			PassParameters->BilinearSampler = TStaticSamplerState<SF_Bilinear, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
 
-        FRDGTextureDesc Desc = SSGIOutputTexture->Desc;
-        TemporalOutputTexture = GraphBuilder.CreateTexture(Desc, TEXT("SSGI_Temporal_Output"));
+			FIntVector GroupCount(FMath::DivideAndRoundUp(CacheSize.X, 8), FMath::DivideAndRoundUp(CacheSize.Y, 8), 1);
+			FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("SSGI RadianceCache Init %dx%d", CacheSize.X, CacheSize.Y), PassFlags, ComputeShader, PassParameters, GroupCount);
+		}
 
-        TShaderMapRef<FSSGITemporalCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel));
-        FSSGITemporalCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FSSGITemporalCS::FParameters>();
+		TShaderMapRef<FSSGIRadianceCacheDownsampleCS> DownsampleShader(GetGlobalShaderMap(GMaxRHIFeatureLevel));
+		for (int32 MipLevel = 1; MipLevel < CacheDesc.NumMips; MipLevel++)
+		{
+			const FIntPoint ParentMipSize(FMath::Max(CacheSize.X >> (MipLevel - 1), 1), FMath::Max(CacheSize.Y >> (MipLevel - 1), 1));
+			const FIntPoint MipSize(FMath::Max(CacheSize.X >> MipLevel, 1), FMath::Max(CacheSize.Y >> MipLevel, 1));
+			FSSGIRadianceCacheDownsampleCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FSSGIRadianceCacheDownsampleCS::FParameters>();
+			PassParameters->ParentMipTexture = GraphBuilder.CreateSRV(FRDGTextureSRVDesc::CreateForMipLevel(RadianceCacheTexture, MipLevel - 1));
+			PassParameters->OutputMip = GraphBuilder.CreateUAV(FRDGTextureUAVDesc(RadianceCacheTexture, MipLevel));
+			PassParameters->ParentMipSize = ParentMipSize;
+			PassParameters->OutputMipSize = MipSize;
 
-        PassParameters->CurrentFrameTexture = DenoisedTexture; 
-        PassParameters->HistoryTexture = HistoryTextureRef;
-        // 获取GBuffer里面存储的速度向量图
-        auto& StParams = SceneTexturesParams->GetParameters();
-        PassParameters->VelocityTexture = StParams->GBufferVelocityTexture ? StParams->GBufferVelocityTexture : GSystemTextures.GetBlackDummy(GraphBuilder);
-        
-        PassParameters->OutputTexture = GraphBuilder.CreateUAV(TemporalOutputTexture);
-        
-		PassParameters->ViewSizeAndInvSize = CommonViewSizeAndInvSize;
-		PassParameters->BufferSizeAndInvSize = CommonBufferSizeAndInvSize;
-		PassParameters->ViewRectMin = CommonViewRectMin;
-        PassParameters->HistoryWeight = (bIsFirstFrame || bSizeChanged) ? 0.0f : 0.9f;
-		// 使用双边插值采样，保证平滑
-        PassParameters->BilinearSampler = TStaticSamplerState<SF_Bilinear, AM_Clamp, AM_Clamp, AM_Clamp>::GetRHI();
+			FIntVector GroupCount(FMath::DivideAndRoundUp(MipSize.X, 8), FMath::DivideAndRoundUp(MipSize.Y, 8), 1);
+			FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("SSGI RadianceCache Mip %d", MipLevel), PassFlags, DownsampleShader, PassParameters, GroupCount);
+		}
+	}
 
-		FIntVector GroupCount(FMath::DivideAndRoundUp(ViewSize.X, 8), FMath::DivideAndRoundUp(ViewSize.Y, 8), 1);
-        FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("SSGI Temporal"), ComputeShader, PassParameters, GroupCount);
-        
-        GraphBuilder.QueueTextureExtraction(TemporalOutputTexture, &HistoryRenderTarget);
-    }
-	
 	/**
-	 * Composite Pass
+	 * SSGI Trace Pass
 	 */
-	FScreenPassTexture SceneColor = FScreenPassTexture::CopyFromSlice(GraphBuilder, SceneColorSlice);
-	FRDGTextureDesc OutputDesc = SSGIOutputTexture->Desc;
-	OutputDesc.Flags |= TexCreate_UAV;
-	OutputDesc.Flags &= ~(TexCreate_RenderTargetable | TexCreate_FastVRAM);
-	FRDGTextureRef OutputTexture = GraphBuilder.CreateTexture(OutputDesc, TEXT("SSGI_Composite_Output"));
+	FRDGTextureRef SkipMaskTexture = nullptr;
 	{
-		TShaderMapRef<FSSGICompositeCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel));
-		FSSGICompositeCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FSSGICompositeCS::FParameters>();
+		RDG_GPU_STAT_SCOPE(GraphBuilder, HZBSSGI_Trace);
+		const bool bAdaptiveRayBudget = QualitySettings.bAdaptiveRayBudget;
+		const bool bTraceStats = Settings.bTraceStats;
+		if (bTraceStats)
+		{
+			ProcessTraceStatsReadbacks(View.Family->FrameNumber);
+		}
+		const bool bDebugPermutation = Settings.bDebugPermutation;
+		const bool bSortedTrace = Settings.bSortedTrace;
 
-		PassParameters->SceneColorTexture = SceneColor.Texture;
-		int32 CurrentDebugMode = CVarSSGIDebug.GetValueOnRenderThread();
-		FRDGTextureRef SelectedTexture = TemporalOutputTexture;
-		if (CurrentDebugMode == 1)
+		// 收敛像素跳过追踪时在这里标记，降噪和Temporal据此不再重复累积历史；没有历史时不会跳过
+		if (bAdaptiveRayBudget && bHistoryValid)
 		{
-			// 查看SSGI Pass的结果
-			SelectedTexture = SSGIOutputTexture;
+			SkipMaskTexture = GraphBuilder.CreateTexture(FRDGTextureDesc::Create2D(TraceSize, PF_R8_UINT, FClearValueBinding::None, TexCreate_ShaderResource | TexCreate_UAV), TEXT("SSGI_SkipMask"));
+			AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(SkipMaskTexture), 0u, PassFlags);
 		}
-		else if (CurrentDebugMode == 2)
+
+		FSSGITraceCommonParameters TraceCommon;
+		TraceCommon.HZBTexture = HZBTexture;
+		TraceCommon.SceneColorTexture = SceneColorSRV;
+		TraceCommon.SSGIGBufferTexture = SSGIGBufferTexture;
+
+		TraceCommon.SSGI_GBufferB = SceneTextureParameters->GBufferBTexture ? SceneTextureParameters->GBufferBTexture : BlackDummy;
+		TraceCommon.SSGI_GBufferC = SceneTextureParameters->GBufferCTexture ? SceneTextureParameters->GBufferCTexture : BlackDummy;
+		TraceCommon.RadianceCacheTexture = RadianceCacheTexture ? RadianceCacheTexture : BlackDummy;
+
+		TraceCommon.HZBSize = FVector4f(HZBTexture->Desc.Extent.X, HZBTexture->Desc.Extent.Y, 1.0f / HZBTexture->Desc.Extent.X, 1.0f / HZBTexture->Desc.Extent.Y);
+		TraceCommon.BufferUVToHZBUV = BufferUVToHZBUV;
+		TraceCommon.MaxMipLevel = NumMips - 1;
+		TraceCommon.MaxIterations = QualitySettings.MaxIterations;
+		TraceCommon.Thickness = QualitySettings.Thickness;
+		TraceCommon.RayLength = QualitySettings.RayLength;
+		TraceCommon.Intensity = kSSGIIntensity;
+		TraceCommon.FrameIndex = (int)FrameIndex;
+		TraceCommon.SamplingMode = FMath::Clamp(CVarSSGISamplingMode.GetValueOnRenderThread(), 0, 1);
+		// 降分辨率时块内的追踪位置按帧轮换，同一个像素每ResolutionDivisor^2帧追踪一次
+		TraceCommon.SequenceFrameIndex = (int)(FrameIndex / uint32(ResolutionDivisor * ResolutionDivisor));
+		TraceCommon.bUseRadianceCache = RadianceCacheTexture ? 1 : 0;
+		if (RadianceCacheTexture)
 		{
-			// 查看Denoise Pass的结果
-			SelectedTexture = DenoisedTexture;
+			const FIntPoint CacheSize = RadianceCacheTexture->Desc.Extent;
+			TraceCommon.RadianceCacheUVScale = FVector2f(float(ViewSize.X) / (CacheSize.X * 2), float(ViewSize.Y) / (CacheSize.Y * 2));
+			TraceCommon.RadianceCacheMaxMip = float(RadianceCacheTexture->Desc.NumMips - 1);
+			// 每像素的光线越多，单条光线代表的立体角越小
+			TraceCommon.RadianceCacheFootprintScale = FMath::Max(CVarSSGIRadianceCacheFootprintScale.GetValueOnRenderThread(), 0.0f) / FMath::Sqrt(float(QualitySettings.SampleCount));
+		}
+		else
+		{
+			TraceCommon.RadianceCacheUVScale = FVector2f(1.0f, 1.0f);
+			TraceCommon.RadianceCacheMaxMip = 0.0f;
+			TraceCommon.RadianceCacheFootprintScale = 0.0f;
 		}
 		
-		PassParameters->SSGIResultTexture = SelectedTexture;
-		PassParameters->OutputTexture = GraphBuilder.CreateUAV(OutputTexture);
-		PassParameters->ViewSizeAndInvSize = CommonViewSizeAndInvSize;
-		PassParameters->BufferSizeAndInvSize = CommonBufferSizeAndInvSize;
-		PassParameters->ViewRectMin = CommonViewRectMin;
-		
-		FIntVector GroupCount(FMath::DivideAndRoundUp(ViewSize.X, 8), FMath::DivideAndRoundUp(ViewSize.Y, 8), 1);
-        FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("SSGI Composite"), ComputeShader, PassParameters, GroupCount);
+		TraceCommon.HistoryTexture = HistoryTextureRef;
+		TraceCommon.HistoryMomentsTexture = HistoryMomentsTextureRef;
+		TraceCommon.HistoryCountTexture = HistoryCountTextureRef;
+		TraceCommon.VelocityTexture = VelocityTexture;
+		TraceCommon.HistoryUVScale = HistoryUVScale;
+		TraceCommon.HistoryUVMax = HistoryUVMax;
+		TraceCommon.bHistoryValid = bHistoryValid ? 1 : 0;
+		// 累积帧数不会超过MaxAccumulation，收敛阈值也不能超过它
+		TraceCommon.AdaptiveConvergedCount = FMath::Clamp(CVarSSGIAdaptiveConvergedCount.GetValueOnRenderThread(), 1.0f, QualitySettings.TemporalMaxAccumulation);
+		TraceCommon.AdaptiveSkipInterval = FMath::Max(CVarSSGIAdaptiveSkipInterval.GetValueOnRenderThread(), 1);
+		TraceCommon.AdaptiveVarianceThreshold = CVarSSGIAdaptiveVarianceThreshold.GetValueOnRenderThread();
+
+		TraceCommon.ViewRectMin = CommonViewRectMin;
+		TraceCommon.ViewSizeAndInvSize = CommonViewSizeAndInvSize;
+		TraceCommon.BufferSizeAndInvSize = CommonBufferSizeAndInvSize;
+		TraceCommon.TraceSize = TraceSize;
+		TraceCommon.TraceOffset = TraceOffset;
+		TraceCommon.ResolutionDivisor = ResolutionDivisor;
+        
+		TraceCommon.SVPositionToTranslatedWorld = MatSVPosToWorld;
+		TraceCommon.TranslatedWorldToClip = MatWorldToClip;
+		TraceCommon.View = View.ViewUniformBuffer;
+
+		/**
+		 * Irradiance Cache
+		 */
+		// Miss回退的探针网格：先用本帧的HZB和RadianceCache轮转更新一部分探针，追踪Pass再读取
+		// 探针在本帧的更新Pass里是UAV，共用参数先绑定空Buffer
+		const FIntVector IrradianceGridSize(kSSGIIrradianceGridSizeXY, kSSGIIrradianceGridSizeXY, kSSGIIrradianceGridSizeZ);
+		const int32 NumIrradianceProbes = IrradianceGridSize.X * IrradianceGridSize.Y * IrradianceGridSize.Z;
+		const float IrradianceCellSize = FMath::Max(CVarSSGIIrradianceCacheCellSize.GetValueOnRenderThread(), 10.0f);
+		// 网格窗口以相机所在的格子为中心，相机移动时按整格滚动，留在窗口内的探针保持不变
+		const FVector CameraOrigin = View.ViewMatrices.GetViewOrigin();
+		const FIntVector CameraCell(
+			FMath::FloorToInt(CameraOrigin.X / IrradianceCellSize),
+			FMath::FloorToInt(CameraOrigin.Y / IrradianceCellSize),
+			FMath::FloorToInt(CameraOrigin.Z / IrradianceCellSize));
+		const FIntVector IrradianceGridOrigin = CameraCell - IrradianceGridSize / 2;
+		TraceCommon.IrradianceProbes = GraphBuilder.CreateSRV(GSystemTextures.GetDefaultBuffer(GraphBuilder, sizeof(FFloat16Color)), PF_FloatRGBA);
+		TraceCommon.IrradianceProbeCells = GraphBuilder.CreateSRV(GSystemTextures.GetDefaultBuffer(GraphBuilder, sizeof(uint32)), PF_R32_UINT);
+		TraceCommon.bUseIrradianceCache = 0;
+		TraceCommon.IrradianceGridSize = IrradianceGridSize;
+		TraceCommon.IrradianceGridOrigin = IrradianceGridOrigin;
+		TraceCommon.IrradianceGridOriginTranslated = FVector3f(FVector(IrradianceGridOrigin) * IrradianceCellSize + View.ViewMatrices.GetPreViewTranslation());
+		TraceCommon.IrradianceCellSize = IrradianceCellSize;
+		// 探针需要跨帧保存，没有ViewState（如场景捕获）时不使用
+		if (QualitySettings.bIrradianceCache && ViewState)
+		{
+			RDG_GPU_STAT_SCOPE(GraphBuilder, HZBSSGI_IrradianceCache);
+			FRDGBufferRef& IrradianceProbes = OutTrace.FrameState.IrradianceProbes;
+			FRDGBufferRef& IrradianceProbeCells = OutTrace.FrameState.IrradianceProbeCells;
+			// 本帧已经更新过（回退路径）时直接读取，轮转的槽位不能前进两次，也不重复提取
+			if (!IrradianceProbes)
+			{
+				if (!ViewState->IrradianceProbes.IsValid() || !ViewState->IrradianceProbeCells.IsValid() || ViewState->IrradianceCellSize != IrradianceCellSize)
+				{
+					IrradianceProbes = GraphBuilder.CreateBuffer(FRDGBufferDesc::CreateBufferDesc(sizeof(FFloat16Color), NumIrradianceProbes * 6), TEXT("SSGI IrradianceProbes"));
+					IrradianceProbeCells = GraphBuilder.CreateBuffer(FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), NumIrradianceProbes), TEXT("SSGI IrradianceProbeCells"));
+					// Key为0的槽位不对应任何格子，探针颜色只在Key匹配后才会读取，不需要清除
+					AddClearUAVPass(GraphBuilder, GraphBuilder.CreateUAV(IrradianceProbeCells, PF_R32_UINT), 0u, PassFlags);
+					ViewState->IrradianceCellSize = IrradianceCellSize;
+					ViewState->IrradianceUpdateOffset = 0;
+				}
+				else
+				{
+					IrradianceProbes = GraphBuilder.RegisterExternalBuffer(ViewState->IrradianceProbes);
+					IrradianceProbeCells = GraphBuilder.RegisterExternalBuffer(ViewState->IrradianceProbeCells);
+				}
+
+				const int32 UpdateBudget = QualitySettings.IrradianceUpdateBudget;
+				TShaderMapRef<FSSGIIrradianceProbeUpdateCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel));
+				FSSGIIrradianceProbeUpdateCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FSSGIIrradianceProbeUpdateCS::FParameters>();
+				PassParameters->Common = TraceCommon;
+				PassParameters->RWIrradianceProbes = GraphBuilder.CreateUAV(IrradianceProbes, PF_FloatRGBA);
+				PassParameters->RWIrradianceProbeCells = GraphBuilder.CreateUAV(IrradianceProbeCells, PF_R32_UINT);
+				PassParameters->ProbeUpdateOffset = ViewState->IrradianceUpdateOffset;
+				PassParameters->ProbeMaxSampleCount = FMath::Max(CVarSSGIIrradianceCacheMaxSamples.GetValueOnRenderThread(), 1.0f);
+				// 每个线程组更新一个探针
+				FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("SSGI IrradianceCache Update %d probes", UpdateBudget), PassFlags, ComputeShader, PassParameters, FIntVector(UpdateBudget, 1, 1));
+				ViewState->IrradianceUpdateOffset = uint32((ViewState->IrradianceUpdateOffset + UpdateBudget) % NumIrradianceProbes);
+
+				GraphBuilder.QueueBufferExtraction(IrradianceProbes, &ViewState->IrradianceProbes);
+				GraphBuilder.QueueBufferExtraction(IrradianceProbeCells, &ViewState->IrradianceProbeCells);
+			}
+			TraceCommon.IrradianceProbes = GraphBuilder.CreateSRV(IrradianceProbes, PF_FloatRGBA);
+			TraceCommon.IrradianceProbeCells = GraphBuilder.CreateSRV(IrradianceProbeCells, PF_R32_UINT);
+			TraceCommon.bUseIrradianceCache = 1;
+		}
+		else if (ViewState)
+		{
+			ViewState->IrradianceProbes.SafeRelease();
+			ViewState->IrradianceProbeCells.SafeRelease();
+		}
+
+		if (bSortedTrace)
+		{
+			AddSortedTracePasses(GraphBuilder, TraceCommon, SSGIOutputTexture, SkipMaskTexture, QualitySettings.SampleCount, bAdaptiveRayBudget, PassFlags);
+		}
+		else
+		{
+			const FSSGICS::FPermutationDomain PermutationVector = Settings.TracePermutation;
+			TShaderMapRef<FSSGICS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel), PermutationVector);
+			FSSGICS::FParameters* PassParameters = GraphBuilder.AllocParameters<FSSGICS::FParameters>();
+			PassParameters->Common = TraceCommon;
+
+			// 全分辨率追踪时追踪网格就是View，与后面的Pass共用分类结果
+			const ESSGIThreadGroupSize TraceGroupSizePermutation = PermutationVector.Get<FSSGIThreadGroupSizeDim>();
+			FSSGITileClassification TraceTiles;
+			if (bTileClassification)
+			{
+				TraceTiles = GetTiles(TraceSize, ResolutionDivisor, TraceOffset, TraceGroupSizePermutation);
+				PassParameters->Tiles = GetTileDispatchParameters(GraphBuilder, TraceTiles);
+				AddTileClearPass(GraphBuilder, TraceTiles, SSGIOutputTexture, nullptr, nullptr, PassFlags);
+			}
+			PassParameters->DebugMode = DebugMode;
+			PassParameters->SSGI_Raw_Output = GraphBuilder.CreateUAV(SSGIOutputTexture);
+			PassParameters->RWSSGISkipMask = SkipMaskTexture ? GraphBuilder.CreateUAV(SkipMaskTexture) : nullptr;
+
+			FRDGBufferRef TraceStatsBuffer = nullptr;
+			if (bDebugPermutation)
+			{
+				TraceStatsBuffer = GraphBuilder.CreateBuffer(FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), 3), TEXT("SSGI TraceStats"));
+				FRDGBufferUAVRef TraceStatsUAV = GraphBuilder.CreateUAV(TraceStatsBuffer, PF_R32_UINT);
+				AddClearUAVPass(GraphBuilder, TraceStatsUAV, 0u, PassFlags);
+				PassParameters->RWTraceStats = TraceStatsUAV;
+			}
+
+			// 追踪网格的尺寸，降分辨率时光线数随像素数下降
+			const FIntPoint TraceGroupSize = GetSSGIThreadGroupSize(TraceGroupSizePermutation);
+			FIntVector GroupCount(FMath::DivideAndRoundUp(TraceSize.X, TraceGroupSize.X), FMath::DivideAndRoundUp(TraceSize.Y, TraceGroupSize.Y), 1);
+			AddTiledPass(GraphBuilder, RDG_EVENT_NAME("SSGI Trace %dx%d", TraceSize.X, TraceSize.Y), PassFlags, ComputeShader, PassParameters, TraceTiles, GroupCount);
+
+			if (bTraceStats)
+			{
+				if (FRHIGPUBufferReadback* Readback = AcquireTraceStatsReadback(View.Family->FrameNumber))
+				{
+					AddEnqueueCopyPass(GraphBuilder, Readback, TraceStatsBuffer, 3 * sizeof(uint32));
+				}
+			}
+		}
 	}
-	return FScreenPassTexture(OutputTexture, FIntRect(0, 0, ViewSize.X, ViewSize.Y));
+
+	OutTrace.SSGIOutputTexture = SSGIOutputTexture;
+	OutTrace.DenoisedTexture = nullptr;
+	OutTrace.SSGIGBufferTexture = SSGIGBufferTexture;
+	OutTrace.HistoryTexture = HistoryTextureRef;
+	OutTrace.HistoryMomentsTexture = HistoryMomentsTextureRef;
+	OutTrace.HistoryCountTexture = HistoryCountTextureRef;
+	OutTrace.VelocityTexture = VelocityTexture;
+	OutTrace.bHistoryValid = bHistoryValid;
+	OutTrace.HistoryExtent = HistoryExtent;
+	OutTrace.HistoryUVScale = HistoryUVScale;
+	OutTrace.HistoryUVMax = HistoryUVMax;
+	OutTrace.ViewRect = ViewRect;
+	OutTrace.TraceSize = TraceSize;
+	OutTrace.TraceOffset = TraceOffset;
+	OutTrace.ResolutionDivisor = ResolutionDivisor;
+	OutTrace.SkipMaskTexture = SkipMaskTexture;
+	OutTrace.ViewRectMin = CommonViewRectMin;
+	OutTrace.ViewSizeAndInvSize = CommonViewSizeAndInvSize;
+	OutTrace.BufferSizeAndInvSize = CommonBufferSizeAndInvSize;
+	OutTrace.UpsampleTiles = ResolutionDivisor > 1 ? GetViewTiles(ESSGIThreadGroupSize::Size8x8) : FSSGITileClassification();
+	OutTrace.DenoiseTiles = QualitySettings.DenoiserIterations > 0 ? GetViewTiles(Settings.DenoiseGroupSize) : FSSGITileClassification();
+	OutTrace.TemporalTiles = GetViewTiles(ThreadGroupSize);
+	OutTrace.ColorChainBytes = ColorChainBytes;
 }
+
+void FHZBSSGISceneViewExtension::AddUpsampleDenoisePasses(FRDGBuilder& GraphBuilder, TConstArrayView<FSSGITraceOutputs*> Traces, ERDGPassFlags PassFlags)
+{
+	check(Traces.Num() >= 1 && Traces.Num() <= kSSGIMaxBatchedViews);
+	const FSSGIViewSettings& Settings = GetSSGIViewSettings();
+	const int32 NumViews = Traces.Num();
+	const int32 ResolutionDivisor = Traces[0]->ResolutionDivisor;
+	// 所有View共用的参数，空余的槽位复用最后一个View，Shader不会访问
+	FSSGIViewBatchParameters Batch;
+	FIntPoint MaxViewSize = FIntPoint::ZeroValue;
+	uint64 ColorChainBytes = 0;
+	for (int32 Slot = 0; Slot < kSSGIMaxBatchedViews; Slot++)
+	{
+		const FSSGITraceOutputs& Trace = *Traces[FMath::Min(Slot, NumViews - 1)];
+		check(Trace.ResolutionDivisor == ResolutionDivisor);
+		FRDGTextureRef SkipMaskTexture = Trace.SkipMaskTexture ? Trace.SkipMaskTexture : GSystemTextures.GetZeroUIntDummy(GraphBuilder);
+		Batch.SSGIGBufferTextures[Slot] = GraphBuilder.CreateSRV(FRDGTextureSRVDesc(Trace.SSGIGBufferTexture));
+		Batch.SSGISkipMasks[Slot] = GraphBuilder.CreateSRV(FRDGTextureSRVDesc(SkipMaskTexture));
+		Batch.BatchViewSizeAndInvSize[Slot] = Trace.ViewSizeAndInvSize;
+		Batch.BatchTraceSizeAndOffset[Slot] = FIntVector4(Trace.TraceSize.X, Trace.TraceSize.Y, Trace.TraceOffset.X, Trace.TraceOffset.Y);
+		Batch.BatchSkipMaskValid[Slot] = FIntVector4(Trace.SkipMaskTexture ? 1 : 0, 0, 0, 0);
+		if (Slot < NumViews)
+		{
+			MaxViewSize = MaxViewSize.ComponentMax(Trace.ViewRect.Size());
+			ColorChainBytes += Trace.ColorChainBytes;
+		}
+	}
+	Batch.ResolutionDivisor = ResolutionDivisor;
+
+	FRDGTextureRef DenoisedTextures[kSSGIMaxBatchedViews] = {};
+	FRDGTextureDesc FullResDescs[kSSGIMaxBatchedViews];
+	for (int32 ViewIndex = 0; ViewIndex < NumViews; ViewIndex++)
+	{
+		DenoisedTextures[ViewIndex] = Traces[ViewIndex]->SSGIOutputTexture;
+		FullResDescs[ViewIndex] = FRDGTextureDesc::Create2D(
+			Traces[ViewIndex]->ViewRect.Size(),
+			Settings.ColorFormat, FClearValueBinding::Black,
+			TexCreate_ShaderResource | TexCreate_UAV
+		);
+	}
+
+	/**
+	 * Upsample Pass
+	 */
+	if (ResolutionDivisor > 1)
+	{
+		RDG_GPU_STAT_SCOPE(GraphBuilder, HZBSSGI_Upsample);
+		FRDGTextureSRVRef LowResTextures[kSSGIMaxBatchedViews] = {};
+		FRDGTextureUAVRef UpsampleOutputs[kSSGIMaxBatchedViews] = {};
+		for (int32 ViewIndex = 0; ViewIndex < NumViews; ViewIndex++)
+		{
+			LowResTextures[ViewIndex] = GraphBuilder.CreateSRV(FRDGTextureSRVDesc(DenoisedTextures[ViewIndex]));
+			DenoisedTextures[ViewIndex] = GraphBuilder.CreateTexture(FullResDescs[ViewIndex], TEXT("SSGI_Upsampled"));
+			UpsampleOutputs[ViewIndex] = GraphBuilder.CreateUAV(DenoisedTextures[ViewIndex]);
+			ColorChainBytes += GetSSGITextureBytes(FullResDescs[ViewIndex]);
+		}
+
+		TArray<FSSGITileClassification, TInlineAllocator<kSSGIMaxBatchedViews>> UpsampleTiles;
+		for (int32 ViewIndex = 0; ViewIndex < NumViews; ViewIndex++)
+		{
+			UpsampleTiles.Add(Traces[ViewIndex]->UpsampleTiles);
+		}
+		FSSGIUpsampleCS::FParameters* PassParameters = GraphBuilder.AllocParameters<FSSGIUpsampleCS::FParameters>();
+		// 每个View一层线程组，SV_GroupID.z为View序号，超出较小View的线程组直接返回
+		FIntVector GroupCount;
+		const bool bTiled = GetViewBatchTileParameters(GraphBuilder, UpsampleTiles, MaxViewSize, FIntPoint(8, 8), PassParameters->BatchTiles, GroupCount);
+		FSSGIUpsampleCS::FPermutationDomain PermutationVector;
+		PermutationVector.Set<FSSGITiledDispatchDim>(bTiled);
+		TShaderMapRef<FSSGIUpsampleCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel), PermutationVector);
+
+		for (int32 Slot = 0; Slot < kSSGIMaxBatchedViews; Slot++)
+		{
+			const int32 ViewIndex = FMath::Min(Slot, NumViews - 1);
+			PassParameters->SSGILowResTextures[Slot] = LowResTextures[ViewIndex];
+			PassParameters->SSGIUpsampleOutputs[Slot] = UpsampleOutputs[ViewIndex];
+		}
+		PassParameters->Batch = Batch;
+		PassParameters->DepthSigma = 0.05f;
+		PassParameters->NormalPower = 8.0f;
+		FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("SSGI Upsample 1/%d (%d Views%s)", ResolutionDivisor, NumViews, bTiled ? TEXT(", Tiled") : TEXT("")), PassFlags, ComputeShader, PassParameters, GroupCount);
+	}
+
+	/**
+	 * Denoise Pass
+	 */
+    {
+        RDG_GPU_STAT_SCOPE(GraphBuilder, HZBSSGI_Denoise);
+        // A-Trous迭代，步长依次为1,2,4,8，每次迭代读上一次的结果
+        const int32 NumIterations = Settings.Quality.DenoiserIterations;
+        // 迭代在两张纹理之间交替，第二次迭代起写回追踪（或上采样）的结果，原始结果和降噪结果共用同一块内存
+        // 调试视图要显示原始结果时不能覆盖它
+        const bool bPreserveRawOutput = (Settings.DebugMode == 1 || Settings.DebugMode >= 3) && ResolutionDivisor == 1;
+        FRDGTextureRef PingPongTextures[kSSGIMaxBatchedViews][2] = {};
+        for (int32 ViewIndex = 0; ViewIndex < NumViews; ViewIndex++)
+        {
+            PingPongTextures[ViewIndex][1] = bPreserveRawOutput ? nullptr : DenoisedTextures[ViewIndex];
+        }
+        TArray<FSSGITileClassification, TInlineAllocator<kSSGIMaxBatchedViews>> DenoiseTiles;
+        for (int32 ViewIndex = 0; ViewIndex < NumViews; ViewIndex++)
+        {
+            DenoiseTiles.Add(Traces[ViewIndex]->DenoiseTiles);
+        }
+        for (int32 Iteration = 0; Iteration < NumIterations; Iteration++)
+        {
+            // 每次迭代的步长对应一个Permutation
+            FSSGIDenoiserCS::FPermutationDomain PermutationVector;
+            PermutationVector.Set<FSSGIDenoiserCS::FStepSizeDim>(1 << Iteration);
+            PermutationVector.Set<FSSGIThreadGroupSizeDim>(Settings.DenoiseGroupSize);
+            PermutationVector = FSSGIDenoiserCS::RemapPermutation(PermutationVector);
+            const FIntPoint DenoiseGroupSize = GetSSGIThreadGroupSize(PermutationVector.Get<FSSGIThreadGroupSizeDim>());
+            FSSGIDenoiserCS::FParameters* DenoiserParams = GraphBuilder.AllocParameters<FSSGIDenoiserCS::FParameters>();
+            FIntVector GroupCount;
+            const bool bTiled = GetViewBatchTileParameters(GraphBuilder, DenoiseTiles, MaxViewSize, DenoiseGroupSize, DenoiserParams->BatchTiles, GroupCount);
+            PermutationVector.Set<FSSGITiledDispatchDim>(bTiled);
+            TShaderMapRef<FSSGIDenoiserCS> ComputeShader(GetGlobalShaderMap(GMaxRHIFeatureLevel), PermutationVector);
+
+            FRDGTextureSRVRef IterationInputs[kSSGIMaxBatchedViews] = {};
+            FRDGTextureUAVRef IterationOutputs[kSSGIMaxBatchedViews] = {};
+            for (int32 ViewIndex = 0; ViewIndex < NumViews; ViewIndex++)
+            {
+                FRDGTextureRef& IterationOutput = PingPongTextures[ViewIndex][Iteration & 1];
+                if (!IterationOutput)
+                {
+                    IterationOutput = GraphBuilder.CreateTexture(FullResDescs[ViewIndex], TEXT("SSGI_Denoised"));
+                    ColorChainBytes += GetSSGITextureBytes(FullResDescs[ViewIndex]);
+                }
+                IterationInputs[ViewIndex] = GraphBuilder.CreateSRV(FRDGTextureSRVDesc(DenoisedTextures[ViewIndex]));
+                IterationOutputs[ViewIndex] = GraphBuilder.CreateUAV(IterationOutput);
+            }
+            for (int32 Slot = 0; Slot < kSSGIMaxBatchedViews; Slot++)
+            {
+                const int32 ViewIndex = FMath::Min(Slot, NumViews - 1);
+                DenoiserParams->SSGIInputTextures[Slot] = IterationInputs[ViewIndex];
+                DenoiserParams->SSGIDenoiseOutputs[Slot] = IterationOutputs[ViewIndex];
+            }
+            DenoiserParams->Batch = Batch;
+            DenoiserParams->Intensity = kSSGIIntensity;
+            FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("SSGI Spatial Denoise (Step %d, %d Views%s)", 1 << Iteration, NumViews, bTiled ? TEXT(", Tiled") : TEXT("")), PassFlags, ComputeShader, DenoiserParams, GroupCount);
+            for (int32 ViewIndex = 0; ViewIndex < NumViews; ViewIndex++)
+            {
+                DenoisedTextures[ViewIndex] = PingPongTextures[ViewIndex][Iteration & 1];
+            }
+        }
+    }
+
+	SET_MEMORY_STAT(STAT_HZBSSGI_ColorChainMemory, ColorChainBytes);
+
+	for (int32 ViewIndex = 0; ViewIndex < NumViews; ViewIndex++)
+	{
+		Traces[ViewIndex]->DenoisedTexture = DenoisedTextures[ViewIndex];
+	}
+}
\ No newline at end of file
@@ -2,6 +2,139 @@
 #include "SceneViewExtension.h"
 #include "ShaderParameterStruct.h"
 #include "SceneTextureParameters.h"
+#include "RHIGPUReadback.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogHZBSSGI, Log, All);
+
+// 每个View独立的SSGI持久资源（Temporal历史等），按ViewKey索引
+struct FSSGIViewState
+{
+	TRefCountPtr<IPooledRenderTarget> HistoryRenderTarget;
+	TRefCountPtr<IPooledRenderTarget> HistoryMomentsRenderTarget;
+	TRefCountPtr<IPooledRenderTarget> HistoryCountRenderTarget;
+	// 历史中有效区域的尺寸，纹理本身可能更大（量化后的Extent）
+	FIntPoint HistoryViewSize = FIntPoint::ZeroValue;
+	// Miss回退的Irradiance探针网格：每个探针6个Ambient Cube面，以及每个槽位当前对应的格子
+	TRefCountPtr<FRDGPooledBuffer> IrradianceProbes;
+	TRefCountPtr<FRDGPooledBuffer> IrradianceProbeCells;
+	// 创建探针时的格子尺寸，尺寸变化后旧探针全部失效
+	float IrradianceCellSize = 0.0f;
+	// 轮转更新的下一个探针槽位
+	uint32 IrradianceUpdateOffset = 0;
+	// 最后一次使用的帧号，用于LRU淘汰
+	uint32 LastUsedFrame = 0;
+
+	uint64 GetMemorySize() const;
+};
+
+enum class ESSGIThreadGroupSize : int32;
+
+// Tile分类的结果，Tile尺寸等于使用它的Pass的线程组尺寸
+struct FSSGITileClassification
+{
+	ESSGIThreadGroupSize GroupSize{};
+	// 分类的网格（追踪网格或View）
+	FIntPoint GridSize = FIntPoint::ZeroValue;
+	int32 NumTiles = 0;
+	// 前段是需要计算的Tile，后段倒序是跳过的Tile
+	FRDGBufferRef TileList = nullptr;
+	// [0]需要计算的Tile数 [1]跳过的Tile数
+	FRDGBufferRef TileCounts = nullptr;
+	// 两组间接参数：需要计算的Tile和跳过的Tile
+	FRDGBufferRef DispatchArgs = nullptr;
+
+	bool IsValid() const { return TileList != nullptr; }
+};
+
+// 同一个View的各种Tile分类，按（线程组尺寸，网格）区分
+using FSSGITileClassificationArray = TArray<FSSGITileClassification, TInlineAllocator<4>>;
+
+// HZB和它覆盖的区域：单View时为ViewRect，多View批处理时为ViewFamily内所有View的并集，各View共用
+struct FSSGISharedHZB
+{
+	FRDGTextureRef Texture = nullptr;
+	FRDGTextureRef SceneDepth = nullptr;
+	FIntRect SourceRect;
+	int32 NumMips = 0;
+	// Buffer UV到HZB UV的变换，Full Extent模式为单位变换
+	FVector4f BufferUVToHZBUV = FVector4f(1.0f, 1.0f, 0.0f, 0.0f);
+	bool bCompact = false;
+	bool bHalfPrecision = false;
+	uint32 FrameNumber = 0;
+};
+
+// 几何阶段（HZB、GBuffer解码、Tile分类）的输出，只依赖深度和GBuffer
+struct FSSGIGeometryOutputs
+{
+	FIntRect ViewRect;
+	FSSGISharedHZB HZB;
+	FRDGTextureRef SSGIGBufferTexture = nullptr;
+	// 几何阶段预先分类的Tile，追踪阶段缺少的再补充
+	FSSGITileClassificationArray Tiles;
+};
+
+// GPU耗时预算控制器的档位数：0为配置的质量，每高一档再降低一项开销
+constexpr int32 kSSGIBudgetLevelCount = 7;
+
+// 一个View的SSGI在图形队列上的GPU耗时：第一个Pass之前和最后一个Pass之后的时间戳，几帧后读回
+struct FSSGIBudgetTimer
+{
+	FRHIPooledRenderQuery BeginQuery;
+	FRHIPooledRenderQuery EndQuery;
+	uint32 FrameNumber = 0;
+	// 写入时间戳时的档位，档位切换前的测量不参与决策
+	int32 Level = 0;
+	bool bEndIssued = false;
+};
+
+// 每个View每帧只能执行一次的状态变更：ViewState查找和淘汰、预算计时开始、Irradiance探针更新
+// 回退路径重新加入追踪阶段时沿用被丢弃的结果，不再重复
+struct FSSGIViewFrameState
+{
+	bool bValid = false;
+	FSSGIViewState* ViewState = nullptr;
+	// 未开启预算控制时为nullptr
+	FSSGIBudgetTimer* BudgetTimer = nullptr;
+	// 本帧已更新并排队提取的探针，未开启Irradiance缓存时为nullptr
+	FRDGBufferRef IrradianceProbes = nullptr;
+	FRDGBufferRef IrradianceProbeCells = nullptr;
+};
+
+// 追踪阶段（HZB、GBuffer解码、追踪）的输出，上采样和降噪写入DenoisedTexture，Temporal和Composite在此基础上继续
+struct FSSGITraceOutputs
+{
+	// 追踪的原始结果（TraceSize）
+	FRDGTextureRef SSGIOutputTexture = nullptr;
+	// 上采样和降噪后的结果（ViewSize），AddUpsampleDenoisePasses之前为nullptr
+	FRDGTextureRef DenoisedTexture = nullptr;
+	FRDGTextureRef SSGIGBufferTexture = nullptr;
+
+	FRDGTextureRef HistoryTexture = nullptr;
+	FRDGTextureRef HistoryMomentsTexture = nullptr;
+	FRDGTextureRef HistoryCountTexture = nullptr;
+	FRDGTextureRef VelocityTexture = nullptr;
+	FSSGIViewFrameState FrameState;
+	bool bHistoryValid = false;
+	FIntPoint HistoryExtent = FIntPoint::ZeroValue;
+	FVector2f HistoryUVScale = FVector2f(1.0f, 1.0f);
+	FVector2f HistoryUVMax = FVector2f(1.0f, 1.0f);
+
+	FIntRect ViewRect;
+	FIntPoint TraceSize = FIntPoint::ZeroValue;
+	FIntPoint TraceOffset = FIntPoint::ZeroValue;
+	int32 ResolutionDivisor = 1;
+	// 自适应光线预算跳过追踪的像素（TraceSize，R8_UINT），未开启时为nullptr
+	FRDGTextureRef SkipMaskTexture = nullptr;
+	FVector4f ViewRectMin = FVector4f::Zero();
+	FVector4f ViewSizeAndInvSize = FVector4f::Zero();
+	FVector4f BufferSizeAndInvSize = FVector4f::Zero();
+	// 上采样、降噪和Temporal使用的View Tile分类，关闭r.HZBSSGI.TileClassification时无效
+	FSSGITileClassification UpsampleTiles;
+	FSSGITileClassification DenoiseTiles;
+	FSSGITileClassification TemporalTiles;
+	// 追踪输出占用的颜色链显存，上采样和降噪在此基础上累加
+	uint64 ColorChainBytes = 0;
+};
 
 class FHZBSSGISceneViewExtension : public FSceneViewExtensionBase
 {
@@ -12,30 +145,276 @@ public:
 	virtual void SetupView(FSceneViewFamily& InViewFamily, FSceneView& InView) override {};
 	virtual void BeginRenderViewFamily(FSceneViewFamily& InViewFamily) override {};
 
+	// 异步计算：BasePass之后即把几何阶段加入AsyncCompute队列，与光照重叠
+	virtual void PostRenderBasePassDeferred_RenderThread(FRDGBuilder& GraphBuilder, FSceneView& InView, const FRenderTargetBindingSlots& RenderTargets, TRDGUniformBufferRef<FSceneTextureUniformParameters> SceneTextures) override;
+	// SceneColor就绪后加入ViewFamily内所有View的追踪、上采样、降噪，异步计算时在AsyncCompute队列上，在Temporal之前汇合
+	virtual void PrePostProcessPass_RenderThread(FRDGBuilder& GraphBuilder, const FSceneView& View, const FPostProcessingInputs& Inputs) override;
+	virtual void PostRenderViewFamily_RenderThread(FRDGBuilder& GraphBuilder, FSceneViewFamily& InViewFamily) override;
+
 	virtual void SubscribeToPostProcessingPass(EPostProcessingPass PassId, const FSceneView& View, FAfterPassCallbackDelegateArray& InOutPassCallbacks, bool bIsPassEnabled) override ;
 	FScreenPassTexture HZBSSGIProcessPass(FRDGBuilder& GraphBuilder, const FSceneView& View, const FPostProcessMaterialInputs& Inputs);
+
+	// 自动化测试用：在一个独立的GraphBuilder里为View加入几何、追踪、上采样和降噪阶段，返回两段的渲染线程耗时（Cycles64）
+	// 不读写ViewState和预算计时；结果没有消费者，Execute时由RDG裁剪
+	void AddSetupBenchmarkPasses(FRDGBuilder& GraphBuilder, const FSceneView& View, TRDGUniformBufferRef<FSceneTextureUniformParameters> SceneTexturesUniformBuffer, FRDGTextureRef SceneDepth, FRDGTextureSRVRef SceneColorSRV, const FIntRect& ViewRect, uint64& OutGeometryCycles, uint64& OutTraceCycles);
 private:
-	TRefCountPtr<IPooledRenderTarget> HistoryRenderTarget;
+	// 几何阶段的所有Pass：HZB、GBuffer解码和Tile分类，PassFlags为Compute或AsyncCompute
+	// SceneTexturesUniformBuffer为空时自行创建
+	void AddGeometryPasses(FRDGBuilder& GraphBuilder, const FSceneView& View, TRDGUniformBufferRef<FSceneTextureUniformParameters> SceneTexturesUniformBuffer, FRDGTextureRef SceneDepth, const FIntRect& ViewRect, ERDGPassFlags PassFlags, FSSGIGeometryOutputs& OutGeometry);
+	// 追踪阶段的所有Pass，PassFlags为Compute或AsyncCompute
+	// Geometry为空或ViewRect不一致时先在同一个队列上加入几何阶段
+	// FrameState有效时沿用其中的状态变更，否则本次执行并写入OutTrace.FrameState
+	void AddTracePasses(FRDGBuilder& GraphBuilder, const FSceneView& View, TRDGUniformBufferRef<FSceneTextureUniformParameters> SceneTexturesUniformBuffer, FRDGTextureRef SceneDepth, FRDGTextureSRVRef SceneColorSRV, const FIntRect& ViewRect, const FSSGIGeometryOutputs* Geometry, const FSSGIViewFrameState& FrameState, ERDGPassFlags PassFlags, FSSGITraceOutputs& OutTrace);
+	// 上采样和降噪，写入每个Trace的DenoisedTexture；Traces最多kSSGIMaxBatchedViews个，每个Pass只Dispatch一次
+	// 开启Tile分类时每个View按自己的Tile列表，跳过的Tile在同一个Dispatch中写0
+	void AddUpsampleDenoisePasses(FRDGBuilder& GraphBuilder, TConstArrayView<FSSGITraceOutputs*> Traces, ERDGPassFlags PassFlags);
+
+	// 返回覆盖SourceRect的HZB，同一帧内已有相同的HZB时直接复用
+	FSSGISharedHZB FindOrAddHZB(FRDGBuilder& GraphBuilder, FRDGTextureRef SceneDepth, const FIntRect& SourceRect, bool bCompact, bool bHalfPrecision, uint32 FrameNumber, ERDGPassFlags PassFlags);
+
+	// 返回当前View的持久资源，View没有ViewState时返回nullptr（不做时间累积）
+	FSSGIViewState* FindOrAddViewState(const FSceneView& View);
+	// 淘汰长时间未使用的View，以及超出数量上限时最久未使用的View
+	void EvictStaleViewStates(uint32 FrameNumber);
+
+	// 只在渲染线程访问。值用TUniquePtr保存，保证QueueTextureExtraction拿到的指针在Map扩容后依然有效
+	TMap<uint32, TUniquePtr<FSSGIViewState>> ViewStates;
+	// 追踪统计（光线数、命中数、迭代次数）的GPU回读，每个View一个，环形使用，结果延迟几帧
+	static constexpr int32 kTraceStatsReadbackCount = 16;
+	TUniquePtr<FRHIGPUBufferReadback> TraceStatsReadbacks[kTraceStatsReadbackCount];
+	bool bTraceStatsPending[kTraceStatsReadbackCount] = {};
+	uint32 TraceStatsFrameNumbers[kTraceStatsReadbackCount] = {};
+	// 有View没拿到回读对象的帧，合计不完整，不输出
+	uint32 TraceStatsIncompleteFrame = 0;
+	bool bTraceStatsHasIncompleteFrame = false;
+
+	// 按帧合计所有View的回读，早于当前帧且回读全部完成的帧输出到Stat和CSV
+	void ProcessTraceStatsReadbacks(uint32 CurrentFrameNumber);
+	// 返回一个空闲的回读对象，全部在等待GPU时返回nullptr（这一帧不统计）
+	FRHIGPUBufferReadback* AcquireTraceStatsReadback(uint32 FrameNumber);
+
+	// PostRenderBasePassDeferred中异步加入、等待追踪阶段消费的几何结果，只在同一个GraphBuilder内有效
+	TMap<const FSceneView*, FSSGIGeometryOutputs> PendingGeometry;
+	// PrePostProcessPass中异步加入、等待BeforeDOF回调消费的追踪结果，只在同一个GraphBuilder内有效
+	TMap<const FSceneView*, FSSGITraceOutputs> PendingTraces;
+	// 本帧已构建的HZB，ViewFamily内的后续View复用，只在同一个GraphBuilder内有效
+	TArray<FSSGISharedHZB, TInlineAllocator<2>> SharedHZBs;
+
+	// 开启r.HZBSSGI.Budget.TargetMs时在追踪阶段之前写入开始时间戳，返回的计时器在Composite之后结束
+	FSSGIBudgetTimer* BeginBudgetTimer(FRDGBuilder& GraphBuilder, uint32 FrameNumber);
+	void EndBudgetTimer(FRDGBuilder& GraphBuilder, FSSGIBudgetTimer* Timer);
+	// 读取已完成的计时器，按帧汇总后调整档位，并输出到Stat和CSV
+	void ProcessBudgetTimers(uint32 FrameNumber);
+
+	// 按提交顺序排列，读回或丢弃之前查询对象一直有效
+	TArray<TUniquePtr<FSSGIBudgetTimer>> BudgetTimers;
+	FRenderQueryPoolRHIRef BudgetQueryPool;
+	// 每个档位最近一次测得的耗时（平滑后）和测量的帧号，0表示未测量
+	float BudgetLevelCostMs[kSSGIBudgetLevelCount] = {};
+	uint32 BudgetLevelCostFrame[kSSGIBudgetLevelCount] = {};
+	// 当前档位已经测量的帧数
+	int32 BudgetFramesAtLevel = 0;
 };
 
+// 线程组尺寸的Permutation，逐像素的Pass按平台/分辨率选择占用率最好的一档
+enum class ESSGIThreadGroupSize : int32
+{
+	Size8x8,
+	Size16x16,
+	Size8x4,
+	MAX
+};
+
+inline FIntPoint GetSSGIThreadGroupSize(ESSGIThreadGroupSize GroupSize)
+{
+	switch (GroupSize)
+	{
+		case ESSGIThreadGroupSize::Size16x16: return FIntPoint(16, 16);
+		case ESSGIThreadGroupSize::Size8x4:   return FIntPoint(8, 4);
+		default:                              return FIntPoint(8, 8);
+	}
+}
+
+inline void SetSSGIThreadGroupDefines(ESSGIThreadGroupSize GroupSize, FShaderCompilerEnvironment& OutEnvironment)
+{
+	const FIntPoint ThreadGroupSize = GetSSGIThreadGroupSize(GroupSize);
+	OutEnvironment.SetDefine(TEXT("THREADS_X"), ThreadGroupSize.X);
+	OutEnvironment.SetDefine(TEXT("THREADS_Y"), ThreadGroupSize.Y);
+	OutEnvironment.SetDefine(TEXT("THREADS_Z"), 1);
+}
+
+class FSSGIThreadGroupSizeDim : SHADER_PERMUTATION_ENUM_CLASS("SSGI_THREAD_GROUP_SIZE", ESSGIThreadGroupSize);
+
+// Tile分类后按Tile列表间接Dispatch，跳过全是天空/Unlit的Tile
+class FSSGITiledDispatchDim : SHADER_PERMUTATION_BOOL("SSGI_TILED_DISPATCH");
+
+// 间接Dispatch的线程组数超过该值时折叠到Y
+constexpr int32 kSSGITileDispatchWrap = 32768;
+
+inline void SetSSGITileDispatchDefines(FShaderCompilerEnvironment& OutEnvironment)
+{
+	OutEnvironment.SetDefine(TEXT("SSGI_TILE_DISPATCH_WRAP"), kSSGITileDispatchWrap);
+}
+
+// 按Tile列表间接Dispatch的参数，对应SSGITileCommon.ush
+BEGIN_SHADER_PARAMETER_STRUCT(FSSGITileDispatchParameters, )
+	SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<uint>, SSGITileList)
+	SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<uint>, SSGITileCounts)
+	RDG_BUFFER_ACCESS(IndirectArgs, ERHIAccess::IndirectArgs)
+END_SHADER_PARAMETER_STRUCT()
+
+// 自适应光线预算跳过追踪的像素，对应SSGISkipMask.ush
+BEGIN_SHADER_PARAMETER_STRUCT(FSSGISkipMaskParameters, )
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D<uint>, SSGISkipMask)
+	SHADER_PARAMETER(FIntPoint, SkipMaskTraceSize)
+	SHADER_PARAMETER(FIntPoint, SkipMaskTraceOffset)
+	SHADER_PARAMETER(int32, SkipMaskDivisor)
+	SHADER_PARAMETER(int32, bSkipMaskValid)
+END_SHADER_PARAMETER_STRUCT()
+
+// 上采样和降噪一次Dispatch处理的最大View数（双眼、最多四人分屏），SV_GroupID.z为View序号
+constexpr int32 kSSGIMaxBatchedViews = 4;
+
+// 上采样和降噪的多View参数，对应SSGIViewBatch.ush；空余的槽位绑定最后一个View的纹理
+BEGIN_SHADER_PARAMETER_STRUCT(FSSGIViewBatchParameters, )
+	SHADER_PARAMETER_RDG_TEXTURE_SRV_ARRAY(Texture2D<uint2>, SSGIGBufferTextures, [kSSGIMaxBatchedViews])
+	SHADER_PARAMETER_RDG_TEXTURE_SRV_ARRAY(Texture2D<uint>, SSGISkipMasks, [kSSGIMaxBatchedViews])
+	SHADER_PARAMETER_ARRAY(FVector4f, BatchViewSizeAndInvSize, [kSSGIMaxBatchedViews])
+	// xy: 追踪网格尺寸 zw: 追踪像素在块内的偏移
+	SHADER_PARAMETER_ARRAY(FIntVector4, BatchTraceSizeAndOffset, [kSSGIMaxBatchedViews])
+	SHADER_PARAMETER_ARRAY(FIntVector4, BatchSkipMaskValid, [kSSGIMaxBatchedViews])
+	SHADER_PARAMETER(int32, ResolutionDivisor)
+END_SHADER_PARAMETER_STRUCT()
+
+// 批处理时每个View的Tile分类，对应SSGIViewBatch.ush；按Tile列表直接Dispatch，不使用间接参数
+BEGIN_SHADER_PARAMETER_STRUCT(FSSGIViewBatchTileParameters, )
+	SHADER_PARAMETER_RDG_BUFFER_SRV_ARRAY(Buffer<uint>, SSGIBatchTileLists, [kSSGIMaxBatchedViews])
+	SHADER_PARAMETER_RDG_BUFFER_SRV_ARRAY(Buffer<uint>, SSGIBatchTileCounts, [kSSGIMaxBatchedViews])
+END_SHADER_PARAMETER_STRUCT()
+
+// 单Pass生成HZB的整条Mip链，支持的最大Mip数（14级对应Mip0最大8192）
+// 更大的Buffer只生成前14级，最粗的一级大于1x1，追踪的MaxMipLevel随之降低
+constexpr int32 kHZBMaxMipCount = 14;
+
 class SCENEVIEWEXTENSIONTEMPLATE_API FHZBBuildCS : public FGlobalShader
 {
 public:
 	DECLARE_GLOBAL_SHADER(FHZBBuildCS)
 	SHADER_USE_PARAMETER_STRUCT(FHZBBuildCS, FGlobalShader)
 
+	class FCompactDim : SHADER_PERMUTATION_BOOL("HZB_COMPACT");
+	class FHalfPrecisionDim : SHADER_PERMUTATION_BOOL("HZB_HALF_PRECISION");
+	using FPermutationDomain = TShaderPermutationDomain<FCompactDim, FHalfPrecisionDim>;
+
 	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
-		SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, InputDepthTexture)
-		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float>, OutputDepthTexture)
-		SHADER_PARAMETER(FVector2f, InputViewportMaxBound)
-		SHADER_PARAMETER(FVector2f, OutputViewportSize)
+		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, SceneDepthTexture)
+		SHADER_PARAMETER_RDG_TEXTURE_UAV_ARRAY(RWTexture2D<float>, OutputDepthMip, [kHZBMaxMipCount])
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, AtomicCounter)
+		SHADER_PARAMETER(FUintVector2, HZBMip0Size)
+		SHADER_PARAMETER(FUintVector2, SourceViewMin)
+		SHADER_PARAMETER(FUintVector2, SourceViewMax)
+		SHADER_PARAMETER(FVector2f, SourceScale)
+		SHADER_PARAMETER(uint32, NumMips)
+		SHADER_PARAMETER(uint32, NumGroups)
 	END_SHADER_PARAMETER_STRUCT()
 
 	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
 	{
+		FPermutationDomain PermutationVector(Parameters.PermutationId);
+		// R16F只在Compact模式下可选
+		if (PermutationVector.Get<FHalfPrecisionDim>() && !PermutationVector.Get<FCompactDim>())
+		{
+			return false;
+		}
 		return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
 	}
 
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		// 一个线程组256个线程，负责Mip0上64x64的Tile
+		OutEnvironment.SetDefine(TEXT("THREADS_X"), 16);
+		OutEnvironment.SetDefine(TEXT("THREADS_Y"), 16);
+		OutEnvironment.SetDefine(TEXT("THREADS_Z"), 1);
+		OutEnvironment.SetDefine(TEXT("HZB_MAX_MIPS"), kHZBMaxMipCount);
+	}
+};
+
+// GBuffer预解码：法线 + 线性深度 + 天空标记，供后续所有SSGI Pass共用
+class SCENEVIEWEXTENSIONTEMPLATE_API FSSGIGBufferDecodeCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FSSGIGBufferDecodeCS);
+	SHADER_USE_PARAMETER_STRUCT(FSSGIGBufferDecodeCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, SceneDepthTexture)
+		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, GBufferATexture)
+		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, GBufferBTexture)
+		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<uint2>, SSGIGBufferOutput)
+		SHADER_PARAMETER(FVector4f, ViewSizeAndInvSize)
+		SHADER_PARAMETER(FVector4f, ViewRectMin)
+		SHADER_PARAMETER_STRUCT_REF(FViewUniformShaderParameters, View)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADS_X"), 8);
+		OutEnvironment.SetDefine(TEXT("THREADS_Y"), 8);
+		OutEnvironment.SetDefine(TEXT("THREADS_Z"), 1);
+	}
+};
+
+// 命中着色的预过滤Radiance：Mip0为View尺寸的一半，足迹超过2^(MaxMips)个像素的命中也只读到最后一级
+constexpr int32 kSSGIRadianceCacheMaxMips = 6;
+
+// RadianceCache的Mip0：SceneColor + 重投影的上一帧GI，2x2像素的Karis平均
+class SCENEVIEWEXTENSIONTEMPLATE_API FSSGIRadianceCacheInitCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FSSGIRadianceCacheInitCS);
+	SHADER_USE_PARAMETER_STRUCT(FSSGIRadianceCacheInitCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, SceneColorTexture)
+		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, HistoryTexture)
+		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, VelocityTexture)
+		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float4>, OutputMip)
+		SHADER_PARAMETER(FIntPoint, OutputMipSize)
+		SHADER_PARAMETER(FVector2f, HistoryUVScale)
+		SHADER_PARAMETER(FVector2f, HistoryUVMax)
+		SHADER_PARAMETER(int, bHistoryValid)
+		SHADER_PARAMETER(float, MultiBounceWeight)
+		SHADER_PARAMETER(FVector4f, ViewSizeAndInvSize)
+		SHADER_PARAMETER(FVector4f, BufferSizeAndInvSize)
+		SHADER_PARAMETER(FVector4f, ViewRectMin)
+		SHADER_PARAMETER_SAMPLER(SamplerState, BilinearSampler)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("THREADS_X"), 8);
+		OutEnvironment.SetDefine(TEXT("THREADS_Y"), 8);
+		OutEnvironment.SetDefine(TEXT("THREADS_Z"), 1);
+	}
+};
+
+// RadianceCache的Mip N：上一级的2x2平均
+class SCENEVIEWEXTENSIONTEMPLATE_API FSSGIRadianceCacheDownsampleCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FSSGIRadianceCacheDownsampleCS);
+	SHADER_USE_PARAMETER_STRUCT(FSSGIRadianceCacheDownsampleCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, ParentMipTexture)
+		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float4>, OutputMip)
+		SHADER_PARAMETER(FIntPoint, ParentMipSize)
+		SHADER_PARAMETER(FIntPoint, OutputMipSize)
+	END_SHADER_PARAMETER_STRUCT()
+
 	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
 	{
 		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
@@ -45,43 +424,322 @@ public:
 	}
 };
 
+// SSGI追踪Pass共用的参数，对应SSGICommon.ush
+BEGIN_SHADER_PARAMETER_STRUCT(FSSGITraceCommonParameters, )
+	// Textures
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D, HZBTexture)
+	SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, SceneColorTexture)
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D<uint2>, SSGIGBufferTexture)
+	
+	// GBuffer Textures
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D, SSGI_GBufferB)
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D, SSGI_GBufferC)
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D, RadianceCacheTexture)
+
+	// Settings
+	SHADER_PARAMETER(FVector4f, HZBSize)
+	SHADER_PARAMETER(FVector4f, BufferUVToHZBUV)
+	SHADER_PARAMETER(int, MaxMipLevel)
+	SHADER_PARAMETER(int, MaxIterations)
+	SHADER_PARAMETER(float, Thickness)
+	SHADER_PARAMETER(float, RayLength)
+	SHADER_PARAMETER(float, Intensity)
+	SHADER_PARAMETER(int, FrameIndex)
+	SHADER_PARAMETER(int, SamplingMode)
+	SHADER_PARAMETER(int, SequenceFrameIndex)
+	SHADER_PARAMETER(int, bUseRadianceCache)
+	SHADER_PARAMETER(FVector2f, RadianceCacheUVScale)
+	SHADER_PARAMETER(float, RadianceCacheMaxMip)
+	SHADER_PARAMETER(float, RadianceCacheFootprintScale)
+	SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<float4>, IrradianceProbes)
+	SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<uint>, IrradianceProbeCells)
+	SHADER_PARAMETER(int, bUseIrradianceCache)
+	SHADER_PARAMETER(FIntVector, IrradianceGridSize)
+	SHADER_PARAMETER(FIntVector, IrradianceGridOrigin)
+	SHADER_PARAMETER(FVector3f, IrradianceGridOriginTranslated)
+	SHADER_PARAMETER(float, IrradianceCellSize)
+
+	// Adaptive Ray Budget
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D, HistoryTexture)
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D, HistoryMomentsTexture)
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D, HistoryCountTexture)
+	SHADER_PARAMETER_RDG_TEXTURE(Texture2D, VelocityTexture)
+	SHADER_PARAMETER(FVector2f, HistoryUVScale)
+	SHADER_PARAMETER(FVector2f, HistoryUVMax)
+	SHADER_PARAMETER(int, bHistoryValid)
+	SHADER_PARAMETER(float, AdaptiveConvergedCount)
+	SHADER_PARAMETER(int, AdaptiveSkipInterval)
+	SHADER_PARAMETER(float, AdaptiveVarianceThreshold)
+
+	SHADER_PARAMETER(FVector4f, ViewRectMin)
+	SHADER_PARAMETER(FVector4f, ViewSizeAndInvSize)
+	SHADER_PARAMETER(FVector4f, BufferSizeAndInvSize)
+	SHADER_PARAMETER(FIntPoint, TraceSize)
+	SHADER_PARAMETER(FIntPoint, TraceOffset)
+	SHADER_PARAMETER(int, ResolutionDivisor)
+	SHADER_PARAMETER(FMatrix44f, SVPositionToTranslatedWorld)
+	SHADER_PARAMETER(FMatrix44f, TranslatedWorldToClip)
+
+	SHADER_PARAMETER_STRUCT_REF(FViewUniformShaderParameters, View)
+END_SHADER_PARAMETER_STRUCT()
+
+// Miss回退的Irradiance探针网格：相机周围XY x XY x Z个格子，环形寻址，网格随相机按整格滚动
+constexpr int32 kSSGIIrradianceGridSizeXY = 32;
+constexpr int32 kSSGIIrradianceGridSizeZ = 16;
+// 每个探针每次更新追踪的光线数（一个线程组）
+constexpr int32 kSSGIIrradianceProbeRayCount = 64;
+
+// 轮转更新一部分探针：从探针位置向球面均匀发射光线做屏幕空间追踪，命中点从RadianceCache着色
+class SCENEVIEWEXTENSIONTEMPLATE_API FSSGIIrradianceProbeUpdateCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FSSGIIrradianceProbeUpdateCS);
+	SHADER_USE_PARAMETER_STRUCT(FSSGIIrradianceProbeUpdateCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_STRUCT_INCLUDE(FSSGITraceCommonParameters, Common)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<float4>, RWIrradianceProbes)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWIrradianceProbeCells)
+		SHADER_PARAMETER(uint32, ProbeUpdateOffset)
+		SHADER_PARAMETER(float, ProbeMaxSampleCount)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("PROBE_RAY_COUNT"), kSSGIIrradianceProbeRayCount);
+	}
+};
+
 class SCENEVIEWEXTENSIONTEMPLATE_API FSSGICS : public FGlobalShader
 {
 public:
 	DECLARE_GLOBAL_SHADER(FSSGICS);
 	SHADER_USE_PARAMETER_STRUCT(FSSGICS, FGlobalShader);
 
+	// 每像素光线数（自适应时为上限），固定光线数时循环在编译期展开
+	class FSampleCountDim : SHADER_PERMUTATION_SPARSE_INT("SSGI_SAMPLE_COUNT", 1, 2, 4, 8);
+	class FAdaptiveRayBudgetDim : SHADER_PERMUTATION_BOOL("SSGI_ADAPTIVE_RAY_BUDGET");
+	class FDebugDim : SHADER_PERMUTATION_BOOL("SSGI_DEBUG");
+	using FPermutationDomain = TShaderPermutationDomain<FSampleCountDim, FAdaptiveRayBudgetDim, FSSGIThreadGroupSizeDim, FDebugDim, FSSGITiledDispatchDim>;
+
+	// 调试Permutation只编译默认的8x8线程组
+	static FPermutationDomain RemapPermutation(FPermutationDomain PermutationVector)
+	{
+		if (PermutationVector.Get<FDebugDim>())
+		{
+			PermutationVector.Set<FSSGIThreadGroupSizeDim>(ESSGIThreadGroupSize::Size8x8);
+		}
+		return PermutationVector;
+	}
+
 	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
-		// Textures
-		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, HZBTexture)
-		SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, SceneColorTexture)
-		SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, InputSceneDepthTexture)
-		
-		// GBuffer Textures
-		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, SSGI_GBufferA)
-		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, SSGI_GBufferB)
-		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, SSGI_GBufferC)
-
-		// Settings
-		SHADER_PARAMETER(FVector4f, HZBSize)
-		SHADER_PARAMETER(int, MaxMipLevel)
-		SHADER_PARAMETER(int, MaxIterations)
-		SHADER_PARAMETER(float, Thickness)
-		SHADER_PARAMETER(float, RayLength)
-		SHADER_PARAMETER(float, Intensity)
-		//SHADER_PARAMETER(int, DebugMode)
-		SHADER_PARAMETER(int, FrameIndex)
-	
+		SHADER_PARAMETER_STRUCT_INCLUDE(FSSGITraceCommonParameters, Common)
+		SHADER_PARAMETER_STRUCT_INCLUDE(FSSGITileDispatchParameters, Tiles)
+		SHADER_PARAMETER(int, DebugMode)
+
 		// Output
 		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float4>, SSGI_Raw_Output)
+		// 只在自适应光线预算的Permutation中使用
+		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<uint>, RWSSGISkipMask)
+		// 只在调试Permutation中使用
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWTraceStats)
+	END_SHADER_PARAMETER_STRUCT()
 
-		SHADER_PARAMETER(FVector4f, ViewRectMin)
-		SHADER_PARAMETER(FVector4f, ViewSizeAndInvSize)
-		SHADER_PARAMETER(FVector4f, BufferSizeAndInvSize)
-		SHADER_PARAMETER(FMatrix44f, SVPositionToTranslatedWorld)
-		SHADER_PARAMETER(FMatrix44f, TranslatedWorldToClip)
-	
-		SHADER_PARAMETER_STRUCT_REF(FViewUniformShaderParameters, View)
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		FPermutationDomain PermutationVector(Parameters.PermutationId);
+		return RemapPermutation(PermutationVector) == PermutationVector;
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		FPermutationDomain PermutationVector(Parameters.PermutationId);
+		SetSSGIThreadGroupDefines(PermutationVector.Get<FSSGIThreadGroupSizeDim>(), OutEnvironment);
+		SetSSGITileDispatchDefines(OutEnvironment);
+	}
+};
+
+// 排序追踪：每个桶覆盖的追踪像素Tile尺寸，每个Tile按屏幕空间方向分8个桶
+constexpr int32 kSSGISortedTraceTileSize = 16;
+constexpr int32 kSSGISortedTraceOctantCount = 8;
+// 一维Dispatch的线程组大小，线程组数超过kSSGISortedTraceGroupWrap时折叠到Y
+constexpr int32 kSSGISortedTraceThreads = 64;
+constexpr int32 kSSGISortedTraceGroupWrap = 32768;
+
+inline void SetSSGISortedTraceDefines(FShaderCompilerEnvironment& OutEnvironment)
+{
+	SetSSGIThreadGroupDefines(ESSGIThreadGroupSize::Size8x8, OutEnvironment);
+	OutEnvironment.SetDefine(TEXT("SORTED_TRACE_TILE_SIZE"), kSSGISortedTraceTileSize);
+	OutEnvironment.SetDefine(TEXT("SORTED_TRACE_GROUP_WRAP"), kSSGISortedTraceGroupWrap);
+}
+
+// 排序追踪第1步：生成光线并按（Tile, 方向八分区）分桶计数
+class SCENEVIEWEXTENSIONTEMPLATE_API FSSGIRayGenCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FSSGIRayGenCS);
+	SHADER_USE_PARAMETER_STRUCT(FSSGIRayGenCS, FGlobalShader);
+
+	using FPermutationDomain = TShaderPermutationDomain<FSSGICS::FSampleCountDim, FSSGICS::FAdaptiveRayBudgetDim>;
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_STRUCT_INCLUDE(FSSGITraceCommonParameters, Common)
+		SHADER_PARAMETER(uint32, NumTilesX)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint2>, RWRayBins)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBinCounts)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWPixelRayCount)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<float4>, RWRayResults)
+		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float4>, SSGI_Raw_Output)
+		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<uint>, RWSSGISkipMask)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		SetSSGISortedTraceDefines(OutEnvironment);
+	}
+};
+
+// 排序追踪第2步：桶的前缀和（单个线程组），同时写出追踪Pass的间接参数
+class SCENEVIEWEXTENSIONTEMPLATE_API FSSGIBinPrefixSumCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FSSGIBinPrefixSumCS);
+	SHADER_USE_PARAMETER_STRUCT(FSSGIBinPrefixSumCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<uint>, BinCounts)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWBinOffsets)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWSortedTraceArgs)
+		SHADER_PARAMETER(uint32, NumBins)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		SetSSGISortedTraceDefines(OutEnvironment);
+	}
+};
+
+// 排序追踪第3步：把光线编号写到桶内的排序位置
+class SCENEVIEWEXTENSIONTEMPLATE_API FSSGIRayScatterCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FSSGIRayScatterCS);
+	SHADER_USE_PARAMETER_STRUCT(FSSGIRayScatterCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<uint2>, RayBins)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<uint>, BinOffsets)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<uint>, PixelRayCount)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWSortedRayIndices)
+		SHADER_PARAMETER(uint32, NumRays)
+		SHADER_PARAMETER(uint32, RaySlotsPerPixel)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		SetSSGISortedTraceDefines(OutEnvironment);
+	}
+};
+
+// 排序追踪第4步：按排序后的顺序追踪，间接Dispatch，线程数等于有效光线数
+class SCENEVIEWEXTENSIONTEMPLATE_API FSSGISortedTraceCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FSSGISortedTraceCS);
+	SHADER_USE_PARAMETER_STRUCT(FSSGISortedTraceCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_STRUCT_INCLUDE(FSSGITraceCommonParameters, Common)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<uint>, BinOffsets)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<uint>, SortedRayIndices)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<float4>, RWRayResults)
+		SHADER_PARAMETER(uint32, NumBins)
+		SHADER_PARAMETER(uint32, RaySlotsPerPixel)
+		RDG_BUFFER_ACCESS(IndirectArgs, ERHIAccess::IndirectArgs)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		SetSSGISortedTraceDefines(OutEnvironment);
+	}
+};
+
+// 排序追踪第4步的持久线程版本：固定数量的线程组从排序后的光线队列取光线，结束的Lane重新取光线
+// 需要Wave指令，不支持的平台使用FSSGISortedTraceCS
+class SCENEVIEWEXTENSIONTEMPLATE_API FSSGIPersistentTraceCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FSSGIPersistentTraceCS);
+	SHADER_USE_PARAMETER_STRUCT(FSSGIPersistentTraceCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_STRUCT_INCLUDE(FSSGITraceCommonParameters, Common)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<uint>, BinOffsets)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<uint>, SortedRayIndices)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<float4>, RWRayResults)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWRayQueueCounter)
+		SHADER_PARAMETER(uint32, NumBins)
+		SHADER_PARAMETER(uint32, RaySlotsPerPixel)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		return RHISupportsWaveOperations(Parameters.Platform);
+	}
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		SetSSGISortedTraceDefines(OutEnvironment);
+		OutEnvironment.SetDefine(TEXT("PERSISTENT_TRACE"), 1);
+		OutEnvironment.CompilerFlags.Add(CFLAG_WaveOperations);
+	}
+};
+
+// 排序追踪第5步：逐像素累加光线的结果，写回SSGI_Raw_Output
+class SCENEVIEWEXTENSIONTEMPLATE_API FSSGIRayResolveCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FSSGIRayResolveCS);
+	SHADER_USE_PARAMETER_STRUCT(FSSGIRayResolveCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_STRUCT_INCLUDE(FSSGITraceCommonParameters, Common)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<uint>, PixelRayCount)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<float4>, RayResults)
+		SHADER_PARAMETER(uint32, RaySlotsPerPixel)
+		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float4>, SSGI_Raw_Output)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		SetSSGISortedTraceDefines(OutEnvironment);
+	}
+};
+
+// 降分辨率追踪后的联合双边上采样
+class SCENEVIEWEXTENSIONTEMPLATE_API FSSGIUpsampleCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FSSGIUpsampleCS);
+	SHADER_USE_PARAMETER_STRUCT(FSSGIUpsampleCS, FGlobalShader);
+
+	using FPermutationDomain = TShaderPermutationDomain<FSSGITiledDispatchDim>;
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_RDG_TEXTURE_SRV_ARRAY(Texture2D, SSGILowResTextures, [kSSGIMaxBatchedViews])
+		SHADER_PARAMETER_RDG_TEXTURE_UAV_ARRAY(RWTexture2D<float4>, SSGIUpsampleOutputs, [kSSGIMaxBatchedViews])
+		SHADER_PARAMETER_STRUCT_INCLUDE(FSSGIViewBatchParameters, Batch)
+		SHADER_PARAMETER_STRUCT_INCLUDE(FSSGIViewBatchTileParameters, BatchTiles)
+		SHADER_PARAMETER(float, DepthSigma)
+		SHADER_PARAMETER(float, NormalPower)
 	END_SHADER_PARAMETER_STRUCT()
 
 	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
@@ -90,6 +748,7 @@ public:
 		OutEnvironment.SetDefine(TEXT("THREADS_X"), 8);
 		OutEnvironment.SetDefine(TEXT("THREADS_Y"), 8);
 		OutEnvironment.SetDefine(TEXT("THREADS_Z"), 1);
+		SetSSGITileDispatchDefines(OutEnvironment);
 	}
 };
 
@@ -104,6 +763,8 @@ public:
 		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, SceneColorTexture)
 		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, SSGIResultTexture)
 		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float4>, OutputTexture)
+		SHADER_PARAMETER(FIntPoint, OutputOffset)
+		SHADER_PARAMETER(FVector2f, SSGIResultUVScale)
 		SHADER_PARAMETER(FVector4f, ViewSizeAndInvSize)
 		SHADER_PARAMETER(FVector4f, BufferSizeAndInvSize)
 		SHADER_PARAMETER(FVector4f, ViewRectMin)
@@ -117,29 +778,50 @@ public:
 		OutEnvironment.SetDefine(TEXT("THREADS_Z"), 1);
 	}
 };
+// A-Trous降噪的最大迭代次数，步长为1,2,4,8，每个步长一个Permutation
+constexpr int32 kDenoiserMaxIterations = 4;
+
 class SCENEVIEWEXTENSIONTEMPLATE_API FSSGIDenoiserCS : public FGlobalShader
 {
 public:
 	DECLARE_GLOBAL_SHADER(FSSGIDenoiserCS);
 	SHADER_USE_PARAMETER_STRUCT(FSSGIDenoiserCS, FGlobalShader);
 
+	// 步长决定groupshared中Apron的大小，编译期确定后小步长的迭代占用更少的LDS
+	class FStepSizeDim : SHADER_PERMUTATION_SPARSE_INT("DENOISER_STEP_SIZE", 1, 2, 4, 8);
+	using FPermutationDomain = TShaderPermutationDomain<FStepSizeDim, FSSGIThreadGroupSizeDim, FSSGITiledDispatchDim>;
+
 	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
-		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, SSGIInputTexture)
-		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, SceneDepthTexture)
-		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, GBufferATexture)
-		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float4>, SSGIDenoiseOutput)
-		SHADER_PARAMETER(FVector4f, ViewSizeAndInvSize)
-		SHADER_PARAMETER(FVector4f, BufferSizeAndInvSize)
-		SHADER_PARAMETER(FVector4f, ViewRectMin)
+		SHADER_PARAMETER_RDG_TEXTURE_SRV_ARRAY(Texture2D, SSGIInputTextures, [kSSGIMaxBatchedViews])
+		SHADER_PARAMETER_RDG_TEXTURE_UAV_ARRAY(RWTexture2D<float4>, SSGIDenoiseOutputs, [kSSGIMaxBatchedViews])
+		SHADER_PARAMETER_STRUCT_INCLUDE(FSSGIViewBatchParameters, Batch)
+		SHADER_PARAMETER_STRUCT_INCLUDE(FSSGIViewBatchTileParameters, BatchTiles)
 		SHADER_PARAMETER(float, Intensity)
 	END_SHADER_PARAMETER_STRUCT()
 
+	// groupshared的Tile是正方形，不支持8x4
+	static FPermutationDomain RemapPermutation(FPermutationDomain PermutationVector)
+	{
+		if (PermutationVector.Get<FSSGIThreadGroupSizeDim>() == ESSGIThreadGroupSize::Size8x4)
+		{
+			PermutationVector.Set<FSSGIThreadGroupSizeDim>(ESSGIThreadGroupSize::Size8x8);
+		}
+		return PermutationVector;
+	}
+
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		FPermutationDomain PermutationVector(Parameters.PermutationId);
+		return RemapPermutation(PermutationVector) == PermutationVector;
+	}
+
 	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
 	{
 		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
-		OutEnvironment.SetDefine(TEXT("THREADS_X"), 8);
-		OutEnvironment.SetDefine(TEXT("THREADS_Y"), 8);
-		OutEnvironment.SetDefine(TEXT("THREADS_Z"), 1);
+		// groupshared中缓存Tile和本次步长的Apron
+		FPermutationDomain PermutationVector(Parameters.PermutationId);
+		SetSSGIThreadGroupDefines(PermutationVector.Get<FSSGIThreadGroupSizeDim>(), OutEnvironment);
+		SetSSGITileDispatchDefines(OutEnvironment);
 	}
 };
 class SCENEVIEWEXTENSIONTEMPLATE_API FSSGITemporalCS : public FGlobalShader
@@ -148,23 +830,126 @@ public:
 	DECLARE_GLOBAL_SHADER(FSSGITemporalCS);
 	SHADER_USE_PARAMETER_STRUCT(FSSGITemporalCS, FGlobalShader);
 
+	// 邻域Clamp统计的半径：1为3x3，2为5x5
+	class FKernelRadiusDim : SHADER_PERMUTATION_RANGE_INT("TEMPORAL_KERNEL_RADIUS", 1, 2);
+	// 同时完成Composite，把SceneColor + GI直接写入后处理的输出
+	class FCompositeDim : SHADER_PERMUTATION_BOOL("TEMPORAL_COMPOSITE");
+	using FPermutationDomain = TShaderPermutationDomain<FKernelRadiusDim, FSSGIThreadGroupSizeDim, FSSGITiledDispatchDim, FCompositeDim>;
+
 	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
 		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, CurrentFrameTexture)
 		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, HistoryTexture)
+		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, HistoryMomentsTexture)
+		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, HistoryCountTexture)
 		SHADER_PARAMETER_RDG_TEXTURE(Texture2D, VelocityTexture)
+		SHADER_PARAMETER_RDG_TEXTURE(Texture2D<uint2>, SSGIGBufferTexture)
 		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float4>, OutputTexture)
+		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float2>, OutputMomentsTexture)
+		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float>, OutputCountTexture)
+		SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D, SceneColorTexture)
+		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float4>, CompositeOutputTexture)
+		SHADER_PARAMETER_STRUCT_INCLUDE(FSSGITileDispatchParameters, Tiles)
+		SHADER_PARAMETER_STRUCT_INCLUDE(FSSGISkipMaskParameters, SkipMask)
 		SHADER_PARAMETER(FVector4f, ViewSizeAndInvSize)
 		SHADER_PARAMETER(FVector4f, BufferSizeAndInvSize)
 		SHADER_PARAMETER(FVector4f, ViewRectMin)
+		SHADER_PARAMETER(FIntPoint, CompositeOutputOffset)
 		SHADER_PARAMETER(float, HistoryWeight)
+		SHADER_PARAMETER(float, MaxAccumulation)
+		SHADER_PARAMETER(FVector2f, HistoryUVScale)
+		SHADER_PARAMETER(FVector2f, HistoryUVMax)
 		SHADER_PARAMETER_SAMPLER(SamplerState, BilinearSampler)
 	END_SHADER_PARAMETER_STRUCT()
 
+	static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+	{
+		FPermutationDomain PermutationVector(Parameters.PermutationId);
+		// Composite要写出所有像素（包括天空），不走Tile的间接Dispatch
+		return !(PermutationVector.Get<FCompositeDim>() && PermutationVector.Get<FSSGITiledDispatchDim>());
+	}
+
 	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
 	{
 		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
-		OutEnvironment.SetDefine(TEXT("THREADS_X"), 8);
-		OutEnvironment.SetDefine(TEXT("THREADS_Y"), 8);
-		OutEnvironment.SetDefine(TEXT("THREADS_Z"), 1);
+		FPermutationDomain PermutationVector(Parameters.PermutationId);
+		SetSSGIThreadGroupDefines(PermutationVector.Get<FSSGIThreadGroupSizeDim>(), OutEnvironment);
+		SetSSGITileDispatchDefines(OutEnvironment);
+	}
+};
+
+// Tile分类：按预解码的GBuffer把网格划分成需要计算的Tile和跳过的Tile
+class SCENEVIEWEXTENSIONTEMPLATE_API FSSGITileClassifyCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FSSGITileClassifyCS);
+	SHADER_USE_PARAMETER_STRUCT(FSSGITileClassifyCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_RDG_TEXTURE(Texture2D<uint2>, SSGIGBufferTexture)
+		SHADER_PARAMETER(FVector4f, ViewSizeAndInvSize)
+		SHADER_PARAMETER(FIntPoint, GridSize)
+		SHADER_PARAMETER(FIntPoint, GridToPixelOffset)
+		SHADER_PARAMETER(int, GridToPixelDivisor)
+		SHADER_PARAMETER(FIntPoint, TileSize)
+		SHADER_PARAMETER(uint32, NumTiles)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWTileList)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWTileCounts)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		SetSSGIThreadGroupDefines(ESSGIThreadGroupSize::Size8x8, OutEnvironment);
+		SetSSGITileDispatchDefines(OutEnvironment);
+	}
+};
+
+// 由两个Tile计数写出间接参数
+class SCENEVIEWEXTENSIONTEMPLATE_API FSSGITileDispatchArgsCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FSSGITileDispatchArgsCS);
+	SHADER_USE_PARAMETER_STRUCT(FSSGITileDispatchArgsCS, FGlobalShader);
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<uint>, TileCounts)
+		SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, RWTileDispatchArgs)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		SetSSGIThreadGroupDefines(ESSGIThreadGroupSize::Size8x8, OutEnvironment);
+		SetSSGITileDispatchDefines(OutEnvironment);
+	}
+};
+
+// 跳过的Tile直接写0，Temporal的Tile同时清空亮度矩和累积计数
+class SCENEVIEWEXTENSIONTEMPLATE_API FSSGITileClearCS : public FGlobalShader
+{
+public:
+	DECLARE_GLOBAL_SHADER(FSSGITileClearCS);
+	SHADER_USE_PARAMETER_STRUCT(FSSGITileClearCS, FGlobalShader);
+
+	class FClearMomentsDim : SHADER_PERMUTATION_BOOL("SSGI_TILE_CLEAR_MOMENTS");
+	using FPermutationDomain = TShaderPermutationDomain<FSSGIThreadGroupSizeDim, FClearMomentsDim>;
+
+	BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+		SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<uint>, TileList)
+		SHADER_PARAMETER_RDG_BUFFER_SRV(Buffer<uint>, TileCounts)
+		SHADER_PARAMETER(FIntPoint, GridSize)
+		SHADER_PARAMETER(uint32, NumTiles)
+		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float4>, ClearOutput)
+		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float2>, ClearMomentsOutput)
+		SHADER_PARAMETER_RDG_TEXTURE_UAV(RWTexture2D<float>, ClearCountOutput)
+		RDG_BUFFER_ACCESS(IndirectArgs, ERHIAccess::IndirectArgs)
+	END_SHADER_PARAMETER_STRUCT()
+
+	static void ModifyCompilationEnvironment(const FGlobalShaderPermutationParameters& Parameters, FShaderCompilerEnvironment& OutEnvironment)
+	{
+		FGlobalShader::ModifyCompilationEnvironment(Parameters, OutEnvironment);
+		FPermutationDomain PermutationVector(Parameters.PermutationId);
+		SetSSGIThreadGroupDefines(PermutationVector.Get<FSSGIThreadGroupSizeDim>(), OutEnvironment);
+		SetSSGITileDispatchDefines(OutEnvironment);
 	}
 };
\ No newline at end of file
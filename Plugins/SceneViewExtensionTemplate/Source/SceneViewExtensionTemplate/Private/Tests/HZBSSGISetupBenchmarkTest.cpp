@@ -0,0 +1,126 @@
+﻿// Custom SceneViewExtension Template for Unreal Engine
+// Copyright 2023 - 2025 Ossi Luoto
+//
+// Render-thread cost of building the SSGI graph, per view and per resolution
+
+#include "HZBSSGISceneViewExtension.h"
+#include "Misc/AutomationTest.h"
+#include "SceneView.h"
+#include "SceneViewExtension.h"
+#include "SceneRenderTargetParameters.h"
+#include "RenderGraphBuilder.h"
+#include "RenderingThread.h"
+#include "GlobalShader.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+	// 每个尺寸重复构建的次数，取平均
+	constexpr int32 kSetupBenchmarkIterations = 100;
+
+	struct FSSGISetupBenchmarkResult
+	{
+		FIntPoint ViewSize = FIntPoint::ZeroValue;
+		double GeometryUs = 0.0;
+		double TraceUs = 0.0;
+	};
+
+	// 合成的深度、GBuffer和SceneColor，内容无关紧要：Pass没有消费者，不会在GPU上执行
+	void RunSetupBenchmark(FRHICommandListImmediate& RHICmdList, FHZBSSGISceneViewExtension& Extension, const FSceneView& View, FSSGISetupBenchmarkResult& OutResult)
+	{
+		const FIntRect ViewRect = View.UnscaledViewRect;
+		const FIntPoint BufferSize = ViewRect.Max;
+		uint64 GeometryCycles = 0;
+		uint64 TraceCycles = 0;
+		for (int32 Iteration = 0; Iteration < kSetupBenchmarkIterations; Iteration++)
+		{
+			// 每次迭代一个新的GraphBuilder，与每帧的情况一致；纹理创建和Execute不计入
+			FRDGBuilder GraphBuilder(RHICmdList, RDG_EVENT_NAME("HZBSSGI Setup Benchmark"));
+			const ETextureCreateFlags Flags = TexCreate_ShaderResource | TexCreate_UAV;
+			FRDGTextureRef SceneDepth = GraphBuilder.CreateTexture(FRDGTextureDesc::Create2D(BufferSize, PF_R32_FLOAT, FClearValueBinding::None, Flags), TEXT("SSGIBenchmark.SceneDepth"));
+			FRDGTextureRef SceneColor = GraphBuilder.CreateTexture(FRDGTextureDesc::Create2D(BufferSize, PF_FloatRGBA, FClearValueBinding::Black, Flags), TEXT("SSGIBenchmark.SceneColor"));
+
+			FSceneTextureUniformParameters* SceneTextureParameters = GraphBuilder.AllocParameters<FSceneTextureUniformParameters>();
+			SetupSceneTextureUniformParameters(GraphBuilder, nullptr, View.GetFeatureLevel(), ESceneTextureSetupMode::None, *SceneTextureParameters);
+			SceneTextureParameters->SceneDepthTexture = SceneDepth;
+			SceneTextureParameters->GBufferATexture = GraphBuilder.CreateTexture(FRDGTextureDesc::Create2D(BufferSize, PF_B8G8R8A8, FClearValueBinding::Black, Flags), TEXT("SSGIBenchmark.GBufferA"));
+			SceneTextureParameters->GBufferBTexture = GraphBuilder.CreateTexture(FRDGTextureDesc::Create2D(BufferSize, PF_B8G8R8A8, FClearValueBinding::Black, Flags), TEXT("SSGIBenchmark.GBufferB"));
+			SceneTextureParameters->GBufferCTexture = GraphBuilder.CreateTexture(FRDGTextureDesc::Create2D(BufferSize, PF_B8G8R8A8, FClearValueBinding::Black, Flags), TEXT("SSGIBenchmark.GBufferC"));
+			TRDGUniformBufferRef<FSceneTextureUniformParameters> SceneTexturesUniformBuffer = GraphBuilder.CreateUniformBuffer(SceneTextureParameters);
+
+			uint64 IterationGeometryCycles = 0;
+			uint64 IterationTraceCycles = 0;
+			Extension.AddSetupBenchmarkPasses(GraphBuilder, View, SceneTexturesUniformBuffer, SceneDepth, GraphBuilder.CreateSRV(FRDGTextureSRVDesc(SceneColor)), ViewRect, IterationGeometryCycles, IterationTraceCycles);
+			GeometryCycles += IterationGeometryCycles;
+			TraceCycles += IterationTraceCycles;
+			GraphBuilder.Execute();
+		}
+		OutResult.ViewSize = ViewRect.Size();
+		OutResult.GeometryUs = FPlatformTime::ToSeconds64(GeometryCycles) * 1e6 / kSetupBenchmarkIterations;
+		OutResult.TraceUs = FPlatformTime::ToSeconds64(TraceCycles) * 1e6 / kSetupBenchmarkIterations;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHZBSSGISetupBenchmarkTest, "Plugins.HZBSSGI.SetupBenchmark",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FHZBSSGISetupBenchmarkTest::RunTest(const FString& Parameters)
+{
+	// 没有编译全局Shader的环境（部分-nullrhi的Commandlet）无法取到Shader，跳过
+	const FGlobalShaderMap* GlobalShaderMap = GetGlobalShaderMap(GMaxRHIFeatureLevel);
+	if (!GlobalShaderMap || !GlobalShaderMap->HasShader(&FSSGIGBufferDecodeCS::GetStaticType(), 0))
+	{
+		AddWarning(TEXT("SSGI global shaders are not available, skipping the setup benchmark."));
+		return true;
+	}
+
+	// 独立的扩展实例，不参与任何真实的ViewFamily，测量不影响正在渲染的View的状态
+	TSharedRef<FHZBSSGISceneViewExtension, ESPMode::ThreadSafe> Extension = FSceneViewExtensions::NewExtension<FHZBSSGISceneViewExtension>();
+	FSceneViewExtensionIsActiveFunctor IsActiveFunctor;
+	IsActiveFunctor.IsActiveFunction = [](const ISceneViewExtension*, const FSceneViewExtensionContext&)
+	{
+		return TOptional<bool>(false);
+	};
+	Extension->IsActiveThisFrameFunctions.Add(IsActiveFunctor);
+
+	static const FIntPoint BenchmarkSizes[] = { FIntPoint(1280, 720), FIntPoint(1920, 1080), FIntPoint(2560, 1440), FIntPoint(3840, 2160) };
+	TArray<FSSGISetupBenchmarkResult> Results;
+	Results.SetNum(UE_ARRAY_COUNT(BenchmarkSizes));
+	for (int32 SizeIndex = 0; SizeIndex < UE_ARRAY_COUNT(BenchmarkSizes); SizeIndex++)
+	{
+		const FIntPoint Size = BenchmarkSizes[SizeIndex];
+		FSceneViewFamilyContext ViewFamily(FSceneViewFamily::ConstructionValues(nullptr, nullptr, FEngineShowFlags(ESFIM_Game)));
+		ViewFamily.FrameNumber = 0;
+
+		FSceneViewInitOptions ViewInitOptions;
+		ViewInitOptions.ViewFamily = &ViewFamily;
+		ViewInitOptions.SetViewRectangle(FIntRect(FIntPoint::ZeroValue, Size));
+		ViewInitOptions.ViewOrigin = FVector::ZeroVector;
+		// UE的X前方转换到视图空间的Z前方
+		ViewInitOptions.ViewRotationMatrix = FMatrix(FPlane(0, 0, 1, 0), FPlane(1, 0, 0, 0), FPlane(0, 1, 0, 0), FPlane(0, 0, 0, 1));
+		ViewInitOptions.ProjectionMatrix = FReversedZPerspectiveMatrix(HALF_PI * 0.5f, Size.X, Size.Y, GNearClippingPlane);
+		ViewFamily.Views.Add(new FSceneView(ViewInitOptions));
+		const FSceneView* View = ViewFamily.Views[0];
+
+		FSSGISetupBenchmarkResult* Result = &Results[SizeIndex];
+		ENQUEUE_RENDER_COMMAND(HZBSSGISetupBenchmark)([&Extension, View, Result](FRHICommandListImmediate& RHICmdList)
+		{
+			RunSetupBenchmark(RHICmdList, *Extension, *View, *Result);
+		});
+		FlushRenderingCommands();
+	}
+
+	UE_LOG(LogHZBSSGI, Display, TEXT("HZB SSGI setup benchmark: %d iterations per size, render thread time per view"), kSetupBenchmarkIterations);
+	for (const FSSGISetupBenchmarkResult& Result : Results)
+	{
+		const FString Line = FString::Printf(TEXT("%dx%d: %.1f us (geometry %.1f us, trace %.1f us)"),
+			Result.ViewSize.X, Result.ViewSize.Y, Result.GeometryUs + Result.TraceUs, Result.GeometryUs, Result.TraceUs);
+		UE_LOG(LogHZBSSGI, Display, TEXT("  %s"), *Line);
+		AddInfo(Line);
+		TestTrue(FString::Printf(TEXT("Setup time measured at %dx%d"), Result.ViewSize.X, Result.ViewSize.Y), Result.GeometryUs + Result.TraceUs > 0.0);
+	}
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
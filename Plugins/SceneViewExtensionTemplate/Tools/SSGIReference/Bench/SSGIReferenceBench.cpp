@@ -0,0 +1,204 @@
+// SSGIReferenceBench.cpp
+// 在程序化场景上逐帧运行CPU参考管线，输出每个Pass的耗时、每秒光线数、每条光线的平均迭代次数和命中率
+#include "SSGIReference.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace SSGIReference;
+
+namespace
+{
+	struct FBenchOptions
+	{
+		FIntPoint Size = FIntPoint(1280, 720);
+		int32_t Frames = 8;
+		int32_t Threads = 0;
+		FHZBSettings HZBSettings;
+		FTraceSettings TraceSettings;
+		bool bRadianceCache = true;
+		FRadianceCacheSettings RadianceCacheSettings;
+		int32_t DenoiserIterations = 3;
+		FTemporalSettings TemporalSettings;
+	};
+
+	enum EStage
+	{
+		Stage_HZBBuild,
+		Stage_GBufferDecode,
+		Stage_RadianceCache,
+		Stage_Trace,
+		Stage_Upsample,
+		Stage_Denoise,
+		Stage_Temporal,
+		Stage_Count
+	};
+
+	const char* const GStageNames[Stage_Count] = { "HZB Build", "GBuffer Decode", "Radiance Cache", "Trace", "Upsample", "Denoise", "Temporal" };
+
+	void PrintUsage()
+	{
+		std::printf(
+			"Usage: SSGIReferenceBench [options]\n"
+			"  --size WxH          Buffer size (default 1280x720)\n"
+			"  --frames N          Frames to run (default 8)\n"
+			"  --threads N         Worker threads, 0 = all cores (default 0)\n"
+			"  --spp N             Rays per pixel, rounded up to 1, 2, 4 or 8 (default 1)\n"
+			"  --iterations N      Max HiZ iterations per ray (default 64)\n"
+			"  --thickness F       Depth thickness (default 10)\n"
+			"  --ray-length F      Ray length (default 100)\n"
+			"  --divisor N         Trace resolution divisor 1, 2 or 4 (default 1)\n"
+			"  --sampling N        0 = hashed LCG, 1 = R2 + blue-noise rotation (default 1)\n"
+			"  --radiance-cache N  Shade hits from the prefiltered radiance cache 0 or 1 (default 1)\n"
+			"  --multi-bounce F    Weight of the previous frame's GI in the radiance cache (default 1)\n"
+			"  --denoiser N        A-Trous iterations 0-4 (default 3)\n"
+			"  --kernel-radius N   Temporal neighborhood radius 1 or 2 (default 2)\n"
+			"  --compact           Compact HZB\n"
+			"  --half              Half precision HZB (compact only)\n");
+	}
+
+	bool ParseOptions(int Argc, char** Argv, FBenchOptions& Options)
+	{
+		for (int Index = 1; Index < Argc; Index++)
+		{
+			const char* Arg = Argv[Index];
+			const char* Value = (Index + 1 < Argc) ? Argv[Index + 1] : nullptr;
+			auto Consume = [&]() { Index++; return Value; };
+
+			if (!std::strcmp(Arg, "--compact")) { Options.HZBSettings.bCompact = true; continue; }
+			if (!std::strcmp(Arg, "--half")) { Options.HZBSettings.bHalfPrecision = true; continue; }
+			if (!Value)
+			{
+				return false;
+			}
+			if (!std::strcmp(Arg, "--size"))
+			{
+				if (std::sscanf(Consume(), "%dx%d", &Options.Size.X, &Options.Size.Y) != 2 || Options.Size.X <= 0 || Options.Size.Y <= 0) return false;
+			}
+			else if (!std::strcmp(Arg, "--frames")) Options.Frames = std::max(std::atoi(Consume()), 1);
+			else if (!std::strcmp(Arg, "--threads")) Options.Threads = std::max(std::atoi(Consume()), 0);
+			else if (!std::strcmp(Arg, "--spp")) Options.TraceSettings.SamplesPerPixel = std::atoi(Consume());
+			else if (!std::strcmp(Arg, "--iterations")) Options.TraceSettings.MaxIterations = std::atoi(Consume());
+			else if (!std::strcmp(Arg, "--thickness")) Options.TraceSettings.Thickness = float(std::atof(Consume()));
+			else if (!std::strcmp(Arg, "--ray-length")) Options.TraceSettings.RayLength = float(std::atof(Consume()));
+			else if (!std::strcmp(Arg, "--divisor")) Options.TraceSettings.ResolutionDivisor = std::atoi(Consume());
+			else if (!std::strcmp(Arg, "--sampling")) Options.TraceSettings.SamplingMode = std::atoi(Consume());
+			else if (!std::strcmp(Arg, "--radiance-cache")) Options.bRadianceCache = std::atoi(Consume()) != 0;
+			else if (!std::strcmp(Arg, "--multi-bounce")) Options.RadianceCacheSettings.MultiBounceWeight = float(std::atof(Consume()));
+			else if (!std::strcmp(Arg, "--denoiser")) Options.DenoiserIterations = std::atoi(Consume());
+			else if (!std::strcmp(Arg, "--kernel-radius")) Options.TemporalSettings.KernelRadius = std::atoi(Consume());
+			else return false;
+		}
+		return true;
+	}
+
+	class FScopedTimer
+	{
+	public:
+		explicit FScopedTimer(double& InAccumulatedMs) : AccumulatedMs(InAccumulatedMs), Start(std::chrono::steady_clock::now()) {}
+		~FScopedTimer()
+		{
+			AccumulatedMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+		}
+
+	private:
+		double& AccumulatedMs;
+		std::chrono::steady_clock::time_point Start;
+	};
+}
+
+int main(int Argc, char** Argv)
+{
+	FBenchOptions Options;
+	if (!ParseOptions(Argc, Argv, Options))
+	{
+		PrintUsage();
+		return 1;
+	}
+	SetNumWorkerThreads(Options.Threads);
+
+	std::printf("SSGI reference benchmark: %dx%d, %d frames, %d threads\n", Options.Size.X, Options.Size.Y, Options.Frames, GetNumWorkerThreads());
+	std::printf("  HZB %s%s, %d spp, %d iterations, 1/%d trace, %d denoiser iterations, %dx%d temporal kernel\n",
+		Options.HZBSettings.bCompact ? "compact" : "full",
+		(Options.HZBSettings.bCompact && Options.HZBSettings.bHalfPrecision) ? " R16F" : "",
+		Options.TraceSettings.SamplesPerPixel, Options.TraceSettings.MaxIterations, Options.TraceSettings.ResolutionDivisor,
+		Options.DenoiserIterations, Options.TemporalSettings.KernelRadius * 2 + 1, Options.TemporalSettings.KernelRadius * 2 + 1);
+
+	double StageMs[Stage_Count] = {};
+	FTraceStats TotalStats;
+	FTemporalHistory History;
+	FTemporalHistory NextHistory;
+	FRadianceCache RadianceCache;
+	TImage<FVector3> RawTrace;
+	TImage<FVector3> Upsampled;
+	TImage<FVector3> Denoised;
+
+	for (int32_t Frame = 0; Frame < Options.Frames; Frame++)
+	{
+		// 场景生成不计入耗时
+		const FSyntheticScene Scene = MakeSyntheticScene(Options.Size, uint32_t(Frame));
+
+		FHZB HZB;
+		{
+			FScopedTimer Timer(StageMs[Stage_HZBBuild]);
+			HZB = BuildHZB(Scene.SceneDepth, Scene.View.ViewRect, Options.HZBSettings);
+		}
+		TImage<FGBufferSample> GBuffer;
+		{
+			FScopedTimer Timer(StageMs[Stage_GBufferDecode]);
+			GBuffer = DecodeGBuffer(Scene.SceneDepth, Scene.WorldNormal, Scene.View);
+		}
+		if (Options.bRadianceCache)
+		{
+			FScopedTimer Timer(StageMs[Stage_RadianceCache]);
+			BuildRadianceCache(Scene.View, Scene.SceneColor, History.bValid ? &History.Color : nullptr, &Scene.Velocity, Options.RadianceCacheSettings, RadianceCache);
+		}
+		{
+			FScopedTimer Timer(StageMs[Stage_Trace]);
+			FTraceInputs Inputs;
+			Inputs.SceneColor = &Scene.SceneColor;
+			Inputs.BaseColor = &Scene.BaseColor;
+			Inputs.AmbientOcclusion = &Scene.AmbientOcclusion;
+			Inputs.RadianceCache = Options.bRadianceCache ? &RadianceCache : nullptr;
+			FTraceStats Stats;
+			TraceSSGI(Scene.View, HZB, GBuffer, Inputs, Options.TraceSettings, RawTrace, &Stats);
+			TotalStats.RaysTraced += Stats.RaysTraced;
+			TotalStats.RaysHit += Stats.RaysHit;
+			TotalStats.TotalIterations += Stats.TotalIterations;
+		}
+		{
+			FScopedTimer Timer(StageMs[Stage_Upsample]);
+			UpsampleSSGI(Scene.View, RawTrace, GBuffer, Options.TraceSettings.ResolutionDivisor, Upsampled);
+		}
+		{
+			FScopedTimer Timer(StageMs[Stage_Denoise]);
+			DenoiseSpatial(Upsampled, GBuffer, Options.DenoiserIterations, Options.TraceSettings.Intensity, Denoised);
+		}
+		{
+			FScopedTimer Timer(StageMs[Stage_Temporal]);
+			TemporalAccumulate(Scene.View, Denoised, GBuffer, &Scene.Velocity, History, Options.TemporalSettings, NextHistory);
+			std::swap(History, NextHistory);
+		}
+	}
+
+	std::printf("\n%-16s %10s\n", "Stage", "avg ms");
+	double TotalMs = 0.0;
+	for (int32_t Stage = 0; Stage < Stage_Count; Stage++)
+	{
+		std::printf("%-16s %10.3f\n", GStageNames[Stage], StageMs[Stage] / Options.Frames);
+		TotalMs += StageMs[Stage];
+	}
+	std::printf("%-16s %10.3f\n", "Total", TotalMs / Options.Frames);
+
+	const double TraceSeconds = StageMs[Stage_Trace] / 1000.0;
+	const double RaysPerSecond = TraceSeconds > 0.0 ? double(TotalStats.RaysTraced) / TraceSeconds : 0.0;
+	const double IterationsPerRay = TotalStats.RaysTraced ? double(TotalStats.TotalIterations) / double(TotalStats.RaysTraced) : 0.0;
+	const double HitRate = TotalStats.RaysTraced ? double(TotalStats.RaysHit) / double(TotalStats.RaysTraced) : 0.0;
+	std::printf("\nRays traced:      %llu\n", (unsigned long long)TotalStats.RaysTraced);
+	std::printf("Rays/sec:         %.2f M\n", RaysPerSecond / 1e6);
+	std::printf("Iterations/ray:   %.2f\n", IterationsPerRay);
+	std::printf("Hit rate:         %.1f%%\n", HitRate * 100.0);
+	return 0;
+}
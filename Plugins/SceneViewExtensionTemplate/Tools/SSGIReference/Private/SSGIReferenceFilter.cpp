@@ -0,0 +1,455 @@
+#include "SSGIReference.h"
+#include "SSGIReferenceSimd.h"
+
+namespace SSGIReference
+{
+	namespace
+	{
+		using Simd::FFloat4;
+		using Simd::FFloat4x3;
+		using Simd::FMask4;
+
+		float LuminanceDenoise(const FVector3& Color)
+		{
+			return Dot(Color, FVector3(0.2126f, 0.7152f, 0.0722f));
+		}
+
+		FVector3 RoundTripHalf(const FVector3& Color)
+		{
+			return FVector3(F16ToF32(F32ToF16(Color.X)), F16ToF32(F32ToF16(Color.Y)), F16ToF32(F32ToF16(Color.Z)));
+		}
+
+		FVector3 RGBToYCoCg(const FVector3& RGB)
+		{
+			return FVector3(
+				Dot(RGB, FVector3(0.25f, 0.50f, 0.25f)),
+				Dot(RGB, FVector3(0.50f, 0.00f, -0.50f)),
+				Dot(RGB, FVector3(-0.25f, 0.50f, -0.25f)));
+		}
+
+		FVector3 Tonemap(const FVector3& Color)
+		{
+			return Color / (1.0f + Luminance(Color));
+		}
+
+		float LerpValue(float A, float B, float T)
+		{
+			return Lerp(A, B, T);
+		}
+
+		FVector4 LerpValue(const FVector4& A, const FVector4& B, float T)
+		{
+			return FVector4(Lerp(A.X, B.X, T), Lerp(A.Y, B.Y, T), Lerp(A.Z, B.Z, T), Lerp(A.W, B.W, T));
+		}
+
+		// SampleLevel(BilinearSampler, UV, 0)，Clamp寻址
+		template<typename T>
+		T SampleBilinear(const TImage<T>& Image, float U, float V)
+		{
+			const float X = U * Image.Width - 0.5f;
+			const float Y = V * Image.Height - 0.5f;
+			const int32_t X0 = int32_t(std::floor(X));
+			const int32_t Y0 = int32_t(std::floor(Y));
+			const float FracX = X - X0;
+			const float FracY = Y - Y0;
+			const T Top = LerpValue(Image.LoadClamped(X0, Y0), Image.LoadClamped(X0 + 1, Y0), FracX);
+			const T Bottom = LerpValue(Image.LoadClamped(X0, Y0 + 1), Image.LoadClamped(X0 + 1, Y0 + 1), FracX);
+			return LerpValue(Top, Bottom, FracY);
+		}
+
+		/**
+		 * 4个相邻像素的向量版本，运算顺序与上面的标量函数一致
+		 */
+		FFloat4x3 Splat(const FVector3& V)
+		{
+			return FFloat4x3{ Simd::Splat(V.X), Simd::Splat(V.Y), Simd::Splat(V.Z) };
+		}
+
+		FFloat4x3 Select(FMask4 Mask, const FFloat4x3& A, const FFloat4x3& B)
+		{
+			return FFloat4x3{ Simd::Select(Mask, A.X, B.X), Simd::Select(Mask, A.Y, B.Y), Simd::Select(Mask, A.Z, B.Z) };
+		}
+
+		FFloat4x3 Divide(const FFloat4x3& A, FFloat4 B)
+		{
+			return FFloat4x3{ Simd::Div(A.X, B), Simd::Div(A.Y, B), Simd::Div(A.Z, B) };
+		}
+
+		// Lerp(FVector3, FVector3, float)：A + (B - A) * T
+		FFloat4x3 Lerp(const FFloat4x3& A, const FFloat4x3& B, FFloat4 T)
+		{
+			return FFloat4x3{
+				Simd::Add(A.X, Simd::Mul(Simd::Sub(B.X, A.X), T)),
+				Simd::Add(A.Y, Simd::Mul(Simd::Sub(B.Y, A.Y), T)),
+				Simd::Add(A.Z, Simd::Mul(Simd::Sub(B.Z, A.Z), T)) };
+		}
+
+		// Clamp(V, A, B) = Min(Max(V, A), B)，std::max(V, A)即A > V ? A : V
+		FFloat4x3 Clamp(const FFloat4x3& V, const FFloat4x3& A, const FFloat4x3& B)
+		{
+			return FFloat4x3{
+				Simd::Min(B.X, Simd::Max(A.X, V.X)),
+				Simd::Min(B.Y, Simd::Max(A.Y, V.Y)),
+				Simd::Min(B.Z, Simd::Max(A.Z, V.Z)) };
+		}
+
+		FFloat4x3 RGBToYCoCg(const FFloat4x3& RGB)
+		{
+			return FFloat4x3{
+				Simd::Dot(RGB, FVector3(0.25f, 0.50f, 0.25f)),
+				Simd::Dot(RGB, FVector3(0.50f, 0.00f, -0.50f)),
+				Simd::Dot(RGB, FVector3(-0.25f, 0.50f, -0.25f)) };
+		}
+
+		FFloat4x3 YCoCgToRGB(const FFloat4x3& YCoCg)
+		{
+			return FFloat4x3{
+				Simd::Sub(Simd::Add(YCoCg.X, YCoCg.Y), YCoCg.Z),
+				Simd::Add(YCoCg.X, YCoCg.Z),
+				Simd::Sub(Simd::Sub(YCoCg.X, YCoCg.Y), YCoCg.Z) };
+		}
+
+		FFloat4x3 Tonemap(const FFloat4x3& Color)
+		{
+			return Divide(Color, Simd::Add(Simd::Splat(1.0f), Simd::Dot(Color, FVector3(0.3f, 0.59f, 0.11f))));
+		}
+
+		FFloat4x3 InverseTonemap(const FFloat4x3& Color)
+		{
+			const FFloat4 Denominator = Simd::Sub(Simd::Splat(1.0f), Simd::Dot(Color, FVector3(0.3f, 0.59f, 0.11f)));
+			return Divide(Color, Simd::Max(Denominator, Simd::Splat(1e-4f)));
+		}
+
+		// 一行中从X开始的4个值，越界的Lane读边界上的值（由调用者的Mask丢弃）
+		FFloat4 LoadRow4(const TImage<float>& Plane, int32_t X, int32_t Y)
+		{
+			const float* Row = &Plane(0, Y);
+			if (X >= 0 && X + 4 <= Plane.Width)
+			{
+				return Simd::Load(Row + X);
+			}
+			auto ClampX = [&](int32_t SampleX) { return std::min(std::max(SampleX, 0), Plane.Width - 1); };
+			return Simd::Load4(Row[ClampX(X)], Row[ClampX(X + 1)], Row[ClampX(X + 2)], Row[ClampX(X + 3)]);
+		}
+
+		FMask4 MakeLaneRangeMask(int32_t X, int32_t MinX, int32_t MaxX)
+		{
+			auto InRange = [&](int32_t Lane) { return X + Lane >= MinX && X + Lane < MaxX; };
+			return Simd::MakeMask(InRange(0), InRange(1), InRange(2), InRange(3));
+		}
+
+		// A-Trous的输入按平面存储，4个相邻像素可以直接整体读取
+		struct FDenoisePlanes
+		{
+			TImage<float> ColorR, ColorG, ColorB;
+			// LuminanceDenoise(Color)
+			TImage<float> Luma;
+			TImage<float> NormalX, NormalY, NormalZ;
+			TImage<float> Depth;
+			// 1为有效像素，0为天空
+			TImage<float> Valid;
+
+			void Resize(FIntPoint Size)
+			{
+				for (TImage<float>* Plane : { &ColorR, &ColorG, &ColorB, &Luma, &NormalX, &NormalY, &NormalZ, &Depth, &Valid })
+				{
+					Plane->Resize(Size.X, Size.Y);
+				}
+			}
+
+			FFloat4x3 LoadColor(int32_t X, int32_t Y) const { return FFloat4x3{ LoadRow4(ColorR, X, Y), LoadRow4(ColorG, X, Y), LoadRow4(ColorB, X, Y) }; }
+			FFloat4x3 LoadNormal(int32_t X, int32_t Y) const { return FFloat4x3{ LoadRow4(NormalX, X, Y), LoadRow4(NormalY, X, Y), LoadRow4(NormalZ, X, Y) }; }
+			FMask4 LoadValid(int32_t X, int32_t Y) const { return Simd::CmpGt(LoadRow4(Valid, X, Y), Simd::Splat(0.0f)); }
+		};
+	}
+
+	void DenoiseATrous(const TImage<FVector3>& Input, const TImage<FGBufferSample>& GBuffer, int32_t StepSize, float Intensity, TImage<FVector3>& Output)
+	{
+		const FIntPoint ViewSize = GBuffer.Size();
+		Output.Resize(ViewSize.X, ViewSize.Y);
+
+		// Shader在groupshared中按half存储颜色，这里先整体转换一次，每个Tap不再重复转换
+		FDenoisePlanes Planes;
+		Planes.Resize(ViewSize);
+		ParallelForTiles(ViewSize, 64, [&](const FIntRect& Tile)
+		{
+			for (int32_t Y = Tile.Min.Y; Y < Tile.Max.Y; Y++)
+			{
+				for (int32_t X = Tile.Min.X; X < Tile.Max.X; X++)
+				{
+					const FVector3 Color = RoundTripHalf(Input(X, Y));
+					const FGBufferSample& Sample = GBuffer(X, Y);
+					Planes.ColorR(X, Y) = Color.X;
+					Planes.ColorG(X, Y) = Color.Y;
+					Planes.ColorB(X, Y) = Color.Z;
+					Planes.Luma(X, Y) = LuminanceDenoise(Color);
+					Planes.NormalX(X, Y) = Sample.WorldNormal.X;
+					Planes.NormalY(X, Y) = Sample.WorldNormal.Y;
+					Planes.NormalZ(X, Y) = Sample.WorldNormal.Z;
+					Planes.Depth(X, Y) = Sample.LinearDepth;
+					Planes.Valid(X, Y) = Sample.bValid ? 1.0f : 0.0f;
+				}
+			}
+		});
+
+		// 与SSGIDenoiser.usf相同的常量
+		const float BaseSigmaColor = 0.8f;
+		const float AdaptiveSigmaColor = BaseSigmaColor * std::max(1.0f, Intensity);
+		const float SigmaNormal = 0.3f;
+		const float SigmaPlane = 10.0f;
+		// B样条的3x3核 (1/4, 1/2, 1/4)
+		const float KernelWeights[3] = { 0.25f, 0.5f, 0.25f };
+
+		const FFloat4 ColorDenominator = Simd::Splat(2.0f * AdaptiveSigmaColor * AdaptiveSigmaColor);
+		const FFloat4 NormalDenominator = Simd::Splat(2.0f * SigmaNormal * SigmaNormal);
+		const FFloat4 PlaneDenominator = Simd::Splat(2.0f * SigmaPlane * SigmaPlane);
+		const FFloat4 SigmaColor = Simd::Splat(AdaptiveSigmaColor);
+		const FFloat4 Zero = Simd::Splat(0.0f);
+		const FFloat4 One = Simd::Splat(1.0f);
+		const FFloat4 Two = Simd::Splat(2.0f);
+
+		// 沿X方向4个像素一组，每个Lane的运算与单个像素的标量实现逐位相同
+		ParallelForTiles(ViewSize, 16, [&](const FIntRect& Tile)
+		{
+			for (int32_t Y = Tile.Min.Y; Y < Tile.Max.Y; Y++)
+			{
+				for (int32_t X = Tile.Min.X; X < Tile.Max.X; X += 4)
+				{
+					// 中心像素即使是天空也参与计算，和Shader一致
+					const FFloat4x3 CenterColor = Planes.LoadColor(X, Y);
+					const FFloat4x3 CenterNormal = Planes.LoadNormal(X, Y);
+					const FFloat4 CenterDepth = Simd::Select(Planes.LoadValid(X, Y), LoadRow4(Planes.Depth, X, Y), Simd::Splat(-1.0f));
+					const FFloat4 LumaCenter = LoadRow4(Planes.Luma, X, Y);
+
+					FFloat4x3 SumColor = Splat(FVector3(0.0f));
+					FFloat4 TotalWeight = Zero;
+					for (int32_t OffsetY = -1; OffsetY <= 1; OffsetY++)
+					{
+						// View外和天空的像素不参与滤波
+						const int32_t SampleY = Y + OffsetY * StepSize;
+						if (SampleY < 0 || SampleY >= ViewSize.Y) continue;
+						for (int32_t OffsetX = -1; OffsetX <= 1; OffsetX++)
+						{
+							const int32_t SampleX = X + OffsetX * StepSize;
+							const FMask4 TapMask = Simd::MaskAnd(MakeLaneRangeMask(SampleX, 0, ViewSize.X), Planes.LoadValid(SampleX, SampleY));
+							if (!Simd::MaskAny(TapMask)) continue;
+
+							const FFloat4x3 NeighborColor = Planes.LoadColor(SampleX, SampleY);
+							const FFloat4x3 ColorDiff{ Simd::Sub(CenterColor.X, NeighborColor.X), Simd::Sub(CenterColor.Y, NeighborColor.Y), Simd::Sub(CenterColor.Z, NeighborColor.Z) };
+							const FFloat4 DColor = Simd::Div(Simd::Dot(ColorDiff, ColorDiff), ColorDenominator);
+							// 压制FireFly
+							const FFloat4 LumaExcess = Simd::Max(Simd::Sub(LoadRow4(Planes.Luma, SampleX, SampleY), LumaCenter), Zero);
+							const FFloat4 FireflyWeight = Simd::Div(One, Simd::Add(One, Simd::Div(LumaExcess, SigmaColor)));
+							// 法线夹角的平方用 2(1-cos) 近似
+							const FFloat4 CosAngle = Simd::Dot(CenterNormal, Planes.LoadNormal(SampleX, SampleY));
+							const FFloat4 NormalAngle2 = Simd::Mul(Two, Simd::Min(One, Simd::Max(Zero, Simd::Sub(One, CosAngle))));
+							const FFloat4 DNormal = Simd::Div(NormalAngle2, NormalDenominator);
+							const FFloat4 DepthDiff = Simd::Abs(Simd::Sub(LoadRow4(Planes.Depth, SampleX, SampleY), CenterDepth));
+							const FFloat4 DPlane = Simd::Div(Simd::Mul(DepthDiff, DepthDiff), PlaneDenominator);
+
+							const FFloat4 Falloff = Simd::Exp(Simd::Neg(Simd::Add(Simd::Add(DPlane, DColor), DNormal)));
+							const FFloat4 Weight = Simd::Mul(Simd::Mul(Simd::Splat(KernelWeights[OffsetX + 1] * KernelWeights[OffsetY + 1]), Falloff), FireflyWeight);
+							// 被跳过的Tap不改变累加值
+							SumColor.X = Simd::Select(TapMask, Simd::Add(SumColor.X, Simd::Mul(NeighborColor.X, Weight)), SumColor.X);
+							SumColor.Y = Simd::Select(TapMask, Simd::Add(SumColor.Y, Simd::Mul(NeighborColor.Y, Weight)), SumColor.Y);
+							SumColor.Z = Simd::Select(TapMask, Simd::Add(SumColor.Z, Simd::Mul(NeighborColor.Z, Weight)), SumColor.Z);
+							TotalWeight = Simd::Select(TapMask, Simd::Add(TotalWeight, Weight), TotalWeight);
+						}
+					}
+					const FFloat4x3 Result = Select(Simd::CmpGt(TotalWeight, Simd::Splat(0.0001f)), Divide(SumColor, TotalWeight), CenterColor);
+
+					float ResultX[4], ResultY[4], ResultZ[4];
+					Simd::Store(ResultX, Result.X);
+					Simd::Store(ResultY, Result.Y);
+					Simd::Store(ResultZ, Result.Z);
+					for (int32_t Lane = 0; Lane < 4 && X + Lane < Tile.Max.X; Lane++)
+					{
+						Output(X + Lane, Y) = FVector3(ResultX[Lane], ResultY[Lane], ResultZ[Lane]);
+					}
+				}
+			}
+		});
+	}
+
+	void DenoiseSpatial(const TImage<FVector3>& Input, const TImage<FGBufferSample>& GBuffer, int32_t NumIterations, float Intensity, TImage<FVector3>& Output)
+	{
+		// 与r.HZBSSGI.Denoiser.Iterations的范围一致
+		NumIterations = std::min(std::max(NumIterations, 0), 4);
+		Output = Input;
+		TImage<FVector3> Scratch;
+		for (int32_t Iteration = 0; Iteration < NumIterations; Iteration++)
+		{
+			DenoiseATrous(Output, GBuffer, 1 << Iteration, Intensity, Scratch);
+			std::swap(Output, Scratch);
+		}
+	}
+
+	void TemporalAccumulate(const FViewInfo& View, const TImage<FVector3>& Current, const TImage<FGBufferSample>& GBuffer, const TImage<FVector2>* Velocity, const FTemporalHistory& History, const FTemporalSettings& Settings, FTemporalHistory& OutHistory)
+	{
+		const FIntPoint ViewSize = View.ViewRect.Size();
+		const FVector2 ViewInvSize(1.0f / ViewSize.X, 1.0f / ViewSize.Y);
+		const int32_t KernelRadius = std::min(std::max(Settings.KernelRadius, 1), 2);
+		const float MaxAccumulation = std::max(Settings.MaxAccumulation, 1.0f);
+		// 历史无效时插件绑定的是黑色的Dummy纹理
+		const bool bHistoryTextureValid = History.bValid && History.Color.Width == ViewSize.X && History.Color.Height == ViewSize.Y;
+		// 历史与View同尺寸
+		const FVector2 HistoryUVMax((ViewSize.X - 0.5f) * ViewInvSize.X, (ViewSize.Y - 0.5f) * ViewInvSize.Y);
+
+		OutHistory.Color.Resize(ViewSize.X, ViewSize.Y);
+		OutHistory.Moments.Resize(ViewSize.X, ViewSize.Y);
+		OutHistory.bValid = true;
+
+		// 邻域统计在Tonemap后的YCoCg空间中进行，每个像素只转换一次，按平面存储
+		TImage<float> NeighborY(Current.Width, Current.Height);
+		TImage<float> NeighborCo(Current.Width, Current.Height);
+		TImage<float> NeighborCg(Current.Width, Current.Height);
+		ParallelForTiles(Current.Size(), 64, [&](const FIntRect& Tile)
+		{
+			for (int32_t Y = Tile.Min.Y; Y < Tile.Max.Y; Y++)
+			{
+				for (int32_t X = Tile.Min.X; X < Tile.Max.X; X++)
+				{
+					const FVector3 SampleYCoCg = RGBToYCoCg(Tonemap(Current(X, Y)));
+					NeighborY(X, Y) = SampleYCoCg.X;
+					NeighborCo(X, Y) = SampleYCoCg.Y;
+					NeighborCg(X, Y) = SampleYCoCg.Z;
+				}
+			}
+		});
+
+		const FFloat4 Zero = Simd::Splat(0.0f);
+		const FFloat4 One = Simd::Splat(1.0f);
+		const FFloat4 Gamma = Simd::Splat(2.0f);
+
+		// 沿X方向4个像素一组；重投影和历史的双线性采样是逐像素的Gather，逐Lane处理
+		ParallelForTiles(ViewSize, 8, [&](const FIntRect& Tile)
+		{
+			for (int32_t Y = Tile.Min.Y; Y < Tile.Max.Y; Y++)
+			{
+				const float LocalV = (Y + 0.5f) * ViewInvSize.Y;
+				for (int32_t X = Tile.Min.X; X < Tile.Max.X; X += 4)
+				{
+					const int32_t NumLanes = std::min(4, Tile.Max.X - X);
+					const FFloat4 LocalU = Simd::Mul(Simd::Add(Simd::Load4(float(X), float(X + 1), float(X + 2), float(X + 3)), Simd::Splat(0.5f)), Simd::Splat(ViewInvSize.X));
+
+					float CurrentR[4] = {}, CurrentG[4] = {}, CurrentB[4] = {};
+					bool bOnScreen[4] = {};
+					float HistoryR[4] = {}, HistoryG[4] = {}, HistoryB[4] = {}, HistoryCount[4] = {}, HistoryMoment[4] = {};
+					for (int32_t Lane = 0; Lane < NumLanes; Lane++)
+					{
+						const int32_t PixelX = X + Lane;
+						const FVector3& CurrentColor = Current(PixelX, Y);
+						CurrentR[Lane] = CurrentColor.X;
+						CurrentG[Lane] = CurrentColor.Y;
+						CurrentB[Lane] = CurrentColor.Z;
+
+						FVector2 PixelVelocity = Velocity ? Velocity->LoadClamped(PixelX + View.ViewRect.Min.X, Y + View.ViewRect.Min.Y) : FVector2();
+						if (std::max(std::abs(PixelVelocity.X), std::abs(PixelVelocity.Y)) > 0.1f) PixelVelocity = FVector2();
+						const FVector2 PrevLocalUV = FVector2(Simd::GetLane(LocalU, Lane), LocalV) - PixelVelocity;
+						bOnScreen[Lane] = !(PrevLocalUV.X < 0.0f || PrevLocalUV.Y < 0.0f || PrevLocalUV.X > 1.0f || PrevLocalUV.Y > 1.0f);
+						if (bOnScreen[Lane] && bHistoryTextureValid)
+						{
+							const float HistoryU = std::min(PrevLocalUV.X, HistoryUVMax.X);
+							const float HistoryV = std::min(PrevLocalUV.Y, HistoryUVMax.Y);
+							const FVector4 HistoryRead = SampleBilinear(History.Color, HistoryU, HistoryV);
+							HistoryR[Lane] = HistoryRead.X;
+							HistoryG[Lane] = HistoryRead.Y;
+							HistoryB[Lane] = HistoryRead.Z;
+							HistoryCount[Lane] = HistoryRead.W;
+							HistoryMoment[Lane] = SampleBilinear(History.Moments, HistoryU, HistoryV);
+						}
+					}
+
+					// 邻域在Tonemap后的YCoCg空间中的均值和方差
+					FFloat4x3 M1 = Splat(FVector3(0.0f));
+					FFloat4x3 M2 = Splat(FVector3(0.0f));
+					FFloat4 WeightSum = Zero;
+					for (int32_t OffsetX = -KernelRadius; OffsetX <= KernelRadius; OffsetX++)
+					{
+						const FFloat4 SampleU = Simd::Add(LocalU, Simd::Splat(OffsetX * ViewInvSize.X));
+						const FMask4 InsideU = Simd::MaskNot(Simd::MaskOr(Simd::CmpLt(SampleU, Zero), Simd::CmpGt(SampleU, One)));
+						if (!Simd::MaskAny(InsideU)) continue;
+						float SampleUs[4];
+						Simd::Store(SampleUs, Simd::Mul(SampleU, Simd::Splat(float(ViewSize.X))));
+						int32_t SampleX[4];
+						for (int32_t Lane = 0; Lane < 4; Lane++)
+						{
+							SampleX[Lane] = std::min(std::max(int32_t(std::floor(SampleUs[Lane])), 0), Current.Width - 1);
+						}
+						const bool bContiguous = SampleX[1] == SampleX[0] + 1 && SampleX[2] == SampleX[0] + 2 && SampleX[3] == SampleX[0] + 3;
+
+						for (int32_t OffsetY = -KernelRadius; OffsetY <= KernelRadius; OffsetY++)
+						{
+							const float SampleV = LocalV + OffsetY * ViewInvSize.Y;
+							if (SampleV < 0.0f || SampleV > 1.0f) continue;
+							const int32_t SampleY = std::min(std::max(int32_t(std::floor(SampleV * ViewSize.Y)), 0), Current.Height - 1);
+
+							auto Gather = [&](const TImage<float>& Plane)
+							{
+								const float* Row = &Plane(0, SampleY);
+								return bContiguous ? Simd::Load(Row + SampleX[0]) : Simd::Load4(Row[SampleX[0]], Row[SampleX[1]], Row[SampleX[2]], Row[SampleX[3]]);
+							};
+							const FFloat4x3 SampleYCoCg{ Gather(NeighborY), Gather(NeighborCo), Gather(NeighborCg) };
+							M1.X = Simd::Select(InsideU, Simd::Add(M1.X, SampleYCoCg.X), M1.X);
+							M1.Y = Simd::Select(InsideU, Simd::Add(M1.Y, SampleYCoCg.Y), M1.Y);
+							M1.Z = Simd::Select(InsideU, Simd::Add(M1.Z, SampleYCoCg.Z), M1.Z);
+							M2.X = Simd::Select(InsideU, Simd::Add(M2.X, Simd::Mul(SampleYCoCg.X, SampleYCoCg.X)), M2.X);
+							M2.Y = Simd::Select(InsideU, Simd::Add(M2.Y, Simd::Mul(SampleYCoCg.Y, SampleYCoCg.Y)), M2.Y);
+							M2.Z = Simd::Select(InsideU, Simd::Add(M2.Z, Simd::Mul(SampleYCoCg.Z, SampleYCoCg.Z)), M2.Z);
+							WeightSum = Simd::Select(InsideU, Simd::Add(WeightSum, One), WeightSum);
+						}
+					}
+					const FFloat4x3 Mean = Divide(M1, WeightSum);
+					const FFloat4x3 Variance{
+						Simd::Sub(Simd::Div(M2.X, WeightSum), Simd::Mul(Mean.X, Mean.X)),
+						Simd::Sub(Simd::Div(M2.Y, WeightSum), Simd::Mul(Mean.Y, Mean.Y)),
+						Simd::Sub(Simd::Div(M2.Z, WeightSum), Simd::Mul(Mean.Z, Mean.Z)) };
+					const FFloat4x3 Sigma{ Simd::Sqrt(Simd::Abs(Variance.X)), Simd::Sqrt(Simd::Abs(Variance.Y)), Simd::Sqrt(Simd::Abs(Variance.Z)) };
+					const FFloat4x3 MinYCoCg{ Simd::Sub(Mean.X, Simd::Mul(Sigma.X, Gamma)), Simd::Sub(Mean.Y, Simd::Mul(Sigma.Y, Gamma)), Simd::Sub(Mean.Z, Simd::Mul(Sigma.Z, Gamma)) };
+					const FFloat4x3 MaxYCoCg{ Simd::Add(Mean.X, Simd::Mul(Sigma.X, Gamma)), Simd::Add(Mean.Y, Simd::Mul(Sigma.Y, Gamma)), Simd::Add(Mean.Z, Simd::Mul(Sigma.Z, Gamma)) };
+
+					const FFloat4x3 CurrentColorRGB{ Simd::Load(CurrentR), Simd::Load(CurrentG), Simd::Load(CurrentB) };
+					const FFloat4 CurrentLuma = Simd::Dot(CurrentColorRGB, FVector3(0.3f, 0.59f, 0.11f));
+					const FFloat4 CurrentLuma2 = Simd::Mul(CurrentLuma, CurrentLuma);
+					const FMask4 OnScreen = Simd::MakeMask(bOnScreen[0], bOnScreen[1], bOnScreen[2], bOnScreen[3]);
+
+					// 历史值Clip到邻域的范围内；历史无效时读到的是0，与Dummy纹理一致
+					const FFloat4x3 HistoryRead{ Simd::Load(HistoryR), Simd::Load(HistoryG), Simd::Load(HistoryB) };
+					const FFloat4x3 ClampedHistoryYCoCg = Clamp(RGBToYCoCg(Tonemap(HistoryRead)), MinYCoCg, MaxYCoCg);
+					const FFloat4x3 HistoryColorRGB = Select(OnScreen, InverseTonemap(YCoCgToRGB(ClampedHistoryYCoCg)), CurrentColorRGB);
+					const FFloat4 HistorySecondMoment = Simd::Select(OnScreen, Simd::Load(HistoryMoment), CurrentLuma2);
+					const FFloat4 HistoryAccumulationCount = Simd::Select(OnScreen, Simd::Load(HistoryCount), Zero);
+
+					const FFloat4 CurrentAccumulationCount = Simd::Min(Simd::Splat(MaxAccumulation), Simd::Add(HistoryAccumulationCount, One));
+					const FFloat4 CurrentAlpha = Simd::Div(One, CurrentAccumulationCount);
+					FFloat4x3 FinalColor = Lerp(HistoryColorRGB, CurrentColorRGB, CurrentAlpha);
+					FinalColor = FFloat4x3{ Simd::Max(Zero, FinalColor.X), Simd::Max(Zero, FinalColor.Y), Simd::Max(Zero, FinalColor.Z) };
+					// x - x只有在x有限时为0
+					auto IsFinite = [&](FFloat4 V) { return Simd::CmpEq(Simd::Sub(V, V), Zero); };
+					const FMask4 bFinite = Simd::MaskAnd(Simd::MaskAnd(IsFinite(FinalColor.X), IsFinite(FinalColor.Y)), IsFinite(FinalColor.Z));
+					FinalColor = Select(bFinite, FinalColor, CurrentColorRGB);
+					const FFloat4 FinalMoment = Simd::Add(HistorySecondMoment, Simd::Mul(Simd::Sub(CurrentLuma2, HistorySecondMoment), CurrentAlpha));
+
+					float FinalR[4], FinalG[4], FinalB[4], FinalCount[4], FinalMoments[4];
+					Simd::Store(FinalR, FinalColor.X);
+					Simd::Store(FinalG, FinalColor.Y);
+					Simd::Store(FinalB, FinalColor.Z);
+					Simd::Store(FinalCount, CurrentAccumulationCount);
+					Simd::Store(FinalMoments, FinalMoment);
+					for (int32_t Lane = 0; Lane < NumLanes; Lane++)
+					{
+						// 天空像素没有GI，也不需要累积历史
+						if (!GBuffer(X + Lane, Y).bValid)
+						{
+							OutHistory.Color(X + Lane, Y) = FVector4(0.0f, 0.0f, 0.0f, 0.0f);
+							OutHistory.Moments(X + Lane, Y) = 0.0f;
+							continue;
+						}
+						OutHistory.Color(X + Lane, Y) = FVector4(FinalR[Lane], FinalG[Lane], FinalB[Lane], FinalCount[Lane]);
+						OutHistory.Moments(X + Lane, Y) = FinalMoments[Lane];
+					}
+				}
+			}
+		});
+	}
+}
@@ -0,0 +1,187 @@
+#include "SSGIReference.h"
+#include "SSGIReferenceSimd.h"
+
+namespace SSGIReference
+{
+	namespace
+	{
+		int32_t FloorLog2(uint32_t Value)
+		{
+			int32_t Log = -1;
+			while (Value)
+			{
+				Value >>= 1;
+				Log++;
+			}
+			return Log;
+		}
+
+		uint32_t RoundUpToPowerOfTwo(uint32_t Value)
+		{
+			uint32_t Result = 1;
+			while (Result < Value) Result <<= 1;
+			return Result;
+		}
+
+		// Mip0的Texel到SceneDepth像素的映射
+		struct FSourceMapping
+		{
+			FIntPoint ViewMin;
+			FIntPoint ViewMax;
+			FVector2 Scale;
+		};
+
+		// 16位存储时保守地向上取整，保证max归约不会变浅
+		float RoundUpToHalf(float Depth)
+		{
+			uint32_t Half = F32ToF16(Depth);
+			if (F16ToF32(Half) < Depth)
+			{
+				Half += 1;
+			}
+			return F16ToF32(Half);
+		}
+
+		// HZB.usf的LoadSceneDepth
+		float LoadSceneDepth(const TImage<float>& SceneDepth, FIntPoint Pos, FIntPoint Mip0Size, const FSourceMapping& Mapping, const FHZBSettings& Settings)
+		{
+			Pos.X = std::min(Pos.X, Mip0Size.X - 1);
+			Pos.Y = std::min(Pos.Y, Mip0Size.Y - 1);
+
+			float MaxDepth = 0.0f;
+			if (Settings.bCompact)
+			{
+				// Texel覆盖的深度像素范围，Scale在(1,2]之间时最多3x3
+				const int32_t StartX = std::min(Mapping.ViewMin.X + int32_t(std::floor(Pos.X * Mapping.Scale.X)), Mapping.ViewMax.X);
+				const int32_t StartY = std::min(Mapping.ViewMin.Y + int32_t(std::floor(Pos.Y * Mapping.Scale.Y)), Mapping.ViewMax.Y);
+				const int32_t EndX = std::max(std::min(Mapping.ViewMin.X + int32_t(std::ceil((Pos.X + 1) * Mapping.Scale.X)) - 1, Mapping.ViewMax.X), StartX);
+				const int32_t EndY = std::max(std::min(Mapping.ViewMin.Y + int32_t(std::ceil((Pos.Y + 1) * Mapping.Scale.Y)) - 1, Mapping.ViewMax.Y), StartY);
+				for (int32_t Y = StartY; Y <= EndY; Y++)
+				{
+					for (int32_t X = StartX; X <= EndX; X++)
+					{
+						MaxDepth = std::max(MaxDepth, SceneDepth(X, Y));
+					}
+				}
+			}
+			else
+			{
+				MaxDepth = SceneDepth(Pos.X, Pos.Y);
+			}
+
+			if (Settings.bHalfPrecision)
+			{
+				MaxDepth = RoundUpToHalf(MaxDepth);
+			}
+			return MaxDepth;
+		}
+
+		// Mip N的(x,y) = Mip N-1中2x2的最大值，越界坐标clamp到上一级的边界
+		void ReduceMip(const TImage<float>& Prev, TImage<float>& Out)
+		{
+			ParallelForTiles(Out.Size(), 64, [&](const FIntRect& Tile)
+			{
+				// 2x+1不越界的部分可以直接向量化，右边界的一列单独处理
+				const int32_t InteriorEndX = std::min(Tile.Max.X, Prev.Width / 2);
+				for (int32_t Y = Tile.Min.Y; Y < Tile.Max.Y; Y++)
+				{
+					const float* Row0 = &Prev(0, std::min(Y * 2, Prev.Height - 1));
+					const float* Row1 = &Prev(0, std::min(Y * 2 + 1, Prev.Height - 1));
+					float* OutRow = &Out(0, Y);
+
+					int32_t X = Tile.Min.X;
+#if SSGI_REFERENCE_SSE2
+					for (; X + 4 <= InteriorEndX; X += 4)
+					{
+						const __m128 A0 = _mm_loadu_ps(Row0 + X * 2);
+						const __m128 A1 = _mm_loadu_ps(Row0 + X * 2 + 4);
+						const __m128 B0 = _mm_loadu_ps(Row1 + X * 2);
+						const __m128 B1 = _mm_loadu_ps(Row1 + X * 2 + 4);
+						// 偶数列和奇数列分离后逐元素取max
+						const __m128 RowMax0 = _mm_max_ps(_mm_shuffle_ps(A0, A1, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(A0, A1, _MM_SHUFFLE(3, 1, 3, 1)));
+						const __m128 RowMax1 = _mm_max_ps(_mm_shuffle_ps(B0, B1, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(B0, B1, _MM_SHUFFLE(3, 1, 3, 1)));
+						_mm_storeu_ps(OutRow + X, _mm_max_ps(RowMax0, RowMax1));
+					}
+#elif SSGI_REFERENCE_NEON
+					for (; X + 4 <= InteriorEndX; X += 4)
+					{
+						// vld2q直接把偶数列和奇数列分开
+						const float32x4x2_t A = vld2q_f32(Row0 + X * 2);
+						const float32x4x2_t B = vld2q_f32(Row1 + X * 2);
+						vst1q_f32(OutRow + X, vmaxq_f32(vmaxq_f32(A.val[0], A.val[1]), vmaxq_f32(B.val[0], B.val[1])));
+					}
+#endif
+					for (; X < Tile.Max.X; X++)
+					{
+						const int32_t X0 = std::min(X * 2, Prev.Width - 1);
+						const int32_t X1 = std::min(X * 2 + 1, Prev.Width - 1);
+						OutRow[X] = std::max(std::max(Row0[X0], Row0[X1]), std::max(Row1[X0], Row1[X1]));
+					}
+				}
+			});
+		}
+	}
+
+	float FHZB::SampleLevel(const FVector2& UV, int32_t MipLevel) const
+	{
+		const TImage<float>& Mip = Mips[std::min(std::max(MipLevel, 0), NumMips() - 1)];
+		const int32_t X = int32_t(std::floor(UV.X * Mip.Width));
+		const int32_t Y = int32_t(std::floor(UV.Y * Mip.Height));
+		return Mip.LoadClamped(X, Y);
+	}
+
+	FHZB BuildHZB(const TImage<float>& SceneDepth, const FIntRect& ViewRect, const FHZBSettings& InSettings)
+	{
+		FHZBSettings Settings = InSettings;
+		Settings.bHalfPrecision = Settings.bCompact && Settings.bHalfPrecision;
+
+		const FIntPoint BufferSize = SceneDepth.Size();
+		const FIntPoint ViewSize = ViewRect.Size();
+
+		// 与插件中HZB尺寸和Mip数的计算一致
+		FHZB HZB;
+		HZB.Mip0Size = BufferSize;
+		int32_t NumMips = std::min(FloorLog2(uint32_t(std::max(BufferSize.X, BufferSize.Y))) + 1, kHZBMaxMipCount);
+		FSourceMapping Mapping;
+		Mapping.ViewMin = FIntPoint(0, 0);
+		Mapping.ViewMax = FIntPoint(BufferSize.X - 1, BufferSize.Y - 1);
+		Mapping.Scale = FVector2(1.0f, 1.0f);
+		if (Settings.bCompact)
+		{
+			HZB.Mip0Size.X = std::max(int32_t(RoundUpToPowerOfTwo(ViewSize.X) / 2), 1);
+			HZB.Mip0Size.Y = std::max(int32_t(RoundUpToPowerOfTwo(ViewSize.Y) / 2), 1);
+			NumMips = std::min(FloorLog2(uint32_t(std::min(HZB.Mip0Size.X, HZB.Mip0Size.Y))) + 1, kHZBMaxMipCount);
+			HZB.BufferUVToHZBUV = FVector4(
+				float(BufferSize.X) / ViewSize.X, float(BufferSize.Y) / ViewSize.Y,
+				-float(ViewRect.Min.X) / ViewSize.X, -float(ViewRect.Min.Y) / ViewSize.Y);
+			Mapping.ViewMin = ViewRect.Min;
+			Mapping.ViewMax = FIntPoint(ViewRect.Max.X - 1, ViewRect.Max.Y - 1);
+			Mapping.Scale = FVector2(float(ViewSize.X) / HZB.Mip0Size.X, float(ViewSize.Y) / HZB.Mip0Size.Y);
+		}
+
+		HZB.Mips.resize(NumMips);
+		for (int32_t MipLevel = 0; MipLevel < NumMips; MipLevel++)
+		{
+			HZB.Mips[MipLevel].Resize(std::max(HZB.Mip0Size.X >> MipLevel, 1), std::max(HZB.Mip0Size.Y >> MipLevel, 1));
+		}
+
+		// Mip0直接从SceneDepth读取
+		TImage<float>& Mip0 = HZB.Mips[0];
+		ParallelForTiles(Mip0.Size(), 64, [&](const FIntRect& Tile)
+		{
+			for (int32_t Y = Tile.Min.Y; Y < Tile.Max.Y; Y++)
+			{
+				for (int32_t X = Tile.Min.X; X < Tile.Max.X; X++)
+				{
+					Mip0(X, Y) = LoadSceneDepth(SceneDepth, FIntPoint(X, Y), HZB.Mip0Size, Mapping, Settings);
+				}
+			}
+		});
+
+		for (int32_t MipLevel = 1; MipLevel < NumMips; MipLevel++)
+		{
+			ReduceMip(HZB.Mips[MipLevel - 1], HZB.Mips[MipLevel]);
+		}
+		return HZB;
+	}
+}
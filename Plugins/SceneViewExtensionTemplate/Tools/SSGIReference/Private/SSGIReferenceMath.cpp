@@ -0,0 +1,108 @@
+#include "SSGIReferenceMath.h"
+
+namespace SSGIReference
+{
+	FMatrix44 FMatrix44::Inverse() const
+	{
+		// Gauss-Jordan消元，双精度避免投影矩阵求逆的精度损失
+		double A[4][8];
+		for (int32_t i = 0; i < 4; i++)
+		{
+			for (int32_t j = 0; j < 4; j++)
+			{
+				A[i][j] = M[i][j];
+				A[i][j + 4] = (i == j) ? 1.0 : 0.0;
+			}
+		}
+		for (int32_t Col = 0; Col < 4; Col++)
+		{
+			int32_t Pivot = Col;
+			for (int32_t Row = Col + 1; Row < 4; Row++)
+			{
+				if (std::abs(A[Row][Col]) > std::abs(A[Pivot][Col])) Pivot = Row;
+			}
+			if (Pivot != Col)
+			{
+				for (int32_t j = 0; j < 8; j++) std::swap(A[Col][j], A[Pivot][j]);
+			}
+			const double InvPivot = 1.0 / A[Col][Col];
+			for (int32_t j = 0; j < 8; j++) A[Col][j] *= InvPivot;
+			for (int32_t Row = 0; Row < 4; Row++)
+			{
+				if (Row == Col) continue;
+				const double Factor = A[Row][Col];
+				for (int32_t j = 0; j < 8; j++) A[Row][j] -= Factor * A[Col][j];
+			}
+		}
+		FMatrix44 Result;
+		for (int32_t i = 0; i < 4; i++)
+		{
+			for (int32_t j = 0; j < 4; j++)
+			{
+				Result.M[i][j] = float(A[i][j + 4]);
+			}
+		}
+		return Result;
+	}
+
+	uint32_t F32ToF16(float Value)
+	{
+		const uint32_t Bits = AsUint(Value);
+		const uint32_t Sign = (Bits >> 16) & 0x8000u;
+		const uint32_t Abs = Bits & 0x7FFFFFFFu;
+		// NaN / Inf
+		if (Abs >= 0x7F800000u)
+		{
+			return Sign | (Abs > 0x7F800000u ? 0x7E00u : 0x7C00u);
+		}
+		// 超出half的范围
+		if (Abs >= 0x47800000u)
+		{
+			return Sign | 0x7C00u;
+		}
+		// half的非规格化数
+		if (Abs < 0x38800000u)
+		{
+			if (Abs < 0x33000000u)
+			{
+				return Sign;
+			}
+			const uint32_t Exponent = Abs >> 23;
+			const uint32_t Mantissa = (Abs & 0x7FFFFFu) | 0x800000u;
+			const uint32_t Shift = 126 - Exponent;
+			uint32_t Half = Mantissa >> Shift;
+			const uint32_t Remainder = Mantissa & ((1u << Shift) - 1);
+			const uint32_t HalfWay = 1u << (Shift - 1);
+			if (Remainder > HalfWay || (Remainder == HalfWay && (Half & 1u)))
+			{
+				Half++;
+			}
+			return Sign | Half;
+		}
+		// 就近舍入到偶数，尾数进位会自然进到指数
+		uint32_t Half = (Abs - 0x38000000u) >> 13;
+		const uint32_t Remainder = Abs & 0x1FFFu;
+		if (Remainder > 0x1000u || (Remainder == 0x1000u && (Half & 1u)))
+		{
+			Half++;
+		}
+		return Sign | Half;
+	}
+
+	float F16ToF32(uint32_t Half)
+	{
+		const uint32_t Sign = (Half & 0x8000u) << 16;
+		const uint32_t Exponent = (Half >> 10) & 0x1Fu;
+		const uint32_t Mantissa = Half & 0x3FFu;
+		if (Exponent == 0)
+		{
+			const float Magnitude = std::ldexp(float(Mantissa), -24);
+			return Sign ? -Magnitude : Magnitude;
+		}
+		if (Exponent == 31)
+		{
+			return AsFloat(Sign | 0x7F800000u | (Mantissa << 13));
+		}
+		return AsFloat(Sign | ((Exponent + 112) << 23) | (Mantissa << 13));
+	}
+}
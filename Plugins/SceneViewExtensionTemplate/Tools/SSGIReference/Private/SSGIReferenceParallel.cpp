@@ -0,0 +1,165 @@
+#include "SSGIReference.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace SSGIReference
+{
+	namespace
+	{
+		std::atomic<int32_t> GNumWorkerThreads{ 0 };
+
+		// 常驻的工作线程，每个Pass只唤醒而不重新创建线程，Bench的每Pass耗时不包含线程创建
+		class FWorkerPool
+		{
+		public:
+			explicit FWorkerPool(int32_t InNumWorkers)
+			{
+				Workers.reserve(InNumWorkers);
+				for (int32_t WorkerIndex = 0; WorkerIndex < InNumWorkers; WorkerIndex++)
+				{
+					Workers.emplace_back([this]() { WorkerLoop(); });
+				}
+			}
+
+			~FWorkerPool()
+			{
+				{
+					std::lock_guard<std::mutex> Lock(Mutex);
+					bExit = true;
+				}
+				WakeCondition.notify_all();
+				for (std::thread& Worker : Workers)
+				{
+					Worker.join();
+				}
+			}
+
+			int32_t NumWorkers() const { return int32_t(Workers.size()); }
+
+			// 调用线程也参与执行，返回时所有工作线程都已离开Job
+			void Run(const std::function<void()>& InJob)
+			{
+				{
+					std::lock_guard<std::mutex> Lock(Mutex);
+					Job = &InJob;
+					NumBusy = int32_t(Workers.size());
+					Generation++;
+				}
+				WakeCondition.notify_all();
+				InJob();
+
+				std::unique_lock<std::mutex> Lock(Mutex);
+				DoneCondition.wait(Lock, [this]() { return NumBusy == 0; });
+				Job = nullptr;
+			}
+
+		private:
+			void WorkerLoop()
+			{
+				uint64_t SeenGeneration = 0;
+				for (;;)
+				{
+					const std::function<void()>* CurrentJob = nullptr;
+					{
+						std::unique_lock<std::mutex> Lock(Mutex);
+						WakeCondition.wait(Lock, [&]() { return bExit || Generation != SeenGeneration; });
+						if (bExit)
+						{
+							return;
+						}
+						SeenGeneration = Generation;
+						CurrentJob = Job;
+					}
+					(*CurrentJob)();
+					{
+						std::lock_guard<std::mutex> Lock(Mutex);
+						NumBusy--;
+					}
+					DoneCondition.notify_one();
+				}
+			}
+
+			std::vector<std::thread> Workers;
+			std::mutex Mutex;
+			std::condition_variable WakeCondition;
+			std::condition_variable DoneCondition;
+			const std::function<void()>* Job = nullptr;
+			uint64_t Generation = 0;
+			int32_t NumBusy = 0;
+			bool bExit = false;
+		};
+
+		// 同一时间只有一个ParallelForTiles使用线程池；线程数变化时重建
+		std::mutex GPoolMutex;
+		std::unique_ptr<FWorkerPool> GPool;
+		// 在Body里再调用ParallelForTiles时串行执行，避免等待自己
+		thread_local bool GInsideParallelFor = false;
+	}
+
+	void SetNumWorkerThreads(int32_t NumThreads)
+	{
+		GNumWorkerThreads = std::max(NumThreads, 0);
+	}
+
+	int32_t GetNumWorkerThreads()
+	{
+		const int32_t NumThreads = GNumWorkerThreads;
+		if (NumThreads > 0)
+		{
+			return NumThreads;
+		}
+		return std::max(int32_t(std::thread::hardware_concurrency()), 1);
+	}
+
+	void ParallelForTiles(FIntPoint Size, int32_t TileSize, const std::function<void(const FIntRect& Tile)>& Body)
+	{
+		if (Size.X <= 0 || Size.Y <= 0)
+		{
+			return;
+		}
+		TileSize = std::max(TileSize, 1);
+		const int32_t TilesX = (Size.X + TileSize - 1) / TileSize;
+		const int32_t TilesY = (Size.Y + TileSize - 1) / TileSize;
+		const int32_t NumTiles = TilesX * TilesY;
+
+		// 和GPU的线程组一样动态领取Tile，追踪这种开销不均匀的Pass也能负载均衡
+		std::atomic<int32_t> NextTile{ 0 };
+		const std::function<void()> Worker = [&]()
+		{
+			const bool bWasInside = GInsideParallelFor;
+			GInsideParallelFor = true;
+			for (;;)
+			{
+				const int32_t TileIndex = NextTile.fetch_add(1);
+				if (TileIndex >= NumTiles)
+				{
+					break;
+				}
+				const int32_t MinX = (TileIndex % TilesX) * TileSize;
+				const int32_t MinY = (TileIndex / TilesX) * TileSize;
+				Body(FIntRect(MinX, MinY, std::min(MinX + TileSize, Size.X), std::min(MinY + TileSize, Size.Y)));
+			}
+			GInsideParallelFor = bWasInside;
+		};
+
+		// 线程池里始终是GetNumWorkerThreads() - 1个线程，Tile少于线程数时多余的线程领不到Tile直接返回
+		const int32_t NumWorkers = GetNumWorkerThreads() - 1;
+		if (NumWorkers <= 0 || NumTiles <= 1 || GInsideParallelFor)
+		{
+			Worker();
+			return;
+		}
+
+		std::lock_guard<std::mutex> Lock(GPoolMutex);
+		if (!GPool || GPool->NumWorkers() != NumWorkers)
+		{
+			GPool.reset();
+			GPool = std::make_unique<FWorkerPool>(NumWorkers);
+		}
+		GPool->Run(Worker);
+	}
+}
@@ -0,0 +1,137 @@
+#include "SSGIReference.h"
+
+#include <limits>
+
+namespace SSGIReference
+{
+	namespace
+	{
+		struct FSurfaceHit
+		{
+			float T = std::numeric_limits<float>::max();
+			FVector3 Normal;
+			FVector3 Albedo;
+			FVector3 Emission;
+		};
+
+		// 轴对齐的矩形：Axis为法线轴，Offset为该轴上的坐标，其余两轴在[Min, Max]内
+		struct FQuad
+		{
+			int32_t Axis;
+			float Offset;
+			FVector3 Min;
+			FVector3 Max;
+			FVector3 Normal;
+			FVector3 Albedo;
+		};
+
+		struct FSphere
+		{
+			FVector3 Center;
+			float Radius;
+			FVector3 Albedo;
+			FVector3 Emission;
+		};
+
+		float GetAxis(const FVector3& V, int32_t Axis)
+		{
+			return Axis == 0 ? V.X : (Axis == 1 ? V.Y : V.Z);
+		}
+
+		void IntersectQuad(const FVector3& Dir, const FQuad& Quad, FSurfaceHit& Hit)
+		{
+			const float DirAxis = GetAxis(Dir, Quad.Axis);
+			if (std::abs(DirAxis) < 1e-6f) return;
+			const float T = Quad.Offset / DirAxis;
+			if (T <= 0.0f || T >= Hit.T) return;
+			const FVector3 P = Dir * T;
+			for (int32_t Axis = 0; Axis < 3; Axis++)
+			{
+				if (Axis == Quad.Axis) continue;
+				if (GetAxis(P, Axis) < GetAxis(Quad.Min, Axis) || GetAxis(P, Axis) > GetAxis(Quad.Max, Axis)) return;
+			}
+			Hit.T = T;
+			Hit.Normal = Quad.Normal;
+			Hit.Albedo = Quad.Albedo;
+			Hit.Emission = FVector3(0.0f);
+		}
+
+		void IntersectSphere(const FVector3& Dir, const FSphere& Sphere, FSurfaceHit& Hit)
+		{
+			// 光线从原点出发，Dir未归一化
+			const float A = Dot(Dir, Dir);
+			const float B = -2.0f * Dot(Dir, Sphere.Center);
+			const float C = Dot(Sphere.Center, Sphere.Center) - Sphere.Radius * Sphere.Radius;
+			const float Discriminant = B * B - 4.0f * A * C;
+			if (Discriminant < 0.0f) return;
+			const float T = (-B - std::sqrt(Discriminant)) / (2.0f * A);
+			if (T <= 0.0f || T >= Hit.T) return;
+			Hit.T = T;
+			Hit.Normal = Normalize(Dir * T - Sphere.Center);
+			Hit.Albedo = Sphere.Albedo;
+			Hit.Emission = Sphere.Emission;
+		}
+	}
+
+	FSyntheticScene MakeSyntheticScene(FIntPoint Size, uint32_t FrameIndex)
+	{
+		FSyntheticScene Scene;
+		Scene.View = MakePerspectiveView(Size, FIntRect(0, 0, Size.X, Size.Y), 90.0f, 10.0f);
+		Scene.View.FrameIndex = FrameIndex % 1024;
+
+		// 相机在原点看向+Z，开口朝上的房间，上方能看到天空
+		const FQuad Quads[] =
+		{
+			{ 1, -100.0f, FVector3(-250.0f, 0.0f, 50.0f), FVector3(250.0f, 0.0f, 700.0f), FVector3(0.0f, 1.0f, 0.0f), FVector3(0.7f) },
+			{ 0, -250.0f, FVector3(0.0f, -100.0f, 50.0f), FVector3(0.0f, 200.0f, 700.0f), FVector3(1.0f, 0.0f, 0.0f), FVector3(0.8f, 0.1f, 0.1f) },
+			{ 0, 250.0f, FVector3(0.0f, -100.0f, 50.0f), FVector3(0.0f, 200.0f, 700.0f), FVector3(-1.0f, 0.0f, 0.0f), FVector3(0.1f, 0.8f, 0.1f) },
+			{ 2, 700.0f, FVector3(-250.0f, -100.0f, 0.0f), FVector3(250.0f, 200.0f, 0.0f), FVector3(0.0f, 0.0f, -1.0f), FVector3(0.8f) },
+		};
+		const FSphere Spheres[] =
+		{
+			{ FVector3(-80.0f, -40.0f, 350.0f), 60.0f, FVector3(0.9f), FVector3(0.0f) },
+			{ FVector3(100.0f, -60.0f, 450.0f), 40.0f, FVector3(0.9f, 0.8f, 0.2f), FVector3(4.0f, 3.0f, 0.5f) },
+		};
+		const FVector3 LightDir = Normalize(FVector3(0.3f, 1.0f, -0.4f));
+
+		Scene.SceneDepth.Resize(Size.X, Size.Y);
+		Scene.WorldNormal.Resize(Size.X, Size.Y, FVector3(0.0f, 0.0f, 1.0f));
+		Scene.SceneColor.Resize(Size.X, Size.Y);
+		Scene.BaseColor.Resize(Size.X, Size.Y);
+		Scene.AmbientOcclusion.Resize(Size.X, Size.Y, 1.0f);
+		Scene.Velocity.Resize(Size.X, Size.Y);
+
+		const float ScaleX = Scene.View.TranslatedWorldToClip.M[0][0];
+		const float ScaleY = Scene.View.TranslatedWorldToClip.M[1][1];
+		ParallelForTiles(Size, 32, [&](const FIntRect& Tile)
+		{
+			for (int32_t Y = Tile.Min.Y; Y < Tile.Max.Y; Y++)
+			{
+				for (int32_t X = Tile.Min.X; X < Tile.Max.X; X++)
+				{
+					const float NDCX = (X + 0.5f) / Size.X * 2.0f - 1.0f;
+					const float NDCY = 1.0f - (Y + 0.5f) / Size.Y * 2.0f;
+					// Z分量为1，T即线性深度
+					const FVector3 Dir(NDCX / ScaleX, NDCY / ScaleY, 1.0f);
+
+					FSurfaceHit Hit;
+					for (const FQuad& Quad : Quads) IntersectQuad(Dir, Quad, Hit);
+					for (const FSphere& Sphere : Spheres) IntersectSphere(Dir, Sphere, Hit);
+
+					if (Hit.T == std::numeric_limits<float>::max())
+					{
+						// 天空：DeviceZ为0
+						Scene.SceneDepth(X, Y) = 0.0f;
+						Scene.SceneColor(X, Y) = FVector3(0.3f, 0.5f, 0.9f);
+						continue;
+					}
+					Scene.SceneDepth(X, Y) = Scene.View.ConvertToDeviceZ(Hit.T);
+					Scene.WorldNormal(X, Y) = Hit.Normal;
+					Scene.BaseColor(X, Y) = Hit.Albedo;
+					Scene.SceneColor(X, Y) = Hit.Albedo * (0.1f + std::max(Dot(Hit.Normal, LightDir), 0.0f)) + Hit.Emission;
+				}
+			}
+		});
+		return Scene;
+	}
+}
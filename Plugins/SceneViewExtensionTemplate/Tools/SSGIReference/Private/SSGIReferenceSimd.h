@@ -0,0 +1,155 @@
+// SSGIReferenceSimd.h
+// 4路float向量的最小封装：SSE2、AArch64 NEON，其余平台退回逐元素的标量实现
+// Min/Max/Select的语义与std::min/std::max/三目运算逐元素一致（包括NaN），向量化的Pass与标量代码逐位相同
+#pragma once
+
+#include "SSGIReferenceMath.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SSGI_REFERENCE_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define SSGI_REFERENCE_NEON 1
+#endif
+
+namespace SSGIReference
+{
+	namespace Simd
+	{
+#if SSGI_REFERENCE_SSE2
+		using FFloat4 = __m128;
+		using FMask4 = __m128;
+
+		inline FFloat4 Load(const float* Ptr) { return _mm_loadu_ps(Ptr); }
+		inline void Store(float* Ptr, FFloat4 V) { _mm_storeu_ps(Ptr, V); }
+		inline FFloat4 Splat(float S) { return _mm_set1_ps(S); }
+		inline FFloat4 Add(FFloat4 A, FFloat4 B) { return _mm_add_ps(A, B); }
+		inline FFloat4 Sub(FFloat4 A, FFloat4 B) { return _mm_sub_ps(A, B); }
+		inline FFloat4 Mul(FFloat4 A, FFloat4 B) { return _mm_mul_ps(A, B); }
+		inline FFloat4 Div(FFloat4 A, FFloat4 B) { return _mm_div_ps(A, B); }
+		inline FFloat4 Sqrt(FFloat4 V) { return _mm_sqrt_ps(V); }
+		inline FFloat4 Abs(FFloat4 V) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), V); }
+		inline FFloat4 Neg(FFloat4 V) { return _mm_xor_ps(_mm_set1_ps(-0.0f), V); }
+		inline FMask4 CmpLt(FFloat4 A, FFloat4 B) { return _mm_cmplt_ps(A, B); }
+		inline FMask4 CmpGt(FFloat4 A, FFloat4 B) { return _mm_cmpgt_ps(A, B); }
+		inline FMask4 CmpEq(FFloat4 A, FFloat4 B) { return _mm_cmpeq_ps(A, B); }
+		inline FMask4 MaskAnd(FMask4 A, FMask4 B) { return _mm_and_ps(A, B); }
+		inline FMask4 MaskOr(FMask4 A, FMask4 B) { return _mm_or_ps(A, B); }
+		inline FMask4 MaskNot(FMask4 M) { return _mm_xor_ps(M, _mm_castsi128_ps(_mm_set1_epi32(-1))); }
+		inline bool MaskAny(FMask4 M) { return _mm_movemask_ps(M) != 0; }
+		// 每个Lane为true或false
+		inline FMask4 MakeMask(bool B0, bool B1, bool B2, bool B3) { return _mm_castsi128_ps(_mm_setr_epi32(-int32_t(B0), -int32_t(B1), -int32_t(B2), -int32_t(B3))); }
+		// Mask ? A : B
+		inline FFloat4 Select(FMask4 Mask, FFloat4 A, FFloat4 B) { return _mm_or_ps(_mm_and_ps(Mask, A), _mm_andnot_ps(Mask, B)); }
+		// A < B ? A : B，即std::min(B, A)
+		inline FFloat4 Min(FFloat4 A, FFloat4 B) { return _mm_min_ps(A, B); }
+		// A > B ? A : B，即std::max(B, A)
+		inline FFloat4 Max(FFloat4 A, FFloat4 B) { return _mm_max_ps(A, B); }
+#elif SSGI_REFERENCE_NEON
+		using FFloat4 = float32x4_t;
+		using FMask4 = uint32x4_t;
+
+		inline FFloat4 Load(const float* Ptr) { return vld1q_f32(Ptr); }
+		inline void Store(float* Ptr, FFloat4 V) { vst1q_f32(Ptr, V); }
+		inline FFloat4 Splat(float S) { return vdupq_n_f32(S); }
+		inline FFloat4 Add(FFloat4 A, FFloat4 B) { return vaddq_f32(A, B); }
+		inline FFloat4 Sub(FFloat4 A, FFloat4 B) { return vsubq_f32(A, B); }
+		inline FFloat4 Mul(FFloat4 A, FFloat4 B) { return vmulq_f32(A, B); }
+		inline FFloat4 Div(FFloat4 A, FFloat4 B) { return vdivq_f32(A, B); }
+		inline FFloat4 Sqrt(FFloat4 V) { return vsqrtq_f32(V); }
+		inline FFloat4 Abs(FFloat4 V) { return vabsq_f32(V); }
+		inline FFloat4 Neg(FFloat4 V) { return vnegq_f32(V); }
+		inline FMask4 CmpLt(FFloat4 A, FFloat4 B) { return vcltq_f32(A, B); }
+		inline FMask4 CmpGt(FFloat4 A, FFloat4 B) { return vcgtq_f32(A, B); }
+		inline FMask4 CmpEq(FFloat4 A, FFloat4 B) { return vceqq_f32(A, B); }
+		inline FMask4 MaskAnd(FMask4 A, FMask4 B) { return vandq_u32(A, B); }
+		inline FMask4 MaskOr(FMask4 A, FMask4 B) { return vorrq_u32(A, B); }
+		inline FMask4 MaskNot(FMask4 M) { return vmvnq_u32(M); }
+		inline bool MaskAny(FMask4 M) { return vmaxvq_u32(M) != 0; }
+		inline FMask4 MakeMask(bool B0, bool B1, bool B2, bool B3)
+		{
+			const uint32_t Lanes[4] = { B0 ? ~0u : 0u, B1 ? ~0u : 0u, B2 ? ~0u : 0u, B3 ? ~0u : 0u };
+			return vld1q_u32(Lanes);
+		}
+		inline FFloat4 Select(FMask4 Mask, FFloat4 A, FFloat4 B) { return vbslq_f32(Mask, A, B); }
+		// vminq/vmaxq遇到NaN返回NaN，这里按比较结果选择，与SSE和标量代码一致
+		inline FFloat4 Min(FFloat4 A, FFloat4 B) { return vbslq_f32(vcltq_f32(A, B), A, B); }
+		inline FFloat4 Max(FFloat4 A, FFloat4 B) { return vbslq_f32(vcgtq_f32(A, B), A, B); }
+#else
+		struct FFloat4 { float V[4]; };
+		struct FMask4 { bool V[4]; };
+
+		template<typename FunctionType>
+		inline FFloat4 Map(FFloat4 A, FFloat4 B, FunctionType Function) { FFloat4 R; for (int32_t i = 0; i < 4; i++) R.V[i] = Function(A.V[i], B.V[i]); return R; }
+		template<typename FunctionType>
+		inline FMask4 Compare(FFloat4 A, FFloat4 B, FunctionType Function) { FMask4 R; for (int32_t i = 0; i < 4; i++) R.V[i] = Function(A.V[i], B.V[i]); return R; }
+
+		inline FFloat4 Load(const float* Ptr) { FFloat4 R; std::memcpy(R.V, Ptr, sizeof(R.V)); return R; }
+		inline void Store(float* Ptr, FFloat4 V) { std::memcpy(Ptr, V.V, sizeof(V.V)); }
+		inline FFloat4 Splat(float S) { return FFloat4{ { S, S, S, S } }; }
+		inline FFloat4 Add(FFloat4 A, FFloat4 B) { return Map(A, B, [](float X, float Y) { return X + Y; }); }
+		inline FFloat4 Sub(FFloat4 A, FFloat4 B) { return Map(A, B, [](float X, float Y) { return X - Y; }); }
+		inline FFloat4 Mul(FFloat4 A, FFloat4 B) { return Map(A, B, [](float X, float Y) { return X * Y; }); }
+		inline FFloat4 Div(FFloat4 A, FFloat4 B) { return Map(A, B, [](float X, float Y) { return X / Y; }); }
+		inline FFloat4 Sqrt(FFloat4 V) { return Map(V, V, [](float X, float) { return std::sqrt(X); }); }
+		inline FFloat4 Abs(FFloat4 V) { return Map(V, V, [](float X, float) { return std::abs(X); }); }
+		inline FFloat4 Neg(FFloat4 V) { return Map(V, V, [](float X, float) { return -X; }); }
+		inline FMask4 CmpLt(FFloat4 A, FFloat4 B) { return Compare(A, B, [](float X, float Y) { return X < Y; }); }
+		inline FMask4 CmpGt(FFloat4 A, FFloat4 B) { return Compare(A, B, [](float X, float Y) { return X > Y; }); }
+		inline FMask4 CmpEq(FFloat4 A, FFloat4 B) { return Compare(A, B, [](float X, float Y) { return X == Y; }); }
+		inline FMask4 MaskAnd(FMask4 A, FMask4 B) { FMask4 R; for (int32_t i = 0; i < 4; i++) R.V[i] = A.V[i] && B.V[i]; return R; }
+		inline FMask4 MaskOr(FMask4 A, FMask4 B) { FMask4 R; for (int32_t i = 0; i < 4; i++) R.V[i] = A.V[i] || B.V[i]; return R; }
+		inline FMask4 MaskNot(FMask4 M) { FMask4 R; for (int32_t i = 0; i < 4; i++) R.V[i] = !M.V[i]; return R; }
+		inline bool MaskAny(FMask4 M) { return M.V[0] || M.V[1] || M.V[2] || M.V[3]; }
+		inline FMask4 MakeMask(bool B0, bool B1, bool B2, bool B3) { return FMask4{ { B0, B1, B2, B3 } }; }
+		inline FFloat4 Select(FMask4 Mask, FFloat4 A, FFloat4 B) { FFloat4 R; for (int32_t i = 0; i < 4; i++) R.V[i] = Mask.V[i] ? A.V[i] : B.V[i]; return R; }
+		inline FFloat4 Min(FFloat4 A, FFloat4 B) { return Map(A, B, [](float X, float Y) { return X < Y ? X : Y; }); }
+		inline FFloat4 Max(FFloat4 A, FFloat4 B) { return Map(A, B, [](float X, float Y) { return X > Y ? X : Y; }); }
+#endif
+
+		inline FFloat4 Load4(float V0, float V1, float V2, float V3)
+		{
+			const float Lanes[4] = { V0, V1, V2, V3 };
+			return Load(Lanes);
+		}
+
+		inline float GetLane(FFloat4 V, int32_t Lane)
+		{
+			float Lanes[4];
+			Store(Lanes, V);
+			return Lanes[Lane];
+		}
+
+		// 没有与std::exp逐位一致的向量实现，逐Lane调用标量函数
+		inline FFloat4 Exp(FFloat4 V)
+		{
+			float Lanes[4];
+			Store(Lanes, V);
+			for (float& Lane : Lanes)
+			{
+				Lane = std::exp(Lane);
+			}
+			return Load(Lanes);
+		}
+
+		// RGB各一个向量，对应4个相邻像素
+		struct FFloat4x3
+		{
+			FFloat4 X;
+			FFloat4 Y;
+			FFloat4 Z;
+		};
+
+		// 与Dot(FVector3, FVector3)相同的求和顺序
+		inline FFloat4 Dot(const FFloat4x3& A, const FFloat4x3& B)
+		{
+			return Add(Add(Mul(A.X, B.X), Mul(A.Y, B.Y)), Mul(A.Z, B.Z));
+		}
+
+		inline FFloat4 Dot(const FFloat4x3& A, const FVector3& B)
+		{
+			return Add(Add(Mul(A.X, Splat(B.X)), Mul(A.Y, Splat(B.Y))), Mul(A.Z, Splat(B.Z)));
+		}
+	}
+}
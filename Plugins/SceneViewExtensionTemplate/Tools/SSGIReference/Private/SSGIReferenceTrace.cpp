@@ -0,0 +1,642 @@
+#include "SSGIReference.h"
+
+#include <atomic>
+
+namespace SSGIReference
+{
+	namespace
+	{
+		constexpr float kPI = 3.14159265358979323846f;
+
+		/**
+		 * GBuffer编码，与SSGIGBufferCommon.ush一致
+		 */
+		// UE的UnitVectorToOctahedron，输出映射到[0,1]
+		FVector2 EncodeOctahedron(const FVector3& N)
+		{
+			const float InvL1 = 1.0f / (std::abs(N.X) + std::abs(N.Y) + std::abs(N.Z));
+			FVector2 Oct(N.X * InvL1, N.Y * InvL1);
+			if (N.Z <= 0.0f)
+			{
+				Oct = FVector2(
+					(1.0f - std::abs(Oct.Y)) * (Oct.X >= 0.0f ? 1.0f : -1.0f),
+					(1.0f - std::abs(Oct.X)) * (Oct.Y >= 0.0f ? 1.0f : -1.0f));
+			}
+			return FVector2(Oct.X * 0.5f + 0.5f, Oct.Y * 0.5f + 0.5f);
+		}
+
+		FVector3 CustomOctahedralDecode(FVector2 Oct)
+		{
+			Oct = FVector2(Oct.X * 2.0f - 1.0f, Oct.Y * 2.0f - 1.0f);
+			FVector3 N(Oct.X, Oct.Y, 1.0f - std::abs(Oct.X) - std::abs(Oct.Y));
+			if (N.Z < 0.0f)
+			{
+				const float SignX = N.X >= 0.0f ? 1.0f : -1.0f;
+				const float SignY = N.Y >= 0.0f ? 1.0f : -1.0f;
+				const float NewX = (1.0f - std::abs(N.Y)) * SignX;
+				const float NewY = (1.0f - std::abs(N.X)) * SignY;
+				N.X = NewX;
+				N.Y = NewY;
+			}
+			return Normalize(N);
+		}
+
+		// 16:16 unorm量化
+		FVector3 QuantizeNormal(const FVector3& WorldNormal)
+		{
+			const FVector2 Oct = EncodeOctahedron(WorldNormal);
+			const float OctX = std::round(Saturate(Oct.X) * 65535.0f) / 65535.0f;
+			const float OctY = std::round(Saturate(Oct.Y) * 65535.0f) / 65535.0f;
+			return CustomOctahedralDecode(FVector2(OctX, OctY));
+		}
+
+		/**
+		 * SSGI.usf的随机数和采样
+		 */
+		uint32_t Hash(uint32_t X)
+		{
+			X = ((X >> 16) ^ X) * 0x45d9f3bu;
+			X = ((X >> 16) ^ X) * 0x45d9f3bu;
+			X = (X >> 16) ^ X;
+			return X;
+		}
+
+		uint32_t RandInit(FIntPoint PixelPos, uint32_t FrameIndex, uint32_t Seed)
+		{
+			uint32_t CombinedSeed = uint32_t(PixelPos.X) + (uint32_t(PixelPos.Y) << 16);
+			CombinedSeed = Hash(CombinedSeed ^ Hash(FrameIndex));
+			CombinedSeed = Hash(CombinedSeed ^ Hash(Seed));
+			return CombinedSeed;
+		}
+
+		float Rand(uint32_t& RandState)
+		{
+			RandState = RandState * 1664525u + 1013904223u;
+			return float(RandState) / 4294967296.0f;
+		}
+
+		float Frac(float X)
+		{
+			return X - std::floor(X);
+		}
+
+		// 与SSGICommon.ush的GetSSGIHemisphereSample一致
+		FVector2 GetHemisphereSample(int32_t SamplingMode, FIntPoint PixelPos, uint32_t FrameIndex, uint32_t SequenceFrameIndex, uint32_t NumSamples, uint32_t SampleIndex)
+		{
+			if (SamplingMode == 0)
+			{
+				uint32_t RandState = RandInit(PixelPos, FrameIndex, SampleIndex);
+				const float E0 = Rand(RandState);
+				const float E1 = Rand(RandState);
+				return FVector2(E0, E1);
+			}
+
+			const uint32_t SequenceIndex = SequenceFrameIndex * NumSamples + SampleIndex;
+			const uint32_t R2X = SequenceIndex * 3242174889u;
+			const uint32_t R2Y = SequenceIndex * 2447445413u;
+			const float OffsetX = Frac(52.9829189f * Frac(PixelPos.X * 0.06711056f + PixelPos.Y * 0.00583715f));
+			const float OffsetY = Frac(PixelPos.X * 0.75487766f + PixelPos.Y * 0.56984029f);
+			return FVector2(
+				Frac(float(R2X >> 8) * (1.0f / 16777216.0f) + OffsetX),
+				Frac(float(R2Y >> 8) * (1.0f / 16777216.0f) + OffsetY));
+		}
+
+		// UE的CosineSampleHemisphere
+		FVector3 CosineSampleHemisphere(float E0, float E1)
+		{
+			const float Phi = 2.0f * kPI * E0;
+			const float CosTheta = std::sqrt(E1);
+			const float SinTheta = std::sqrt(1.0f - CosTheta * CosTheta);
+			return FVector3(SinTheta * std::cos(Phi), SinTheta * std::sin(Phi), CosTheta);
+		}
+
+		// UE的GetTangentBasis，返回mul(LocalDir, TangentToWorld)
+		FVector3 TangentToWorld(const FVector3& LocalDir, const FVector3& TangentZ)
+		{
+			const float Sign = TangentZ.Z >= 0.0f ? 1.0f : -1.0f;
+			const float A = -1.0f / (Sign + TangentZ.Z);
+			const float B = TangentZ.X * TangentZ.Y * A;
+			const FVector3 TangentX(1.0f + Sign * A * TangentZ.X * TangentZ.X, Sign * B, -Sign * TangentZ.X);
+			const FVector3 TangentY(B, Sign + A * TangentZ.Y * TangentZ.Y, -TangentZ.Y);
+			return TangentX * LocalDir.X + TangentY * LocalDir.Y + TangentZ * LocalDir.Z;
+		}
+
+		FVector3 SampleBilinear(const TImage<FVector3>& Image, const FVector2& UV)
+		{
+			const float X = UV.X * Image.Width - 0.5f;
+			const float Y = UV.Y * Image.Height - 0.5f;
+			const int32_t X0 = int32_t(std::floor(X));
+			const int32_t Y0 = int32_t(std::floor(Y));
+			const float FracX = X - X0;
+			const float FracY = Y - Y0;
+			const FVector3 Top = Lerp(Image.LoadClamped(X0, Y0), Image.LoadClamped(X0 + 1, Y0), FracX);
+			const FVector3 Bottom = Lerp(Image.LoadClamped(X0, Y0 + 1), Image.LoadClamped(X0 + 1, Y0 + 1), FracX);
+			return Lerp(Top, Bottom, FracY);
+		}
+
+		FVector3 SampleTrilinear(const FRadianceCache& Cache, const FVector2& UV, float Mip)
+		{
+			const int32_t Mip0 = int32_t(std::floor(Mip));
+			const int32_t Mip1 = std::min(Mip0 + 1, int32_t(Cache.Mips.size()) - 1);
+			return Lerp(SampleBilinear(Cache.Mips[Mip0], UV), SampleBilinear(Cache.Mips[Mip1], UV), Mip - float(Mip0));
+		}
+
+		int32_t GetResolutionDivisor(int32_t ResolutionDivisor)
+		{
+			return ResolutionDivisor >= 4 ? 4 : (ResolutionDivisor >= 2 ? 2 : 1);
+		}
+
+		// 与插件的GetTraceOffset一致
+		FIntPoint GetTraceOffset(int32_t ResolutionDivisor, uint32_t FrameIndex)
+		{
+			static const FIntPoint Pattern2x2[4] = { FIntPoint(0, 0), FIntPoint(1, 1), FIntPoint(1, 0), FIntPoint(0, 1) };
+			if (ResolutionDivisor == 2)
+			{
+				return Pattern2x2[FrameIndex % 4];
+			}
+			if (ResolutionDivisor == 4)
+			{
+				const FIntPoint Coarse = Pattern2x2[FrameIndex % 4];
+				const FIntPoint Fine = Pattern2x2[(FrameIndex / 4) % 4];
+				return FIntPoint(Coarse.X * 2 + Fine.X, Coarse.Y * 2 + Fine.Y);
+			}
+			return FIntPoint(0, 0);
+		}
+	}
+
+	FViewInfo MakePerspectiveView(FIntPoint BufferSize, const FIntRect& ViewRect, float FovXDegrees, float NearPlane, const FMatrix44& WorldToView)
+	{
+		const FIntPoint ViewSize = ViewRect.Size();
+		const float HalfFovX = FovXDegrees * 0.5f * kPI / 180.0f;
+		const float ScaleX = 1.0f / std::tan(HalfFovX);
+		const float ScaleY = ScaleX * float(ViewSize.X) / float(ViewSize.Y);
+
+		// UE的FReversedZPerspectiveMatrix（远平面无限远）
+		FMatrix44 Projection;
+		Projection.M[0][0] = ScaleX;
+		Projection.M[1][1] = ScaleY;
+		Projection.M[2][3] = 1.0f;
+		Projection.M[3][2] = NearPlane;
+
+		FViewInfo View;
+		View.BufferSize = BufferSize;
+		View.ViewRect = ViewRect;
+		View.NearPlane = NearPlane;
+		View.TranslatedWorldToClip = WorldToView * Projection;
+		View.ClipToTranslatedWorld = View.TranslatedWorldToClip.Inverse();
+		return View;
+	}
+
+	TImage<FGBufferSample> DecodeGBuffer(const TImage<float>& SceneDepth, const TImage<FVector3>& WorldNormal, const FViewInfo& View)
+	{
+		const FIntPoint ViewSize = View.ViewRect.Size();
+		TImage<FGBufferSample> GBuffer(ViewSize.X, ViewSize.Y);
+		ParallelForTiles(ViewSize, 16, [&](const FIntRect& Tile)
+		{
+			for (int32_t Y = Tile.Min.Y; Y < Tile.Max.Y; Y++)
+			{
+				for (int32_t X = Tile.Min.X; X < Tile.Max.X; X++)
+				{
+					const int32_t BufferX = X + View.ViewRect.Min.X;
+					const int32_t BufferY = Y + View.ViewRect.Min.Y;
+					const float DeviceZ = SceneDepth(BufferX, BufferY);
+
+					// 与SSGI追踪的天空判断保持一致
+					FGBufferSample& Sample = GBuffer(X, Y);
+					Sample.bValid = DeviceZ > 0.00001f;
+					Sample.LinearDepth = Sample.bValid ? View.ConvertFromDeviceZ(DeviceZ) : 0.0f;
+					Sample.WorldNormal = QuantizeNormal(WorldNormal(BufferX, BufferY));
+				}
+			}
+		});
+		return GBuffer;
+	}
+
+	FHiZTraceResult HiZTrace(const FHiZTraceInput& Input, const FHZB& HZB, const FViewInfo& View)
+	{
+		FHiZTraceResult Result;
+		const FVector4 HZBSize = HZB.GetSizeAndInvSize();
+
+		// 光线变换到HZB的UV空间中追踪，仿射变换不影响求交
+		const FVector2 UVScale(HZB.BufferUVToHZBUV.X, HZB.BufferUVToHZBUV.Y);
+		const FVector2 UVBias(HZB.BufferUVToHZBUV.Z, HZB.BufferUVToHZBUV.W);
+		FVector3 CurrentPos(Input.RayOrigin.X * UVScale.X + UVBias.X, Input.RayOrigin.Y * UVScale.Y + UVBias.Y, Input.RayOrigin.Z);
+		const FVector3 RayDir(Input.RayDirection.X * UVScale.X, Input.RayDirection.Y * UVScale.Y, Input.RayDirection.Z);
+		const FVector2 ValidUVMin = Input.ValidUVMin * UVScale + UVBias;
+		const FVector2 ValidUVMax = Input.ValidUVMax * UVScale + UVBias;
+
+		// 与InitHiZTrace一致，深度方向也用倒数相乘，舍入和Shader相同
+		const FVector3 InvRayDir(
+			(std::abs(RayDir.X) < 1e-6f) ? 1e6f : 1.0f / RayDir.X,
+			(std::abs(RayDir.Y) < 1e-6f) ? 1e6f : 1.0f / RayDir.Y,
+			(std::abs(RayDir.Z) < 1e-6f) ? 1e6f : 1.0f / RayDir.Z);
+
+		int32_t CurrentMip = 0;
+		float Iterations = 0.0f;
+		while (CurrentMip >= 0 && CurrentMip <= Input.MaxMipLevel && Iterations < Input.MaxIterations)
+		{
+			Iterations++;
+
+			const float MipScale = std::exp2(float(-CurrentMip));
+			const FVector2 CellCount(std::floor(HZBSize.X * MipScale), std::floor(HZBSize.Y * MipScale));
+			const FVector2 CellSize(1.0f / CellCount.X, 1.0f / CellCount.Y);
+			const FVector2 CellIdx(std::floor(CurrentPos.X * CellCount.X), std::floor(CurrentPos.Y * CellCount.Y));
+			const FVector2 CellUV((CellIdx.X + 0.5f) * CellSize.X, (CellIdx.Y + 0.5f) * CellSize.Y);
+			// Reverse-Z：1.0为近处，0.0为无穷远
+			const float HZBDeviceZ = HZB.SampleLevel(CellUV, CurrentMip);
+			const float DepthEpsilon = 0.0001f;
+
+			if (CurrentPos.Z < HZBDeviceZ + DepthEpsilon)
+			{
+				if (CurrentMip == 0)
+				{
+					// 在线性深度下比较厚度，避免远近不一致
+					const float DistDiff = View.ConvertFromDeviceZ(CurrentPos.Z) - View.ConvertFromDeviceZ(HZBDeviceZ);
+					if (DistDiff > 0.0f && DistDiff < Input.Thickness)
+					{
+						Result.bHit = true;
+						Result.HitUVz = FVector3((CurrentPos.X - UVBias.X) / UVScale.X, (CurrentPos.Y - UVBias.Y) / UVScale.Y, HZBDeviceZ);
+						Result.Iterations = Iterations;
+						return Result;
+					}
+				}
+				else
+				{
+					CurrentMip--;
+					continue;
+				}
+			}
+
+			{
+				// 走到当前Cell的边界，然后尝试更粗的Mip
+				// 按InvRayDir的符号选边界：分量接近0时InvRayDir为正，取上边界，保证TBoundary为很大的正数
+				const FVector2 BoundaryUV(
+					(CellIdx.X + (InvRayDir.X > 0.0f ? 1.0f : 0.0f)) * CellSize.X,
+					(CellIdx.Y + (InvRayDir.Y > 0.0f ? 1.0f : 0.0f)) * CellSize.Y);
+				const float TBoundaryX = (BoundaryUV.X - CurrentPos.X) * InvRayDir.X;
+				const float TBoundaryY = (BoundaryUV.Y - CurrentPos.Y) * InvRayDir.Y;
+				float StepT = std::min(TBoundaryX, TBoundaryY);
+
+				// 远离相机的光线在单元内就会越过单元的最近深度时，只前进到该深度，下一次迭代下降Mip
+				bool bReachCellDepth = false;
+				if (RayDir.Z < -1e-6f)
+				{
+					const float TDepth = (HZBDeviceZ - CurrentPos.Z) * InvRayDir.Z;
+					if (TDepth >= 0.0f && TDepth < StepT)
+					{
+						StepT = TDepth;
+						bReachCellDepth = true;
+					}
+				}
+
+				CurrentPos += RayDir * (StepT + 0.0001f);
+				if (!bReachCellDepth)
+				{
+					CurrentMip = std::min(CurrentMip + 1, Input.MaxMipLevel);
+				}
+			}
+
+			if (CurrentPos.X < ValidUVMin.X || CurrentPos.Y < ValidUVMin.Y || CurrentPos.X > ValidUVMax.X || CurrentPos.Y > ValidUVMax.Y || CurrentPos.Z < 0.0001f)
+			{
+				break;
+			}
+		}
+
+		Result.Iterations = Iterations;
+		return Result;
+	}
+
+	void BuildRadianceCache(const FViewInfo& View, const TImage<FVector3>& SceneColor, const TImage<FVector4>* PrevGI, const TImage<FVector2>* Velocity, const FRadianceCacheSettings& Settings, FRadianceCache& OutCache)
+	{
+		const FIntPoint ViewSize = View.ViewRect.Size();
+		const FIntPoint CacheSize((ViewSize.X + 1) / 2, (ViewSize.Y + 1) / 2);
+		int32_t NumMips = 1;
+		while (NumMips < Settings.MaxMips && (std::min(CacheSize.X, CacheSize.Y) >> NumMips) > 0) NumMips++;
+		OutCache.ViewSize = ViewSize;
+		OutCache.Mips.resize(size_t(NumMips));
+
+		const float MultiBounceWeight = std::min(std::max(Settings.MultiBounceWeight, 0.0f), 1.0f);
+		const FVector2 HistoryUVMax((ViewSize.X - 0.5f) / ViewSize.X, (ViewSize.Y - 0.5f) / ViewSize.Y);
+		auto GetPixelRadiance = [&](int32_t X, int32_t Y)
+		{
+			X = std::min(X, ViewSize.X - 1);
+			Y = std::min(Y, ViewSize.Y - 1);
+			const int32_t BufferX = X + View.ViewRect.Min.X;
+			const int32_t BufferY = Y + View.ViewRect.Min.Y;
+			FVector3 Radiance = SceneColor(BufferX, BufferY);
+			if (PrevGI && MultiBounceWeight > 0.0f)
+			{
+				// 与Temporal相同的重投影
+				FVector2 PixelVelocity = Velocity ? Velocity->LoadClamped(BufferX, BufferY) : FVector2();
+				if (std::max(std::abs(PixelVelocity.X), std::abs(PixelVelocity.Y)) > 0.1f) PixelVelocity = FVector2();
+				const FVector2 PrevLocalUV((X + 0.5f) / ViewSize.X - PixelVelocity.X, (Y + 0.5f) / ViewSize.Y - PixelVelocity.Y);
+				if (PrevLocalUV.X >= 0.0f && PrevLocalUV.Y >= 0.0f && PrevLocalUV.X <= 1.0f && PrevLocalUV.Y <= 1.0f)
+				{
+					const TImage<FVector4>& History = *PrevGI;
+					const float HX = std::min(PrevLocalUV.X, HistoryUVMax.X) * History.Width - 0.5f;
+					const float HY = std::min(PrevLocalUV.Y, HistoryUVMax.Y) * History.Height - 0.5f;
+					const int32_t X0 = int32_t(std::floor(HX));
+					const int32_t Y0 = int32_t(std::floor(HY));
+					const float FracX = HX - X0;
+					const float FracY = HY - Y0;
+					const FVector3 Top = Lerp(History.LoadClamped(X0, Y0).XYZ(), History.LoadClamped(X0 + 1, Y0).XYZ(), FracX);
+					const FVector3 Bottom = Lerp(History.LoadClamped(X0, Y0 + 1).XYZ(), History.LoadClamped(X0 + 1, Y0 + 1).XYZ(), FracX);
+					Radiance += Lerp(Top, Bottom, FracY) * MultiBounceWeight;
+				}
+			}
+			return Radiance;
+		};
+
+		// Mip0：2x2像素的Karis平均
+		TImage<FVector3>& Mip0 = OutCache.Mips[0];
+		Mip0.Resize(CacheSize.X, CacheSize.Y);
+		ParallelForTiles(CacheSize, 32, [&](const FIntRect& Tile)
+		{
+			for (int32_t Y = Tile.Min.Y; Y < Tile.Max.Y; Y++)
+			{
+				for (int32_t X = Tile.Min.X; X < Tile.Max.X; X++)
+				{
+					FVector3 SumColor(0.0f);
+					float TotalWeight = 0.0f;
+					for (int32_t OffsetY = 0; OffsetY < 2; OffsetY++)
+					{
+						for (int32_t OffsetX = 0; OffsetX < 2; OffsetX++)
+						{
+							const FVector3 Radiance = GetPixelRadiance(X * 2 + OffsetX, Y * 2 + OffsetY);
+							const float Weight = 1.0f / (1.0f + Luminance(Radiance));
+							SumColor += Radiance * Weight;
+							TotalWeight += Weight;
+						}
+					}
+					Mip0(X, Y) = SumColor / TotalWeight;
+				}
+			}
+		});
+
+		// Mip N：上一级的2x2平均
+		for (int32_t MipLevel = 1; MipLevel < NumMips; MipLevel++)
+		{
+			const TImage<FVector3>& Parent = OutCache.Mips[size_t(MipLevel - 1)];
+			TImage<FVector3>& Mip = OutCache.Mips[size_t(MipLevel)];
+			Mip.Resize(std::max(CacheSize.X >> MipLevel, 1), std::max(CacheSize.Y >> MipLevel, 1));
+			for (int32_t Y = 0; Y < Mip.Height; Y++)
+			{
+				for (int32_t X = 0; X < Mip.Width; X++)
+				{
+					Mip(X, Y) = (Parent.LoadClamped(X * 2, Y * 2) + Parent.LoadClamped(X * 2 + 1, Y * 2)
+						+ Parent.LoadClamped(X * 2, Y * 2 + 1) + Parent.LoadClamped(X * 2 + 1, Y * 2 + 1)) * 0.25f;
+				}
+			}
+		}
+	}
+
+	FIntPoint GetTraceSize(const FViewInfo& View, int32_t ResolutionDivisor)
+	{
+		const int32_t Divisor = GetResolutionDivisor(ResolutionDivisor);
+		const FIntPoint ViewSize = View.ViewRect.Size();
+		return FIntPoint((ViewSize.X + Divisor - 1) / Divisor, (ViewSize.Y + Divisor - 1) / Divisor);
+	}
+
+	void TraceSSGI(const FViewInfo& View, const FHZB& HZB, const TImage<FGBufferSample>& GBuffer, const FTraceInputs& Inputs, const FTraceSettings& Settings, TImage<FVector3>& OutRaw, FTraceStats* OutStats)
+	{
+		const FIntPoint ViewSize = View.ViewRect.Size();
+		const int32_t ResolutionDivisor = GetResolutionDivisor(Settings.ResolutionDivisor);
+		const FIntPoint TraceSize = GetTraceSize(View, ResolutionDivisor);
+		const FIntPoint TraceOffset = GetTraceOffset(ResolutionDivisor, View.FrameIndex);
+		const uint32_t SequenceFrameIndex = View.FrameIndex / uint32_t(ResolutionDivisor * ResolutionDivisor);
+		// 与光线数的Permutation一致：1, 2, 4, 8
+		int32_t NumSamples = 1;
+		while (NumSamples < Settings.SamplesPerPixel && NumSamples < 8) NumSamples <<= 1;
+		const int32_t MaxIterations = (Settings.MaxIterations <= 0) ? 64 : Settings.MaxIterations;
+		const float Thickness = (Settings.Thickness < 0.1f) ? 10.0f : Settings.Thickness;
+		const FRadianceCache* RadianceCache = Inputs.RadianceCache;
+		const float FootprintScale = std::max(Settings.RadianceCacheFootprintScale, 0.0f) / std::sqrt(float(NumSamples));
+
+		const FVector2 BufferInvSize(1.0f / View.BufferSize.X, 1.0f / View.BufferSize.Y);
+		// View到Buffer的UV变换
+		const FVector2 UVScale(ViewSize.X * BufferInvSize.X, ViewSize.Y * BufferInvSize.Y);
+		const FVector2 UVOffset(View.ViewRect.Min.X * BufferInvSize.X, View.ViewRect.Min.Y * BufferInvSize.Y);
+
+		OutRaw.Resize(TraceSize.X, TraceSize.Y);
+		std::atomic<uint64_t> RaysTraced{ 0 };
+		std::atomic<uint64_t> RaysHit{ 0 };
+		std::atomic<uint64_t> TotalIterations{ 0 };
+
+		ParallelForTiles(TraceSize, 8, [&](const FIntRect& Tile)
+		{
+			uint64_t TileRaysTraced = 0;
+			uint64_t TileRaysHit = 0;
+			uint64_t TileIterations = 0;
+
+			for (int32_t TraceY = Tile.Min.Y; TraceY < Tile.Max.Y; TraceY++)
+			{
+				for (int32_t TraceX = Tile.Min.X; TraceX < Tile.Max.X; TraceX++)
+				{
+					// 追踪网格 -> View内的全分辨率像素
+					const FIntPoint PixelPos(
+						std::min(TraceX * ResolutionDivisor + TraceOffset.X, ViewSize.X - 1),
+						std::min(TraceY * ResolutionDivisor + TraceOffset.Y, ViewSize.Y - 1));
+					const FIntPoint BufferPos(PixelPos.X + View.ViewRect.Min.X, PixelPos.Y + View.ViewRect.Min.Y);
+
+					const FGBufferSample& Sample = GBuffer(PixelPos.X, PixelPos.Y);
+					if (!Sample.bValid)
+					{
+						OutRaw(TraceX, TraceY) = FVector3(0.0f);
+						continue;
+					}
+
+					FVector3 WorldNormal = Sample.WorldNormal;
+					if (Length(WorldNormal) < 0.1f) WorldNormal = FVector3(0.0f, 0.0f, 1.0f);
+					const float DeviceDepth = View.ConvertToDeviceZ(Sample.LinearDepth);
+
+					const FVector2 ViewUV((PixelPos.X + 0.5f) / ViewSize.X, (PixelPos.Y + 0.5f) / ViewSize.Y);
+					const FVector4 WorldPos4 = Mul(FVector4(ViewUV.X * 2.0f - 1.0f, 1.0f - ViewUV.Y * 2.0f, DeviceDepth, 1.0f), View.ClipToTranslatedWorld);
+					const FVector3 WorldPos = WorldPos4.XYZ() / WorldPos4.W;
+					const FVector3 BiasedWorldPos = WorldPos + WorldNormal * 2.0f;
+
+					FVector3 AccumulatedColor(0.0f);
+					float ValidSamples = 0.0f;
+					for (int32_t SampleIndex = 0; SampleIndex < NumSamples; SampleIndex++)
+					{
+						const FVector2 E = GetHemisphereSample(Settings.SamplingMode, PixelPos, View.FrameIndex, SequenceFrameIndex, uint32_t(NumSamples), uint32_t(SampleIndex));
+						// 余弦加权采样，局部空间 -> 世界空间
+						const FVector3 WorldRayDir = TangentToWorld(CosineSampleHemisphere(E.X, E.Y), WorldNormal);
+						const FVector3 WorldRayEnd = BiasedWorldPos + WorldRayDir * Settings.RayLength;
+
+						const FVector4 ClipStart = Mul(FVector4(BiasedWorldPos, 1.0f), View.TranslatedWorldToClip);
+						FVector4 ClipEnd = Mul(FVector4(WorldRayEnd, 1.0f), View.TranslatedWorldToClip);
+
+						const float NearPlane = 0.1f;
+						if (ClipEnd.W < NearPlane)
+						{
+							const float T = std::min(std::max((NearPlane - ClipStart.W) / (ClipEnd.W - ClipStart.W), 0.0f), 0.999f);
+							ClipEnd = FVector4(
+								Lerp(ClipStart.X, ClipEnd.X, T), Lerp(ClipStart.Y, ClipEnd.Y, T),
+								Lerp(ClipStart.Z, ClipEnd.Z, T), Lerp(ClipStart.W, ClipEnd.W, T));
+						}
+						if (ClipStart.W < 1e-4f) continue;
+
+						// 透视除法，使用Buffer尺寸生成光线，View做边界检测
+						FVector3 BufferStart = ClipStart.XYZ() / ClipStart.W;
+						FVector3 BufferEnd = ClipEnd.XYZ() / ClipEnd.W;
+						BufferStart.X = (BufferStart.X * 0.5f + 0.5f) * UVScale.X + UVOffset.X;
+						BufferStart.Y = (BufferStart.Y * -0.5f + 0.5f) * UVScale.Y + UVOffset.Y;
+						BufferEnd.X = (BufferEnd.X * 0.5f + 0.5f) * UVScale.X + UVOffset.X;
+						BufferEnd.Y = (BufferEnd.Y * -0.5f + 0.5f) * UVScale.Y + UVOffset.Y;
+						FVector3 ScreenRayDir = BufferEnd - BufferStart;
+
+						const FVector2 ValidUVMin = UVOffset;
+						const FVector2 ValidUVMax = UVOffset + UVScale;
+
+						float TMax = 1.0f;
+						if (ScreenRayDir.X > 1e-6f)       TMax = std::min(TMax, (ValidUVMax.X - BufferStart.X) / ScreenRayDir.X);
+						else if (ScreenRayDir.X < -1e-6f) TMax = std::min(TMax, (ValidUVMin.X - BufferStart.X) / ScreenRayDir.X);
+						if (ScreenRayDir.Y > 1e-6f)       TMax = std::min(TMax, (ValidUVMax.Y - BufferStart.Y) / ScreenRayDir.Y);
+						else if (ScreenRayDir.Y < -1e-6f) TMax = std::min(TMax, (ValidUVMin.Y - BufferStart.Y) / ScreenRayDir.Y);
+						ScreenRayDir *= TMax;
+
+						FHiZTraceInput TraceInput;
+						TraceInput.RayOrigin = BufferStart;
+						TraceInput.RayDirection = ScreenRayDir;
+						TraceInput.MaxMipLevel = HZB.NumMips() - 1;
+						TraceInput.MaxIterations = MaxIterations;
+						TraceInput.Thickness = Thickness;
+						TraceInput.ValidUVMin = ValidUVMin;
+						TraceInput.ValidUVMax = ValidUVMax;
+
+						const FHiZTraceResult TraceResult = HiZTrace(TraceInput, HZB, View);
+						TileRaysTraced++;
+						TileIterations += uint64_t(TraceResult.Iterations);
+
+						if (TraceResult.bHit)
+						{
+							const FVector2 HitBufferUV(TraceResult.HitUVz.X, TraceResult.HitUVz.Y);
+							if (HitBufferUV.X >= 0.0f && HitBufferUV.Y >= 0.0f && HitBufferUV.X <= 1.0f && HitBufferUV.Y <= 1.0f)
+							{
+								// 采样命中点的Radiance作为间接光，压制过亮的样本
+								FVector3 HitColor;
+								if (RadianceCache)
+								{
+									// 与SSGICommon.ush的SampleSSGIRadiance一致
+									const float HitPixelsX = (HitBufferUV.X - BufferStart.X) * View.BufferSize.X;
+									const float HitPixelsY = (HitBufferUV.Y - BufferStart.Y) * View.BufferSize.Y;
+									const float HitPixelDistance = std::sqrt(HitPixelsX * HitPixelsX + HitPixelsY * HitPixelsY);
+									const float Footprint = HitPixelDistance * FootprintScale;
+									const float Mip = std::min(std::max(std::log2(std::max(Footprint, 1.0f)) - 1.0f, 0.0f), float(RadianceCache->Mips.size() - 1));
+									const TImage<FVector3>& CacheMip0 = RadianceCache->Mips[0];
+									const FVector2 CacheUV(
+										(HitBufferUV.X * View.BufferSize.X - View.ViewRect.Min.X) / (CacheMip0.Width * 2),
+										(HitBufferUV.Y * View.BufferSize.Y - View.ViewRect.Min.Y) / (CacheMip0.Height * 2));
+									HitColor = SampleTrilinear(*RadianceCache, CacheUV, Mip);
+								}
+								else
+								{
+									HitColor = SampleBilinear(*Inputs.SceneColor, HitBufferUV);
+								}
+								const float MaxBrightness = 10.0f;
+								const float Luma = Dot(HitColor, FVector3(0.2126f, 0.7152f, 0.0722f));
+								if (Luma > MaxBrightness)
+								{
+									HitColor *= MaxBrightness / Luma;
+								}
+								AccumulatedColor += HitColor;
+								ValidSamples += 1.0f;
+								TileRaysHit++;
+							}
+						}
+					}
+
+					const FVector3 BaseColor = Inputs.BaseColor ? (*Inputs.BaseColor)(BufferPos.X, BufferPos.Y) : FVector3(1.0f);
+					const float AmbientOcclusion = Inputs.AmbientOcclusion ? (*Inputs.AmbientOcclusion)(BufferPos.X, BufferPos.Y) : 1.0f;
+					const FVector3 FinalGI = ((ValidSamples > 0.0f) ? AccumulatedColor / float(NumSamples) : FVector3(0.0f)) * BaseColor * AmbientOcclusion;
+					OutRaw(TraceX, TraceY) = FinalGI * Settings.Intensity;
+				}
+			}
+
+			RaysTraced += TileRaysTraced;
+			RaysHit += TileRaysHit;
+			TotalIterations += TileIterations;
+		});
+
+		if (OutStats)
+		{
+			OutStats->RaysTraced = RaysTraced;
+			OutStats->RaysHit = RaysHit;
+			OutStats->TotalIterations = TotalIterations;
+		}
+	}
+
+	void UpsampleSSGI(const FViewInfo& View, const TImage<FVector3>& LowRes, const TImage<FGBufferSample>& GBuffer, int32_t InResolutionDivisor, TImage<FVector3>& Output)
+	{
+		const FIntPoint ViewSize = View.ViewRect.Size();
+		const int32_t ResolutionDivisor = GetResolutionDivisor(InResolutionDivisor);
+		if (ResolutionDivisor == 1)
+		{
+			Output = LowRes;
+			return;
+		}
+		const FIntPoint TraceSize = GetTraceSize(View, ResolutionDivisor);
+		const FIntPoint TraceOffset = GetTraceOffset(ResolutionDivisor, View.FrameIndex);
+		// 与插件传入的参数一致
+		const float DepthSigma = 0.05f;
+		const float NormalPower = 8.0f;
+
+		Output.Resize(ViewSize.X, ViewSize.Y);
+		ParallelForTiles(ViewSize, 8, [&](const FIntRect& Tile)
+		{
+			for (int32_t Y = Tile.Min.Y; Y < Tile.Max.Y; Y++)
+			{
+				for (int32_t X = Tile.Min.X; X < Tile.Max.X; X++)
+				{
+					const FGBufferSample& Center = GBuffer(X, Y);
+					if (!Center.bValid)
+					{
+						Output(X, Y) = FVector3(0.0f);
+						continue;
+					}
+
+					// 当前像素落在哪4个追踪样本之间
+					const FVector2 TraceCoord(float(X - TraceOffset.X) / float(ResolutionDivisor), float(Y - TraceOffset.Y) / float(ResolutionDivisor));
+					const FIntPoint BaseCoord(int32_t(std::floor(TraceCoord.X)), int32_t(std::floor(TraceCoord.Y)));
+					const FVector2 Bilinear(TraceCoord.X - BaseCoord.X, TraceCoord.Y - BaseCoord.Y);
+
+					FVector3 SumColor(0.0f);
+					float TotalWeight = 0.0f;
+					FVector3 NearestColor(0.0f);
+					float NearestDist = 1e10f;
+					for (int32_t OffsetY = 0; OffsetY <= 1; OffsetY++)
+					{
+						for (int32_t OffsetX = 0; OffsetX <= 1; OffsetX++)
+						{
+							const FIntPoint SampleCoord(
+								std::min(std::max(BaseCoord.X + OffsetX, 0), TraceSize.X - 1),
+								std::min(std::max(BaseCoord.Y + OffsetY, 0), TraceSize.Y - 1));
+							const FGBufferSample& Sample = GBuffer(
+								std::min(SampleCoord.X * ResolutionDivisor + TraceOffset.X, ViewSize.X - 1),
+								std::min(SampleCoord.Y * ResolutionDivisor + TraceOffset.Y, ViewSize.Y - 1));
+							if (!Sample.bValid) continue;
+
+							const FVector3 SampleColor = LowRes(SampleCoord.X, SampleCoord.Y);
+							const float BilinearWeight = (OffsetX == 0 ? 1.0f - Bilinear.X : Bilinear.X) * (OffsetY == 0 ? 1.0f - Bilinear.Y : Bilinear.Y);
+							const float RelativeDepthDiff = std::abs(Sample.LinearDepth - Center.LinearDepth) / std::max(Center.LinearDepth, 1e-4f);
+							const float DepthWeight = std::exp(-RelativeDepthDiff / DepthSigma);
+							const float NormalWeight = std::pow(Saturate(Dot(Center.WorldNormal, Sample.WorldNormal)), NormalPower);
+
+							const float Weight = std::max(BilinearWeight, 1e-3f) * DepthWeight * NormalWeight;
+							SumColor += SampleColor * Weight;
+							TotalWeight += Weight;
+
+							// 所有权重都失效时退化为深度最接近的样本
+							if (RelativeDepthDiff < NearestDist)
+							{
+								NearestDist = RelativeDepthDiff;
+								NearestColor = SampleColor;
+							}
+						}
+					}
+					Output(X, Y) = (TotalWeight > 1e-4f) ? SumColor / TotalWeight : NearestColor;
+				}
+			}
+		});
+	}
+}
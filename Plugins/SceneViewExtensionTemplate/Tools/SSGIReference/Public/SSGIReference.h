@@ -0,0 +1,263 @@
+// SSGIReference.h
+// HZB SSGI各个Pass的CPU参考实现，不依赖引擎，用于：
+// 1. 作为Golden Model，和Shader的输出（RenderDoc导出的纹理）逐像素对比
+// 2. 在没有GPU的环境（CI/Linux）下分析追踪算法的开销
+// 与Shader的对应关系：
+// BuildHZB           -> HZB.usf
+// DecodeGBuffer      -> SSGIGBufferDecode.usf
+// HiZTrace           -> RayTracingCommon.ush
+// BuildRadianceCache -> SSGIRadianceCache.usf
+// TraceSSGI          -> SSGI.usf（固定光线数，不含自适应光线预算、调试输出和Miss时的探针回退）
+// UpsampleSSGI       -> SSGIUpsample.usf
+// DenoiseATrous      -> SSGIDenoiser.usf
+// TemporalAccumulate -> SSGITemporal.usf
+// 所有Pass按Tile分配到所有核心，中间纹理统一用fp32存储（Shader中显式的half打包除外）。
+// HZB归约、DenoiseATrous和TemporalAccumulate沿X方向4个像素一组用SIMD计算（SSGIReferenceSimd.h），每个Lane与标量运算逐位相同。
+#pragma once
+
+#include "SSGIReferenceMath.h"
+
+#include <functional>
+#include <vector>
+
+namespace SSGIReference
+{
+	// 与插件的kHZBMaxMipCount一致
+	constexpr int32_t kHZBMaxMipCount = 14;
+
+	template<typename T>
+	struct TImage
+	{
+		int32_t Width = 0;
+		int32_t Height = 0;
+		std::vector<T> Data;
+
+		TImage() = default;
+		TImage(int32_t InWidth, int32_t InHeight, const T& Value = T()) { Resize(InWidth, InHeight, Value); }
+
+		void Resize(int32_t InWidth, int32_t InHeight, const T& Value = T())
+		{
+			Width = InWidth;
+			Height = InHeight;
+			Data.assign(size_t(InWidth) * size_t(InHeight), Value);
+		}
+
+		FIntPoint Size() const { return FIntPoint(Width, Height); }
+		T& operator()(int32_t X, int32_t Y) { return Data[size_t(Y) * Width + X]; }
+		const T& operator()(int32_t X, int32_t Y) const { return Data[size_t(Y) * Width + X]; }
+
+		// 越界时clamp到边界，对应Point Clamp采样
+		const T& LoadClamped(int32_t X, int32_t Y) const
+		{
+			return (*this)(std::min(std::max(X, 0), Width - 1), std::min(std::max(Y, 0), Height - 1));
+		}
+	};
+
+	/**
+	 * View
+	 */
+	// 反向Z、远平面无限远的透视投影（UE默认），DeviceZ = NearPlane / LinearDepth
+	struct FViewInfo
+	{
+		FIntPoint BufferSize;
+		FIntRect ViewRect;
+		FMatrix44 TranslatedWorldToClip;
+		// 插件中的SVPositionToTranslatedWorld（InvTranslatedViewProjectionMatrix）
+		FMatrix44 ClipToTranslatedWorld;
+		float NearPlane = 10.0f;
+		// 对应View.Family->FrameNumber % 1024
+		uint32_t FrameIndex = 0;
+
+		float ConvertFromDeviceZ(float DeviceZ) const { return NearPlane / DeviceZ; }
+		float ConvertToDeviceZ(float LinearDepth) const { return NearPlane / LinearDepth; }
+	};
+
+	// 相机位于原点，X右、Y上、Z前（UE的View空间），FovX为水平视角（度）
+	FViewInfo MakePerspectiveView(FIntPoint BufferSize, const FIntRect& ViewRect, float FovXDegrees, float NearPlane, const FMatrix44& WorldToView = FMatrix44::Identity());
+
+	/**
+	 * HZB
+	 */
+	struct FHZBSettings
+	{
+		// r.HZBSSGI.HZB.Compact：只覆盖ViewRect，尺寸为2的幂
+		bool bCompact = false;
+		// r.HZBSSGI.HZB.HalfPrecision：R16F存储，保守地向上取整（只在Compact模式下生效）
+		bool bHalfPrecision = false;
+	};
+
+	struct FHZB
+	{
+		FIntPoint Mip0Size;
+		std::vector<TImage<float>> Mips;
+		// Buffer UV到HZB UV的映射：xy为Scale，zw为Bias
+		FVector4 BufferUVToHZBUV = FVector4(1.0f, 1.0f, 0.0f, 0.0f);
+
+		int32_t NumMips() const { return int32_t(Mips.size()); }
+		// HZBSize参数：(x, y, 1/x, 1/y)
+		FVector4 GetSizeAndInvSize() const { return FVector4(float(Mip0Size.X), float(Mip0Size.Y), 1.0f / Mip0Size.X, 1.0f / Mip0Size.Y); }
+		// SampleLevel(GlobalPointClampedSampler, UV, Mip)
+		float SampleLevel(const FVector2& UV, int32_t MipLevel) const;
+	};
+
+	// SceneDepth为Buffer尺寸的DeviceZ
+	FHZB BuildHZB(const TImage<float>& SceneDepth, const FIntRect& ViewRect, const FHZBSettings& Settings);
+
+	/**
+	 * GBuffer
+	 */
+	// 与SSGIGBufferCommon.ush的FSSGIGBufferSample一致，法线经过16:16的八面体量化
+	struct FGBufferSample
+	{
+		FVector3 WorldNormal = FVector3(0.0f, 0.0f, 1.0f);
+		float LinearDepth = 0.0f;
+		bool bValid = false;
+	};
+
+	// 输入为Buffer尺寸的DeviceZ和世界空间法线，输出为View尺寸
+	TImage<FGBufferSample> DecodeGBuffer(const TImage<float>& SceneDepth, const TImage<FVector3>& WorldNormal, const FViewInfo& View);
+
+	/**
+	 * HiZ Trace
+	 */
+	struct FHiZTraceInput
+	{
+		FVector3 RayOrigin;
+		FVector3 RayDirection;
+		int32_t MaxMipLevel = 0;
+		int32_t MaxIterations = 64;
+		float Thickness = 10.0f;
+		FVector2 ValidUVMin;
+		FVector2 ValidUVMax;
+	};
+
+	struct FHiZTraceResult
+	{
+		bool bHit = false;
+		FVector3 HitUVz;
+		float Iterations = 0.0f;
+	};
+
+	FHiZTraceResult HiZTrace(const FHiZTraceInput& Input, const FHZB& HZB, const FViewInfo& View);
+
+	/**
+	 * Radiance Cache
+	 */
+	// 命中着色用的预过滤Radiance，Mip0为View尺寸的一半
+	struct FRadianceCache
+	{
+		std::vector<TImage<FVector3>> Mips;
+		FIntPoint ViewSize;
+	};
+
+	// 与r.HZBSSGI.RadianceCache.*一致
+	struct FRadianceCacheSettings
+	{
+		int32_t MaxMips = 6;
+		float MultiBounceWeight = 1.0f;
+	};
+
+	// SceneColor、Velocity为Buffer尺寸；PrevGI为上一帧Temporal的输出（View尺寸），为空时只有单次反弹
+	void BuildRadianceCache(const FViewInfo& View, const TImage<FVector3>& SceneColor, const TImage<FVector4>* PrevGI, const TImage<FVector2>* Velocity, const FRadianceCacheSettings& Settings, FRadianceCache& OutCache);
+
+	/**
+	 * SSGI Trace
+	 */
+	struct FTraceSettings
+	{
+		int32_t SamplesPerPixel = 1;
+		int32_t MaxIterations = 64;
+		float Thickness = 10.0f;
+		float RayLength = 100.0f;
+		float Intensity = 1.0f;
+		// 1, 2, 4
+		int32_t ResolutionDivisor = 1;
+		// 与r.HZBSSGI.SamplingMode一致：0 哈希LCG，1 R2序列 + 逐像素蓝噪声偏移
+		int32_t SamplingMode = 1;
+		// r.HZBSSGI.RadianceCache.FootprintScale，只在FTraceInputs::RadianceCache不为空时使用
+		float RadianceCacheFootprintScale = 0.25f;
+	};
+
+	// 均为Buffer尺寸；BaseColor和AmbientOcclusion为空时按1处理
+	struct FTraceInputs
+	{
+		const TImage<FVector3>* SceneColor = nullptr;
+		const TImage<FVector3>* BaseColor = nullptr;
+		const TImage<float>* AmbientOcclusion = nullptr;
+		// 为空时命中点直接读SceneColor
+		const FRadianceCache* RadianceCache = nullptr;
+	};
+
+	// 与r.HZBSSGI.Stats的GPU计数一致
+	struct FTraceStats
+	{
+		uint64_t RaysTraced = 0;
+		uint64_t RaysHit = 0;
+		uint64_t TotalIterations = 0;
+	};
+
+	FIntPoint GetTraceSize(const FViewInfo& View, int32_t ResolutionDivisor);
+	// 输出为追踪分辨率（GetTraceSize）
+	void TraceSSGI(const FViewInfo& View, const FHZB& HZB, const TImage<FGBufferSample>& GBuffer, const FTraceInputs& Inputs, const FTraceSettings& Settings, TImage<FVector3>& OutRaw, FTraceStats* OutStats = nullptr);
+
+	/**
+	 * Upsample
+	 */
+	// 降分辨率追踪结果的联合双边上采样，输出为View尺寸；ResolutionDivisor为1时直接拷贝
+	void UpsampleSSGI(const FViewInfo& View, const TImage<FVector3>& LowRes, const TImage<FGBufferSample>& GBuffer, int32_t ResolutionDivisor, TImage<FVector3>& Output);
+
+	/**
+	 * Denoise
+	 */
+	// A-Trous的一次迭代，StepSize为1,2,4,8
+	void DenoiseATrous(const TImage<FVector3>& Input, const TImage<FGBufferSample>& GBuffer, int32_t StepSize, float Intensity, TImage<FVector3>& Output);
+	// r.HZBSSGI.Denoiser.Iterations次迭代，步长依次翻倍
+	void DenoiseSpatial(const TImage<FVector3>& Input, const TImage<FGBufferSample>& GBuffer, int32_t NumIterations, float Intensity, TImage<FVector3>& Output);
+
+	/**
+	 * Temporal
+	 */
+	struct FTemporalSettings
+	{
+		// 1 = 3x3, 2 = 5x5
+		int32_t KernelRadius = 2;
+		float MaxAccumulation = 32.0f;
+	};
+
+	// 与View同尺寸；Color.W为累积帧数
+	struct FTemporalHistory
+	{
+		TImage<FVector4> Color;
+		TImage<float> Moments;
+		bool bValid = false;
+	};
+
+	// Velocity为Buffer尺寸，为空时按静止处理
+	void TemporalAccumulate(const FViewInfo& View, const TImage<FVector3>& Current, const TImage<FGBufferSample>& GBuffer, const TImage<FVector2>* Velocity, const FTemporalHistory& History, const FTemporalSettings& Settings, FTemporalHistory& OutHistory);
+
+	/**
+	 * Parallel
+	 */
+	// 0为使用所有硬件线程
+	void SetNumWorkerThreads(int32_t NumThreads);
+	int32_t GetNumWorkerThreads();
+	// 把[0, Size)按TileSize x TileSize分块，由常驻的工作线程和调用线程动态领取
+	void ParallelForTiles(FIntPoint Size, int32_t TileSize, const std::function<void(const FIntRect& Tile)>& Body);
+
+	/**
+	 * Synthetic Scene
+	 */
+	// 程序化生成的测试场景：地面、三面彩色墙、两个球，上方为天空（无效像素）
+	struct FSyntheticScene
+	{
+		FViewInfo View;
+		TImage<float> SceneDepth;
+		TImage<FVector3> WorldNormal;
+		TImage<FVector3> SceneColor;
+		TImage<FVector3> BaseColor;
+		TImage<float> AmbientOcclusion;
+		TImage<FVector2> Velocity;
+	};
+
+	FSyntheticScene MakeSyntheticScene(FIntPoint Size, uint32_t FrameIndex);
+}
@@ -0,0 +1,138 @@
+// SSGIReferenceMath.h
+// CPU参考实现用到的最小向量/矩阵运算，语义与HLSL一致（矩阵为行向量约定，mul(v, M)）
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace SSGIReference
+{
+	struct FVector2
+	{
+		float X = 0.0f;
+		float Y = 0.0f;
+
+		FVector2() = default;
+		FVector2(float InX, float InY) : X(InX), Y(InY) {}
+
+		FVector2 operator+(const FVector2& B) const { return FVector2(X + B.X, Y + B.Y); }
+		FVector2 operator-(const FVector2& B) const { return FVector2(X - B.X, Y - B.Y); }
+		FVector2 operator*(const FVector2& B) const { return FVector2(X * B.X, Y * B.Y); }
+		FVector2 operator*(float S) const { return FVector2(X * S, Y * S); }
+	};
+
+	struct FVector3
+	{
+		float X = 0.0f;
+		float Y = 0.0f;
+		float Z = 0.0f;
+
+		FVector3() = default;
+		explicit FVector3(float S) : X(S), Y(S), Z(S) {}
+		FVector3(float InX, float InY, float InZ) : X(InX), Y(InY), Z(InZ) {}
+
+		FVector3 operator+(const FVector3& B) const { return FVector3(X + B.X, Y + B.Y, Z + B.Z); }
+		FVector3 operator-(const FVector3& B) const { return FVector3(X - B.X, Y - B.Y, Z - B.Z); }
+		FVector3 operator*(const FVector3& B) const { return FVector3(X * B.X, Y * B.Y, Z * B.Z); }
+		FVector3 operator/(const FVector3& B) const { return FVector3(X / B.X, Y / B.Y, Z / B.Z); }
+		FVector3 operator*(float S) const { return FVector3(X * S, Y * S, Z * S); }
+		FVector3 operator/(float S) const { return FVector3(X / S, Y / S, Z / S); }
+		FVector3& operator+=(const FVector3& B) { X += B.X; Y += B.Y; Z += B.Z; return *this; }
+		FVector3& operator*=(float S) { X *= S; Y *= S; Z *= S; return *this; }
+	};
+
+	struct FVector4
+	{
+		float X = 0.0f;
+		float Y = 0.0f;
+		float Z = 0.0f;
+		float W = 0.0f;
+
+		FVector4() = default;
+		FVector4(float InX, float InY, float InZ, float InW) : X(InX), Y(InY), Z(InZ), W(InW) {}
+		FVector4(const FVector3& V, float InW) : X(V.X), Y(V.Y), Z(V.Z), W(InW) {}
+
+		FVector3 XYZ() const { return FVector3(X, Y, Z); }
+	};
+
+	struct FIntPoint
+	{
+		int32_t X = 0;
+		int32_t Y = 0;
+
+		FIntPoint() = default;
+		FIntPoint(int32_t InX, int32_t InY) : X(InX), Y(InY) {}
+	};
+
+	struct FIntRect
+	{
+		FIntPoint Min;
+		FIntPoint Max;
+
+		FIntRect() = default;
+		FIntRect(int32_t MinX, int32_t MinY, int32_t MaxX, int32_t MaxY) : Min(MinX, MinY), Max(MaxX, MaxY) {}
+
+		FIntPoint Size() const { return FIntPoint(Max.X - Min.X, Max.Y - Min.Y); }
+	};
+
+	// 行向量约定：Row[i][j]，mul(v, M) = sum_i v[i] * M[i][j]，与UE的FMatrix和HLSL的mul(v, M)一致
+	struct FMatrix44
+	{
+		float M[4][4] = {};
+
+		static FMatrix44 Identity()
+		{
+			FMatrix44 Result;
+			for (int32_t i = 0; i < 4; i++) Result.M[i][i] = 1.0f;
+			return Result;
+		}
+
+		FMatrix44 operator*(const FMatrix44& B) const
+		{
+			FMatrix44 Result;
+			for (int32_t i = 0; i < 4; i++)
+			{
+				for (int32_t j = 0; j < 4; j++)
+				{
+					Result.M[i][j] = M[i][0] * B.M[0][j] + M[i][1] * B.M[1][j] + M[i][2] * B.M[2][j] + M[i][3] * B.M[3][j];
+				}
+			}
+			return Result;
+		}
+
+		FMatrix44 Inverse() const;
+	};
+
+	inline FVector4 Mul(const FVector4& V, const FMatrix44& Mat)
+	{
+		FVector4 R;
+		R.X = V.X * Mat.M[0][0] + V.Y * Mat.M[1][0] + V.Z * Mat.M[2][0] + V.W * Mat.M[3][0];
+		R.Y = V.X * Mat.M[0][1] + V.Y * Mat.M[1][1] + V.Z * Mat.M[2][1] + V.W * Mat.M[3][1];
+		R.Z = V.X * Mat.M[0][2] + V.Y * Mat.M[1][2] + V.Z * Mat.M[2][2] + V.W * Mat.M[3][2];
+		R.W = V.X * Mat.M[0][3] + V.Y * Mat.M[1][3] + V.Z * Mat.M[2][3] + V.W * Mat.M[3][3];
+		return R;
+	}
+
+	inline float Dot(const FVector3& A, const FVector3& B) { return A.X * B.X + A.Y * B.Y + A.Z * B.Z; }
+	inline float Length(const FVector3& V) { return std::sqrt(Dot(V, V)); }
+	inline FVector3 Normalize(const FVector3& V) { return V * (1.0f / std::sqrt(Dot(V, V))); }
+	inline FVector3 Lerp(const FVector3& A, const FVector3& B, float T) { return A + (B - A) * T; }
+	inline FVector3 Min(const FVector3& A, const FVector3& B) { return FVector3(std::min(A.X, B.X), std::min(A.Y, B.Y), std::min(A.Z, B.Z)); }
+	inline FVector3 Max(const FVector3& A, const FVector3& B) { return FVector3(std::max(A.X, B.X), std::max(A.Y, B.Y), std::max(A.Z, B.Z)); }
+	inline FVector3 Clamp(const FVector3& V, const FVector3& A, const FVector3& B) { return Min(Max(V, A), B); }
+	inline float Saturate(float V) { return std::min(std::max(V, 0.0f), 1.0f); }
+	inline float Lerp(float A, float B, float T) { return A + (B - A) * T; }
+
+	// UE的Luminance
+	inline float Luminance(const FVector3& Color) { return Dot(Color, FVector3(0.3f, 0.59f, 0.11f)); }
+
+	// HLSL的asuint/asfloat
+	inline uint32_t AsUint(float F) { uint32_t U; std::memcpy(&U, &F, sizeof(U)); return U; }
+	inline float AsFloat(uint32_t U) { float F; std::memcpy(&F, &U, sizeof(F)); return F; }
+
+	// HLSL的f32tof16/f16tof32（就近舍入，非规格化数保留）
+	uint32_t F32ToF16(float Value);
+	float F16ToF32(uint32_t Half);
+}
@@ -0,0 +1,494 @@
+// SSGIReferenceTests.cpp
+// CPU参考实现的回归测试（ctest），每个用例构造解析可知结果的输入：
+// HZB的max归约（奇数/非2的幂尺寸、Compact和R16F的保守取整）、HiZ追踪在平面/台阶深度上的命中与Miss、
+// A-Trous对常量场和深度/法线边缘的处理、Temporal累积收敛到均值以及累积计数的上限、ParallelForTiles的Tile覆盖
+#include "SSGIReference.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <set>
+#include <thread>
+
+using namespace SSGIReference;
+
+namespace
+{
+	int32_t GNumFailures = 0;
+
+#define SSGI_TEST_CHECK(Condition, ...) \
+	do \
+	{ \
+		if (!(Condition)) \
+		{ \
+			GNumFailures++; \
+			std::printf("  FAILED %s:%d: %s\n    ", __FILE__, __LINE__, #Condition); \
+			std::printf(__VA_ARGS__); \
+			std::printf("\n"); \
+		} \
+	} \
+	while (0)
+
+	// 确定性的伪随机数，测试结果不依赖平台的rand()
+	uint32_t HashU32(uint32_t X)
+	{
+		X = ((X >> 16) ^ X) * 0x45d9f3bu;
+		X = ((X >> 16) ^ X) * 0x45d9f3bu;
+		return (X >> 16) ^ X;
+	}
+
+	float HashFloat(uint32_t X)
+	{
+		return float(HashU32(X) & 0xffffffu) / float(0x1000000u);
+	}
+
+	// DeviceZ在(0.001, 1]之间随机，带一些天空像素
+	TImage<float> MakeRandomDepth(FIntPoint Size, uint32_t Seed)
+	{
+		TImage<float> Depth(Size.X, Size.Y);
+		for (int32_t Y = 0; Y < Size.Y; Y++)
+		{
+			for (int32_t X = 0; X < Size.X; X++)
+			{
+				const float Random = HashFloat(Seed * 7919u + uint32_t(Y * Size.X + X));
+				Depth(X, Y) = Random < 0.05f ? 0.0f : 0.001f + Random;
+			}
+		}
+		return Depth;
+	}
+
+	FViewInfo MakeTestView(FIntPoint Size)
+	{
+		return MakePerspectiveView(Size, FIntRect(0, 0, Size.X, Size.Y), 90.0f, 10.0f);
+	}
+
+	TImage<FGBufferSample> MakeConstantGBuffer(FIntPoint Size, const FVector3& Normal, float LinearDepth)
+	{
+		FGBufferSample Sample;
+		Sample.WorldNormal = Normal;
+		Sample.LinearDepth = LinearDepth;
+		Sample.bValid = true;
+		return TImage<FGBufferSample>(Size.X, Size.Y, Sample);
+	}
+
+	bool NearlyEqual(const FVector3& A, const FVector3& B, float Tolerance)
+	{
+		return std::abs(A.X - B.X) <= Tolerance && std::abs(A.Y - B.Y) <= Tolerance && std::abs(A.Z - B.Z) <= Tolerance;
+	}
+
+	/**
+	 * HZB
+	 */
+	// 默认模式：Mip0等于SceneDepth，Mip N的(x,y) = Mip N-1中2x2的最大值，越界坐标clamp到上一级的边界
+	void TestHZBReduction()
+	{
+		const FIntPoint Sizes[] = { FIntPoint(1, 1), FIntPoint(37, 23), FIntPoint(100, 1), FIntPoint(3, 65), FIntPoint(129, 77) };
+		for (const FIntPoint& Size : Sizes)
+		{
+			const TImage<float> SceneDepth = MakeRandomDepth(Size, uint32_t(Size.X * 131 + Size.Y));
+			const FHZB HZB = BuildHZB(SceneDepth, FIntRect(0, 0, Size.X, Size.Y), FHZBSettings());
+
+			int32_t ExpectedMips = 1;
+			while ((std::max(Size.X, Size.Y) >> ExpectedMips) > 0) ExpectedMips++;
+			ExpectedMips = std::min(ExpectedMips, kHZBMaxMipCount);
+			SSGI_TEST_CHECK(HZB.NumMips() == ExpectedMips, "%dx%d: %d mips, expected %d", Size.X, Size.Y, HZB.NumMips(), ExpectedMips);
+			SSGI_TEST_CHECK(HZB.Mips[0].Data == SceneDepth.Data, "%dx%d: mip 0 differs from the scene depth", Size.X, Size.Y);
+
+			for (int32_t MipLevel = 1; MipLevel < HZB.NumMips(); MipLevel++)
+			{
+				const TImage<float>& Prev = HZB.Mips[MipLevel - 1];
+				const TImage<float>& Mip = HZB.Mips[MipLevel];
+				SSGI_TEST_CHECK(Mip.Width == std::max(Size.X >> MipLevel, 1) && Mip.Height == std::max(Size.Y >> MipLevel, 1),
+					"%dx%d mip %d: size %dx%d", Size.X, Size.Y, MipLevel, Mip.Width, Mip.Height);
+
+				int32_t NumMismatches = 0;
+				for (int32_t Y = 0; Y < Mip.Height; Y++)
+				{
+					for (int32_t X = 0; X < Mip.Width; X++)
+					{
+						const int32_t X0 = std::min(X * 2, Prev.Width - 1);
+						const int32_t X1 = std::min(X * 2 + 1, Prev.Width - 1);
+						const int32_t Y0 = std::min(Y * 2, Prev.Height - 1);
+						const int32_t Y1 = std::min(Y * 2 + 1, Prev.Height - 1);
+						const float Expected = std::max(std::max(Prev(X0, Y0), Prev(X1, Y0)), std::max(Prev(X0, Y1), Prev(X1, Y1)));
+						NumMismatches += Mip(X, Y) != Expected ? 1 : 0;
+					}
+				}
+				SSGI_TEST_CHECK(NumMismatches == 0, "%dx%d mip %d: %d texels differ from the 2x2 max", Size.X, Size.Y, MipLevel, NumMismatches);
+			}
+		}
+	}
+
+	// Compact模式：Mip0为2的幂，每一级都覆盖View中的所有像素，任何Mip的Texel都不比其覆盖的深度更浅；
+	// R16F存储时每个值都可以用half精确表示，并且向上取整
+	void TestHZBCompactConservative()
+	{
+		struct FCase
+		{
+			FIntPoint BufferSize;
+			FIntRect ViewRect;
+			bool bHalfPrecision;
+		};
+		const FCase Cases[] =
+		{
+			{ FIntPoint(37, 23), FIntRect(0, 0, 37, 23), false },
+			{ FIntPoint(37, 23), FIntRect(0, 0, 37, 23), true },
+			{ FIntPoint(200, 120), FIntRect(13, 7, 190, 101), false },
+			{ FIntPoint(200, 120), FIntRect(13, 7, 190, 101), true },
+			{ FIntPoint(64, 64), FIntRect(0, 0, 64, 64), true },
+		};
+		for (const FCase& Case : Cases)
+		{
+			const TImage<float> SceneDepth = MakeRandomDepth(Case.BufferSize, uint32_t(Case.ViewRect.Max.X));
+			FHZBSettings Settings;
+			Settings.bCompact = true;
+			Settings.bHalfPrecision = Case.bHalfPrecision;
+			const FHZB HZB = BuildHZB(SceneDepth, Case.ViewRect, Settings);
+
+			const bool bPowerOfTwo = (HZB.Mip0Size.X & (HZB.Mip0Size.X - 1)) == 0 && (HZB.Mip0Size.Y & (HZB.Mip0Size.Y - 1)) == 0;
+			SSGI_TEST_CHECK(bPowerOfTwo, "compact mip 0 is %dx%d", HZB.Mip0Size.X, HZB.Mip0Size.Y);
+
+			int32_t NumShallower = 0;
+			int32_t NumNotHalf = 0;
+			for (int32_t MipLevel = 0; MipLevel < HZB.NumMips(); MipLevel++)
+			{
+				for (int32_t Y = Case.ViewRect.Min.Y; Y < Case.ViewRect.Max.Y; Y++)
+				{
+					for (int32_t X = Case.ViewRect.Min.X; X < Case.ViewRect.Max.X; X++)
+					{
+						// 像素中心的Buffer UV映射到HZB UV
+						const FVector2 BufferUV((X + 0.5f) / Case.BufferSize.X, (Y + 0.5f) / Case.BufferSize.Y);
+						const FVector2 HZBUV(BufferUV.X * HZB.BufferUVToHZBUV.X + HZB.BufferUVToHZBUV.Z, BufferUV.Y * HZB.BufferUVToHZBUV.Y + HZB.BufferUVToHZBUV.W);
+						NumShallower += HZB.SampleLevel(HZBUV, MipLevel) < SceneDepth(X, Y) ? 1 : 0;
+					}
+				}
+				if (Case.bHalfPrecision)
+				{
+					for (float Value : HZB.Mips[MipLevel].Data)
+					{
+						NumNotHalf += F16ToF32(F32ToF16(Value)) != Value ? 1 : 0;
+					}
+				}
+			}
+			SSGI_TEST_CHECK(NumShallower == 0, "view %dx%d%s: %d samples shallower than the scene depth",
+				Case.ViewRect.Size().X, Case.ViewRect.Size().Y, Case.bHalfPrecision ? " R16F" : "", NumShallower);
+			SSGI_TEST_CHECK(NumNotHalf == 0, "view %dx%d: %d values are not representable as half", Case.ViewRect.Size().X, Case.ViewRect.Size().Y, NumNotHalf);
+		}
+
+		// 非Compact时忽略HalfPrecision，保持fp32
+		{
+			const FIntPoint Size(33, 17);
+			const TImage<float> SceneDepth = MakeRandomDepth(Size, 5u);
+			FHZBSettings Settings;
+			Settings.bHalfPrecision = true;
+			const FHZB HZB = BuildHZB(SceneDepth, FIntRect(0, 0, Size.X, Size.Y), Settings);
+			SSGI_TEST_CHECK(HZB.Mips[0].Data == SceneDepth.Data, "half precision must only apply to the compact HZB");
+		}
+	}
+
+	/**
+	 * HiZ Trace
+	 */
+	FHiZTraceInput MakeTraceInput(const FHZB& HZB, const FVector3& Start, const FVector3& End, float Thickness)
+	{
+		FHiZTraceInput Input;
+		Input.RayOrigin = Start;
+		Input.RayDirection = End - Start;
+		Input.MaxMipLevel = HZB.NumMips() - 1;
+		Input.MaxIterations = 128;
+		Input.Thickness = Thickness;
+		Input.ValidUVMin = FVector2(0.0f, 0.0f);
+		Input.ValidUVMax = FVector2(1.0f, 1.0f);
+		return Input;
+	}
+
+	void TestHiZTrace()
+	{
+		const FIntPoint Size(256, 128);
+		const FViewInfo View = MakeTestView(Size);
+
+		// 正对相机的平面，线性深度500
+		{
+			const float PlaneDeviceZ = View.ConvertToDeviceZ(500.0f);
+			const TImage<float> SceneDepth(Size.X, Size.Y, PlaneDeviceZ);
+			const FHZB HZB = BuildHZB(SceneDepth, FIntRect(0, 0, Size.X, Size.Y), FHZBSettings());
+
+			// 深度100 -> 1000，穿过平面：DeviceZ在t = (0.1 - 0.02) / 0.09处等于平面
+			const FVector3 Start(0.5f, 0.5f, View.ConvertToDeviceZ(100.0f));
+			const FVector3 End(0.7f, 0.5f, View.ConvertToDeviceZ(1000.0f));
+			const FHiZTraceResult Hit = HiZTrace(MakeTraceInput(HZB, Start, End, 100.0f), HZB, View);
+			const float ExpectedT = (Start.Z - PlaneDeviceZ) / (Start.Z - End.Z);
+			const float ExpectedU = Start.X + (End.X - Start.X) * ExpectedT;
+			SSGI_TEST_CHECK(Hit.bHit, "ray through the plane must hit");
+			SSGI_TEST_CHECK(std::abs(Hit.HitUVz.X - ExpectedU) < 2.0f / Size.X, "hit u %f, expected %f", Hit.HitUVz.X, ExpectedU);
+			SSGI_TEST_CHECK(std::abs(Hit.HitUVz.Y - 0.5f) < 1.0f / Size.Y, "hit v %f, expected 0.5", Hit.HitUVz.Y);
+			SSGI_TEST_CHECK(Hit.HitUVz.Z == PlaneDeviceZ, "hit depth %f, expected the plane %f", Hit.HitUVz.Z, PlaneDeviceZ);
+
+			// 深度100 -> 200，在平面前离开屏幕
+			const FVector3 MissEnd(1.0f, 0.5f, View.ConvertToDeviceZ(200.0f));
+			const FHiZTraceResult Miss = HiZTrace(MakeTraceInput(HZB, Start, MissEnd, 100.0f), HZB, View);
+			SSGI_TEST_CHECK(!Miss.bHit, "ray in front of the plane must miss (hit at %f, %f)", Miss.HitUVz.X, Miss.HitUVz.Y);
+		}
+
+		// 台阶：u < 0.6为深度1000的背景，u >= 0.6为深度150的墙
+		{
+			const int32_t StepX = int32_t(Size.X * 0.6f);
+			TImage<float> SceneDepth(Size.X, Size.Y);
+			for (int32_t Y = 0; Y < Size.Y; Y++)
+			{
+				for (int32_t X = 0; X < Size.X; X++)
+				{
+					SceneDepth(X, Y) = View.ConvertToDeviceZ(X < StepX ? 1000.0f : 150.0f);
+				}
+			}
+			const FHZB HZB = BuildHZB(SceneDepth, FIntRect(0, 0, Size.X, Size.Y), FHZBSettings());
+			const float StepU = float(StepX) / Size.X;
+
+			// 深度120 -> 180：越过台阶后在深度150处进入墙面
+			const FVector3 Start(0.3f, 0.4f, View.ConvertToDeviceZ(120.0f));
+			const FVector3 End(0.9f, 0.4f, View.ConvertToDeviceZ(180.0f));
+			const FHiZTraceResult Hit = HiZTrace(MakeTraceInput(HZB, Start, End, 10.0f), HZB, View);
+			const float WallDeviceZ = View.ConvertToDeviceZ(150.0f);
+			const float ExpectedU = Start.X + (End.X - Start.X) * (Start.Z - WallDeviceZ) / (Start.Z - End.Z);
+			SSGI_TEST_CHECK(Hit.bHit, "ray entering the wall must hit");
+			SSGI_TEST_CHECK(Hit.HitUVz.X >= StepU && std::abs(Hit.HitUVz.X - ExpectedU) < 2.0f / Size.X, "hit u %f, expected %f", Hit.HitUVz.X, ExpectedU);
+			SSGI_TEST_CHECK(Hit.HitUVz.Z == WallDeviceZ, "hit depth %f, expected the wall %f", Hit.HitUVz.Z, WallDeviceZ);
+
+			// 深度120 -> 900：到达台阶时已经在墙后60以上，超过厚度，也不会击中背景
+			const FVector3 BehindEnd(0.9f, 0.4f, View.ConvertToDeviceZ(900.0f));
+			const FHiZTraceResult Behind = HiZTrace(MakeTraceInput(HZB, Start, BehindEnd, 10.0f), HZB, View);
+			SSGI_TEST_CHECK(!Behind.bHit, "ray passing behind the thin wall must miss (hit at %f, depth %f)", Behind.HitUVz.X, Behind.bHit ? View.ConvertFromDeviceZ(Behind.HitUVz.Z) : 0.0f);
+
+			// 同一条光线，厚度足够时在台阶处命中
+			const FHiZTraceResult Thick = HiZTrace(MakeTraceInput(HZB, Start, BehindEnd, 200.0f), HZB, View);
+			SSGI_TEST_CHECK(Thick.bHit && std::abs(Thick.HitUVz.X - StepU) < 2.0f / Size.X, "thick wall: hit %d at u %f, expected %f", int(Thick.bHit), Thick.HitUVz.X, StepU);
+		}
+	}
+
+	/**
+	 * Denoise
+	 */
+	void TestDenoiseConstantField()
+	{
+		const FIntPoint Size(61, 37);
+		// 几何可以任意变化，常量颜色的加权平均仍然是常量
+		TImage<FGBufferSample> GBuffer(Size.X, Size.Y);
+		for (int32_t Y = 0; Y < Size.Y; Y++)
+		{
+			for (int32_t X = 0; X < Size.X; X++)
+			{
+				FGBufferSample& Sample = GBuffer(X, Y);
+				Sample.WorldNormal = Normalize(FVector3(HashFloat(uint32_t(X * 3 + Y * 977)) - 0.5f, 0.3f, 1.0f));
+				Sample.LinearDepth = 100.0f + 50.0f * HashFloat(uint32_t(X * 7 + Y * 131));
+				Sample.bValid = HashFloat(uint32_t(X + Y * Size.X)) > 0.1f;
+			}
+		}
+		const FVector3 Color(0.3f, 0.5f, 0.7f);
+		const TImage<FVector3> Input(Size.X, Size.Y, Color);
+
+		for (int32_t StepSize = 1; StepSize <= 8; StepSize *= 2)
+		{
+			TImage<FVector3> Output;
+			DenoiseATrous(Input, GBuffer, StepSize, 1.0f, Output);
+			int32_t NumChanged = 0;
+			for (const FVector3& Value : Output.Data)
+			{
+				// 颜色在groupshared中按half存储
+				NumChanged += NearlyEqual(Value, Color, 1e-3f) ? 0 : 1;
+			}
+			SSGI_TEST_CHECK(NumChanged == 0, "step %d: %d pixels changed a constant field", StepSize, NumChanged);
+		}
+
+		TImage<FVector3> Output;
+		DenoiseSpatial(Input, GBuffer, 4, 1.0f, Output);
+		int32_t NumChanged = 0;
+		for (const FVector3& Value : Output.Data)
+		{
+			NumChanged += NearlyEqual(Value, Color, 1e-3f) ? 0 : 1;
+		}
+		SSGI_TEST_CHECK(NumChanged == 0, "4 iterations: %d pixels changed a constant field", NumChanged);
+	}
+
+	// 左右两半颜色不同，分界处只有深度或只有法线不连续，滤波后两侧的颜色都不应混入对方
+	void TestDenoiseEdges()
+	{
+		const FIntPoint Size(48, 32);
+		const int32_t EdgeX = Size.X / 2;
+		const FVector3 LeftColor(1.0f, 0.0f, 0.0f);
+		const FVector3 RightColor(0.0f, 0.0f, 1.0f);
+		TImage<FVector3> Input(Size.X, Size.Y);
+		for (int32_t Y = 0; Y < Size.Y; Y++)
+		{
+			for (int32_t X = 0; X < Size.X; X++)
+			{
+				Input(X, Y) = X < EdgeX ? LeftColor : RightColor;
+			}
+		}
+
+		struct FCase
+		{
+			const char* Name;
+			FVector3 RightNormal;
+			float RightDepth;
+		};
+		const FCase Cases[] =
+		{
+			{ "depth edge", FVector3(0.0f, 0.0f, 1.0f), 500.0f },
+			{ "normal edge", FVector3(1.0f, 0.0f, 0.0f), 100.0f },
+		};
+		for (const FCase& Case : Cases)
+		{
+			TImage<FGBufferSample> GBuffer = MakeConstantGBuffer(Size, FVector3(0.0f, 0.0f, 1.0f), 100.0f);
+			for (int32_t Y = 0; Y < Size.Y; Y++)
+			{
+				for (int32_t X = EdgeX; X < Size.X; X++)
+				{
+					GBuffer(X, Y).WorldNormal = Case.RightNormal;
+					GBuffer(X, Y).LinearDepth = Case.RightDepth;
+				}
+			}
+
+			TImage<FVector3> Output;
+			DenoiseSpatial(Input, GBuffer, 4, 1.0f, Output);
+			float MaxLeak = 0.0f;
+			for (int32_t Y = 0; Y < Size.Y; Y++)
+			{
+				for (int32_t X = 0; X < Size.X; X++)
+				{
+					const FVector3& Value = Output(X, Y);
+					MaxLeak = std::max(MaxLeak, X < EdgeX ? Value.Z : Value.X);
+				}
+			}
+			SSGI_TEST_CHECK(MaxLeak < 1e-3f, "%s: %f of the other side leaked across", Case.Name, MaxLeak);
+		}
+	}
+
+	/**
+	 * Temporal
+	 */
+	// 棋盘格噪声（均值Mean，幅度±Amplitude，每帧翻转）逐帧累积，历史收敛到均值；累积计数逐帧+1，达到MaxAccumulation后不再增加
+	void TestTemporalConvergence()
+	{
+		const FIntPoint Size(24, 16);
+		const FViewInfo View = MakeTestView(Size);
+		const TImage<FGBufferSample> GBuffer = MakeConstantGBuffer(Size, FVector3(0.0f, 0.0f, 1.0f), 100.0f);
+		const FVector3 Mean(0.5f, 0.4f, 0.3f);
+		const float Amplitude = 0.2f;
+
+		FTemporalSettings Settings;
+		Settings.MaxAccumulation = 16.0f;
+		FTemporalHistory History;
+		TImage<FVector3> Current(Size.X, Size.Y);
+		const int32_t NumFrames = 96;
+		for (int32_t Frame = 0; Frame < NumFrames; Frame++)
+		{
+			for (int32_t Y = 0; Y < Size.Y; Y++)
+			{
+				for (int32_t X = 0; X < Size.X; X++)
+				{
+					const float Sign = ((X + Y + Frame) & 1) ? 1.0f : -1.0f;
+					Current(X, Y) = Mean + FVector3(Amplitude * Sign);
+				}
+			}
+
+			FTemporalHistory NextHistory;
+			TemporalAccumulate(View, Current, GBuffer, nullptr, History, Settings, NextHistory);
+			History = std::move(NextHistory);
+
+			// 累积计数在达到上限前逐帧+1
+			const float ExpectedCount = std::min(float(Frame + 1), Settings.MaxAccumulation);
+			int32_t NumWrongCount = 0;
+			for (const FVector4& Value : History.Color.Data)
+			{
+				NumWrongCount += Value.W != ExpectedCount ? 1 : 0;
+			}
+			SSGI_TEST_CHECK(NumWrongCount == 0, "frame %d: %d pixels with an accumulation count other than %f", Frame, NumWrongCount, ExpectedCount);
+		}
+
+		// 稳态下每帧的残差约为Amplitude / (2 * MaxAccumulation - 1)
+		const float Tolerance = 2.0f * Amplitude / (2.0f * Settings.MaxAccumulation - 1.0f);
+		float MaxError = 0.0f;
+		for (const FVector4& Value : History.Color.Data)
+		{
+			MaxError = std::max(MaxError, std::max(std::abs(Value.X - Mean.X), std::max(std::abs(Value.Y - Mean.Y), std::abs(Value.Z - Mean.Z))));
+		}
+		SSGI_TEST_CHECK(MaxError < Tolerance, "history is %f away from the mean after %d frames, tolerance %f", MaxError, NumFrames, Tolerance);
+	}
+
+	// 常驻线程池：每个像素恰好被一个Tile覆盖，多次调用复用同一组线程
+	void TestParallelForTiles()
+	{
+		SetNumWorkerThreads(4);
+		std::mutex ThreadIdsMutex;
+		std::set<std::thread::id> ThreadIds;
+		const FIntPoint Sizes[] = { FIntPoint(1, 1), FIntPoint(37, 19), FIntPoint(130, 67) };
+		for (int32_t Repeat = 0; Repeat < 50; Repeat++)
+		{
+			for (const FIntPoint& Size : Sizes)
+			{
+				std::vector<std::atomic<int32_t>> Coverage(size_t(Size.X) * Size.Y);
+				ParallelForTiles(Size, 8, [&](const FIntRect& Tile)
+				{
+					for (int32_t Y = Tile.Min.Y; Y < Tile.Max.Y; Y++)
+					{
+						for (int32_t X = Tile.Min.X; X < Tile.Max.X; X++)
+						{
+							Coverage[size_t(Y) * Size.X + X]++;
+						}
+					}
+					std::lock_guard<std::mutex> Lock(ThreadIdsMutex);
+					ThreadIds.insert(std::this_thread::get_id());
+				});
+				int32_t NumWrong = 0;
+				for (const std::atomic<int32_t>& Count : Coverage)
+				{
+					NumWrong += Count != 1 ? 1 : 0;
+				}
+				SSGI_TEST_CHECK(NumWrong == 0, "%dx%d: %d pixels not covered exactly once", Size.X, Size.Y, NumWrong);
+			}
+		}
+		SSGI_TEST_CHECK(ThreadIds.size() <= 4, "%d distinct threads ran tiles, expected at most 4", int32_t(ThreadIds.size()));
+		SetNumWorkerThreads(0);
+	}
+
+	struct FTestCase
+	{
+		const char* Name;
+		void (*Function)();
+	};
+
+	const FTestCase GTestCases[] =
+	{
+		{ "HZBReduction", &TestHZBReduction },
+		{ "HZBCompactConservative", &TestHZBCompactConservative },
+		{ "HiZTrace", &TestHiZTrace },
+		{ "DenoiseConstantField", &TestDenoiseConstantField },
+		{ "DenoiseEdges", &TestDenoiseEdges },
+		{ "TemporalConvergence", &TestTemporalConvergence },
+		{ "ParallelForTiles", &TestParallelForTiles },
+	};
+}
+
+// 不带参数时运行所有用例，否则只运行名字匹配的用例
+int main(int Argc, char** Argv)
+{
+	int32_t NumRun = 0;
+	for (const FTestCase& TestCase : GTestCases)
+	{
+		if (Argc > 1 && std::strcmp(Argv[1], TestCase.Name) != 0)
+		{
+			continue;
+		}
+		const int32_t FailuresBefore = GNumFailures;
+		TestCase.Function();
+		std::printf("[%s] %s\n", GNumFailures == FailuresBefore ? "PASS" : "FAIL", TestCase.Name);
+		NumRun++;
+	}
+	if (NumRun == 0)
+	{
+		std::printf("No test named %s\n", Argv[1]);
+		return 1;
+	}
+	return GNumFailures == 0 ? 0 : 1;
+}